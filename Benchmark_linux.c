@@ -0,0 +1,1073 @@
+/*
+    Benchmarks of the hot paths, from single functions up to whole frames of
+    Main driven by a script of key presses, with the terminal replaced by a
+    sink that throws the output away.
+
+    Usage: Benchmark [--baseline path] [--threshold percent]
+
+    The results are written to standard output as JSON. Given the JSON of an
+    earlier run as a baseline, each result is compared against it as well, and
+    the benchmark fails if any is slower by more than the threshold (10% unless
+    given).
+*/
+
+#define _GNU_SOURCE
+
+#include <sys/socket.h>
+
+#define ONTOLOGIC_NO_MAIN
+#include "Main_linux.c"
+
+/*
+    BEGIN BENCHMARK
+*/
+
+/* Each benchmark is repeated until a round takes at least this long. */
+#define BENCHMARK_MIN_ROUND_DURATION 10000000
+/* The fastest of this many rounds is taken, as the least disturbed. */
+#define BENCHMARK_ROUND_COUNT 5
+#define BENCHMARK_MAX_RESULT_COUNT 16
+
+#define BENCHMARK_CONSOLE_WIDTH 120
+#define BENCHMARK_CONSOLE_HEIGHT 40
+
+/**
+ * Runs the operation being benchmarked the given number of times.
+ *
+ * @param[in|out]	state			Whatever the benchmark set up for itself.
+ * @param[in]		operationCount	How many times to run the operation.
+ *
+ * @return	How long the operations took, in nanoseconds.
+ */
+typedef u64 benchmark_procedure(void* state, u64 operationCount);
+
+typedef struct benchmark_result
+{
+    const char* Name;
+    u64 OperationCount;
+    /* Picoseconds, so that the quickest operations keep a fraction. */
+    u64 PicosecondsPerOperation;
+    /* The bytes sent to the terminal per frame, or 0 if none are. */
+    u64 BytesPerFrame;
+}
+benchmark_result;
+
+/* Anything written here is kept, so the work producing it can't be skipped. */
+global volatile u64 BenchmarkSink;
+
+/**
+ * Times an operation, running it in rounds long enough for the clock to
+ * measure well.
+ *
+ * @param[in]		name		The name of the benchmark.
+ * @param[in]		procedure	The procedure that runs the operation.
+ * @param[in|out]	state		The state to pass to the procedure.
+ *
+ * @return	The time taken by the operation in the fastest round.
+ */
+internal benchmark_result RunBenchmark(
+    const char* name,
+    benchmark_procedure* procedure,
+    void* state
+)
+{
+    u64 operationCount = 1;
+
+    until (BENCHMARK_MIN_ROUND_DURATION <= procedure(state, operationCount))
+        operationCount *= 2;
+
+    u64 fastest = (u64)-1;
+    for (size round = 0; round < BENCHMARK_ROUND_COUNT; round++)
+    {
+        u64 duration = procedure(state, operationCount);
+        if (duration < fastest)
+            fastest = duration;
+    }
+
+    return (benchmark_result){
+        .Name = name,
+        .OperationCount = operationCount,
+        .PicosecondsPerOperation = fastest * 1000 / operationCount,
+        .BytesPerFrame = 0,
+    };
+}
+
+internal u64 BenchmarkItoA(void* state, u64 operationCount)
+{
+    (void)state;
+
+    char buffer[16];
+    u64 length = 0;
+
+    u64 start = ReadClock();
+
+    /* Spread across every magnitude, negatives included. */
+    for (u64 i = 0; i < operationCount; i++)
+        length += ItoA(buffer, sizeof(buffer), (i32)(i * 2654435761u));
+
+    u64 duration = ReadClock() - start;
+
+    BenchmarkSink = length;
+    return duration;
+}
+
+internal u64 BenchmarkFormatString(void* state, u64 operationCount)
+{
+    (void)state;
+
+    char buffer[128];
+    char format[] = "Line %u of %u, column %i: \"%s\"";
+    u64 length = 0;
+
+    u64 start = ReadClock();
+
+    for (u64 i = 0; i < operationCount; i++)
+    {
+        length += FormatString(
+            buffer, sizeof(buffer),
+            format, sizeof(format) - 1,
+            i, operationCount, (i32)(i % 80), "The quick brown fox"
+        );
+    }
+
+    u64 duration = ReadClock() - start;
+
+    BenchmarkSink = length;
+    return duration;
+}
+
+internal u64 BenchmarkAllocate(void* state, u64 operationCount)
+{
+    (void)state;
+
+    memory_arena* arena = GetGlobalMemoryArena();
+    temporary_memory allocations = BeginTemporaryMemory(arena);
+
+    u64 start = ReadClock();
+
+    /* Freed every so often, so the arena doesn't grow for the whole round. */
+    for (u64 i = 0; i < operationCount; i++)
+    {
+        if (i % 4096 == 0)
+        {
+            EndTemporaryMemory(allocations);
+            allocations = BeginTemporaryMemory(arena);
+        }
+
+        BenchmarkSink = (u64)Allocate(64);
+    }
+
+    u64 duration = ReadClock() - start;
+
+    EndTemporaryMemory(allocations);
+    return duration;
+}
+
+internal u64 BenchmarkConsoleWrite(void* state, u64 operationCount)
+{
+    console* console = state;
+
+    string line = StringLiteral(
+        "The quick brown fox jumps over the lazy dog, "
+        "and the lazy dog sleeps on through all of it, "
+        "unmoved."
+    );
+
+    u64 start = ReadClock();
+
+    for (u64 i = 0; i < operationCount; i++)
+    {
+        console->CursorTop = i % console->BufferHeight;
+        console->CursorLeft = 0;
+
+        ConsoleWrite(console, line.Data, line.Length);
+    }
+
+    return ReadClock() - start;
+}
+
+/**
+ * Fills every row of a console with text, starting from a different place in
+ * it depending on the pattern, so that consecutive patterns differ in every
+ * cell.
+ *
+ * @param[in|out]	console	The console to fill.
+ * @param[in]		pattern	Which pattern to fill it with.
+ */
+internal void FillBenchmarkConsole(console* console, u64 pattern)
+{
+    string text = StringLiteral(
+        "Pack my box with five dozen liquor jugs. "
+        "How vexingly quick daft zebras jump! "
+    );
+
+    ClearConsole(console);
+
+    for (size y = 0; y < console->BufferHeight; y++)
+    {
+        size offset = (y + pattern) % text.Length;
+
+        console->CursorTop = y;
+        console->CursorLeft = 0;
+
+        until (console->BufferWidth <= (size)console->CursorLeft)
+        {
+            i32 written = ConsoleWrite(
+                console, &text.Data[offset], text.Length - offset
+            );
+
+            console->CursorLeft += written;
+            offset = 0;
+        }
+
+        /* Every other row is colored, so styles change along the way. */
+        if (y % 2 == pattern % 2)
+        {
+            MemoryFill(
+                &console->Cells.Foregrounds[y * console->BufferWidth],
+                CONSOLE_COLOR_YELLOW,
+                console->BufferWidth
+            );
+        }
+    }
+}
+
+internal u64 BenchmarkClearConsole(void* state, u64 operationCount)
+{
+    console* console = state;
+
+    /* A blank console is skipped over, so each clear has something to clear. */
+    u64 duration = 0;
+    for (u64 i = 0; i < operationCount; i++)
+    {
+        FillBenchmarkConsole(console, i);
+
+        u64 start = ReadClock();
+        ClearConsole(console);
+        duration += ReadClock() - start;
+    }
+
+    return duration;
+}
+
+/* The length of the text each edit inserts, and then deletes elsewhere. */
+#define BENCHMARK_EDIT_LENGTH 8
+
+internal u64 BenchmarkDocumentEdit(void* state, u64 operationCount)
+{
+    (void)state;
+
+    memory_arena* arena = GetGlobalMemoryArena();
+    temporary_memory documentMemory = BeginTemporaryMemory(arena);
+
+    /* A fresh document each time, so that every round edits the same one. */
+    document document;
+    SetupDocument(&document, arena);
+
+    string text = StringLiteral(
+        "The quick brown fox jumps over the lazy dog.\n"
+    );
+    for (size i = 0; i < Kilobyte(16); i++)
+    {
+        DocumentInsert(
+            &document, DocumentLength(&document), text.Data, text.Length
+        );
+    }
+
+    u64 start = ReadClock();
+
+    /* The length stays the same, while the pieces are split up over time. */
+    for (u64 i = 0; i < operationCount; i++)
+    {
+        size length = DocumentLength(&document) - BENCHMARK_EDIT_LENGTH;
+
+        DocumentInsert(
+            &document,
+            (i * 2654435761u) % length,
+            text.Data, BENCHMARK_EDIT_LENGTH
+        );
+        DocumentDelete(
+            &document,
+            (i * 40503u + 12345) % length,
+            BENCHMARK_EDIT_LENGTH
+        );
+    }
+
+    u64 duration = ReadClock() - start;
+
+    BenchmarkSink = DocumentLength(&document);
+
+    EndTemporaryMemory(documentMemory);
+    return duration;
+}
+
+typedef struct blit_benchmark
+{
+    console* Console;
+    u64 BytesSent;
+    u64 FrameCount;
+}
+blit_benchmark;
+
+internal u64 BenchmarkBlitConsole(void* state, u64 operationCount)
+{
+    blit_benchmark* benchmark = state;
+    console* console = benchmark->Console;
+
+    /* Blitting a frame updates the front buffer with it, so they alternate. */
+    u64 duration = 0;
+    for (u64 i = 0; i < operationCount; i++)
+    {
+        FillBenchmarkConsole(console, i);
+
+        u64 start = ReadClock();
+        size bytesSent = BlitConsoleFrame(console, &console->Frames[0]);
+        duration += ReadClock() - start;
+
+        benchmark->BytesSent += bytesSent;
+        benchmark->FrameCount++;
+    }
+
+    return duration;
+}
+
+internal u64 BenchmarkInputRing(void* state, u64 operationCount)
+{
+    input_buffer* inputBuffer = state;
+
+    input_event event = {
+        .Key = KEY_A,
+        .KeyDown = true,
+        .Character = 'a',
+    };
+
+    u64 start = ReadClock();
+
+    /* Half full, so the indices wrap around the ring as they go. */
+    for (u64 i = 0; i < operationCount; i++)
+    {
+        PushInputEventTo(inputBuffer, &event);
+        PopInputEventFrom(inputBuffer, &event);
+    }
+
+    u64 duration = ReadClock() - start;
+
+    BenchmarkSink = event.Character;
+    return duration;
+}
+
+/*
+    The keys pressed over a run of Main once the lines have been typed out:
+    scrolling about, searching, and toggling the overlays, before escape quits.
+*/
+#define BENCHMARK_KEYS \
+    _("\x1b[5~") _("\x1b[B") _("\x1b[B") _("\x1b[6~") \
+    _("\x06") _("f") _("o") _("x") \
+    _("\x06") _("\x06") _("\x06") _("\x06") _("\x06") _("\x06") _("\x06") \
+    _("\r") \
+    _("\x1b[15~") _("\x1bOQ") \
+    _("h") _("e") _("l") _("l") _("o") _("\x7f") _("\x7f") \
+    _("\x1bOQ") _("\x1b[15~") \
+    _("\x1b")
+
+global const string BenchmarkKeys[] = {
+#define _(KEY) { KEY, sizeof(KEY) - 1 },
+    BENCHMARK_KEYS
+#undef _
+};
+
+/* The words the typed lines are made of. */
+#define BENCHMARK_WORDS \
+    _("the") _("quick") _("brown") _("fox") _("jumps") _("over") _("lazy") \
+    _("dog") _("pack") _("my") _("box") _("with") _("five") _("dozen") \
+    _("liquor") _("jugs")
+
+global const string BenchmarkWords[] = {
+#define _(WORD) { WORD, sizeof(WORD) - 1 },
+    BENCHMARK_WORDS
+#undef _
+};
+
+/* How many lines are typed out before the keys above are pressed. */
+#define BENCHMARK_TYPED_LINE_COUNT 100
+
+typedef struct main_benchmark
+{
+    /* Where the keys are sent, one message per key, and Main's end. */
+    i32 InputSocket;
+    i32 InputReadEnd;
+
+    /* Where the frames are read from, as they are blitted. */
+    i32 OutputReadEnd;
+    volatile u64 BytesSent;
+
+    /* Set once Main has quit, so that no more keys are pressed. */
+    volatile bool Stopped;
+
+    /* The processor time the threads standing in for the terminal took. */
+    u64 KeyProcessorTime;
+    u64 DrainProcessorTime;
+}
+main_benchmark;
+
+/**
+ * Reads the processor time taken so far by the process or the calling thread.
+ *
+ * @param[in]	clock	CLOCK_PROCESS_CPUTIME_ID or CLOCK_THREAD_CPUTIME_ID.
+ *
+ * @return	The processor time, in nanoseconds.
+ */
+internal u64 ReadProcessorClock(clockid_t clock)
+{
+    struct timespec time;
+    clock_gettime(clock, &time);
+
+    return (u64)time.tv_sec * 1000000000 + (u64)time.tv_nsec;
+}
+
+/**
+ * Sends a key press to Main once it has read the last one, so that each is
+ * drawn in a frame of its own, as when typed.
+ *
+ * @param[in]	benchmark	The benchmark to press the key in.
+ * @param[in]	key			The bytes the terminal would send for the key.
+ *
+ * @return	True if the key was sent, false if Main has quit.
+ */
+internal bool PressBenchmarkKey(main_benchmark* benchmark, string key)
+{
+    i32 unread;
+    while (
+        !benchmark->Stopped
+        && ioctl(benchmark->InputReadEnd, FIONREAD, &unread) == 0
+        && 0 < unread
+    )
+        sched_yield();
+
+    if (benchmark->Stopped)
+        return false;
+
+    ssize_t bytesSent;
+    do
+        bytesSent = send(
+            benchmark->InputSocket, key.Data, key.Length, MSG_NOSIGNAL
+        );
+    while (bytesSent < 0 && errno == EINTR);
+
+    return bytesSent == (ssize_t)key.Length;
+}
+
+/**
+ * Presses the scripted keys, one after the other: a page of lines, each made
+ * of different words so that scrolling changes every row, and then the rest.
+ *
+ * @param[in]	benchmark	The benchmark to press the keys in.
+ */
+internal void PressBenchmarkScript(main_benchmark* benchmark)
+{
+    /* xorshift32, so every run types the same lines. */
+    u32 random = 0x2545f491;
+
+    for (size i = 0; i < BENCHMARK_TYPED_LINE_COUNT; i++)
+    {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+
+        size wordCount = 2 + random % 16;
+        u32 words = random;
+
+        for (size j = 0; j < wordCount; j++)
+        {
+            string word = BenchmarkWords[
+                (words + j * 7) % ArrayCount(BenchmarkWords)
+            ];
+            words = words * 1664525 + 1013904223;
+
+            for (size k = 0; k < word.Length; k++)
+            {
+                if (!PressBenchmarkKey(benchmark, MakeString(&word.Data[k], 1)))
+                    return;
+            }
+
+            if (!PressBenchmarkKey(benchmark, StringLiteral(" ")))
+                return;
+        }
+
+        if (!PressBenchmarkKey(benchmark, StringLiteral("\r")))
+            return;
+    }
+
+    for (size i = 0; i < ArrayCount(BenchmarkKeys); i++)
+    {
+        if (!PressBenchmarkKey(benchmark, BenchmarkKeys[i]))
+            return;
+    }
+}
+
+/**
+ * Presses the scripted keys, noting the processor time spent waiting to press
+ * them, as it is no part of Main's.
+ *
+ * @param[in|out]	parameter	The main_benchmark to press the keys in.
+ */
+internal void PressBenchmarkKeys(void* parameter)
+{
+    main_benchmark* benchmark = parameter;
+
+    PressBenchmarkScript(benchmark);
+    benchmark->KeyProcessorTime = ReadProcessorClock(CLOCK_THREAD_CPUTIME_ID);
+}
+
+/**
+ * Reads and discards whatever is blitted, counting the bytes, until the write
+ * end is closed, then notes the processor time that took.
+ *
+ * @param[in|out]	parameter	The main_benchmark to read the frames of.
+ */
+internal void DrainBenchmarkOutput(void* parameter)
+{
+    main_benchmark* benchmark = parameter;
+
+    char buffer[Kilobyte(64)];
+    ssize_t bytesRead;
+
+    while (
+        0 < (bytesRead = read(benchmark->OutputReadEnd, buffer, sizeof(buffer)))
+        || (bytesRead < 0 && errno == EINTR)
+    )
+    {
+        if (0 < bytesRead)
+            benchmark->BytesSent += bytesRead;
+    }
+
+    benchmark->DrainProcessorTime =
+        ReadProcessorClock(CLOCK_THREAD_CPUTIME_ID);
+}
+
+/**
+ * Runs Main until the scripted keys quit it, with the keys read from a socket
+ * that keeps each one a message of its own, and the frames written to a pipe.
+ *
+ * Only the processor time of Main, its output thread and its workers is
+ * counted, so a frame costs what it would if typed, without the time Main
+ * sits waiting for the next key or the threads sending and reading them.
+ *
+ * @return	The processor time taken per frame presented, and the bytes
+ *			blitted per frame.
+ */
+internal benchmark_result BenchmarkMain(void)
+{
+    u64 fastest = (u64)-1;
+    u64 frameCount = 0;
+    u64 bytesSent = 0;
+
+    i32 standardInput = Platform.StandardInput;
+    i32 standardOutput = Platform.StandardOutput;
+
+    for (size round = 0; round < BENCHMARK_ROUND_COUNT; round++)
+    {
+        i32 inputSockets[2];
+        i32 outputPipe[2];
+
+        if (
+            socketpair(
+                AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, inputSockets
+            ) != 0
+            || pipe2(outputPipe, O_CLOEXEC) != 0
+        )
+        {
+            Abort(
+                EXIT_COULD_NOT_CREATE_WAKEUP_HANDLE,
+                "Unable to create the pipes Main is benchmarked with."
+            );
+        }
+
+        /* Main reads whatever is there, and waits when there is nothing. */
+        fcntl(inputSockets[0], F_SETFL, O_NONBLOCK);
+
+        main_benchmark benchmark = {
+            .InputSocket = inputSockets[1],
+            .InputReadEnd = inputSockets[0],
+            .OutputReadEnd = outputPipe[0],
+        };
+
+        Platform.StandardInput = inputSockets[0];
+        Platform.StandardOutput = outputPipe[1];
+        Platform.PendingInputLength = 0;
+
+        temporary_memory roundMemory =
+            BeginTemporaryMemory(GetGlobalMemoryArena());
+
+        console c;
+        SetupConsole(&c, BENCHMARK_CONSOLE_WIDTH, BENCHMARK_CONSOLE_HEIGHT);
+
+        input_buffer inputBuffer;
+        SetupInputBuffer(&inputBuffer);
+
+        thread drainThread;
+        thread keyThread;
+
+        /* The threads are counted from their start, so counting starts here. */
+        u64 start = ReadProcessorClock(CLOCK_PROCESS_CPUTIME_ID);
+
+        if (
+            !StartThread(&drainThread, DrainBenchmarkOutput, &benchmark)
+            || !StartThread(&keyThread, PressBenchmarkKeys, &benchmark)
+        )
+        {
+            Abort(
+                EXIT_COULD_NOT_START_THREAD,
+                "Unable to start the threads Main is benchmarked with."
+            );
+        }
+
+        StartConsoleOutput(&c);
+
+        char* arguments[] = { "Benchmark", NULL };
+        Main(&c, &inputBuffer, &FrameArena, 1, arguments);
+        StopConsoleOutput();
+
+        /* Should Main quit early, the keys left aren't pressed. */
+        benchmark.Stopped = true;
+        JoinThread(&keyThread);
+
+        close(outputPipe[1]);
+        JoinThread(&drainThread);
+
+        u64 duration = ReadProcessorClock(CLOCK_PROCESS_CPUTIME_ID) - start
+            - benchmark.KeyProcessorTime - benchmark.DrainProcessorTime;
+
+        close(outputPipe[0]);
+        close(inputSockets[0]);
+        close(inputSockets[1]);
+
+        EndTemporaryMemory(roundMemory);
+        ResetMemoryArena(&FrameArena);
+
+        if (c.PresentedFrameCount == 0)
+            continue;
+
+        u64 durationPerFrame = duration / c.PresentedFrameCount;
+        if (durationPerFrame < fastest)
+        {
+            fastest = durationPerFrame;
+            frameCount = c.PresentedFrameCount;
+            bytesSent = benchmark.BytesSent;
+        }
+    }
+
+    Platform.StandardInput = standardInput;
+    Platform.StandardOutput = standardOutput;
+
+    return (benchmark_result){
+        .Name = "Main",
+        .OperationCount = frameCount,
+        .PicosecondsPerOperation = fastest * 1000,
+        .BytesPerFrame = frameCount != 0 ? bytesSent / frameCount : 0,
+    };
+}
+
+/**
+ * Reads a number with up to three decimal places as thousandths.
+ *
+ * @param[in]	text		The text to read the number from.
+ * @param[in]	textLength	The length of the text.
+ *
+ * @return	The number, in thousandths.
+ */
+internal u64 ParseBenchmarkThousandths(const char* text, size textLength)
+{
+    u64 whole = 0;
+    size i = 0;
+
+    for (; i < textLength && '0' <= text[i] && text[i] <= '9'; i++)
+        whole = whole * 10 + (text[i] - '0');
+
+    u64 fraction = 0;
+    size fractionDigits = 0;
+
+    if (i < textLength && text[i] == '.')
+    {
+        for (i++; i < textLength && '0' <= text[i] && text[i] <= '9'; i++)
+        {
+            if (fractionDigits < 3)
+            {
+                fraction = fraction * 10 + (text[i] - '0');
+                fractionDigits++;
+            }
+        }
+    }
+
+    for (; fractionDigits < 3; fractionDigits++)
+        fraction *= 10;
+
+    return whole * 1000 + fraction;
+}
+
+/**
+ * Finds a result in the JSON of an earlier run.
+ *
+ * @param[in]	baseline		The JSON of the earlier run.
+ * @param[in]	baselineSize	The size of the JSON.
+ * @param[in]	name			The name of the benchmark to find.
+ * @param[out]	picoseconds		The time the benchmark took per operation.
+ *
+ * @return	True if the benchmark was found, false if not.
+ */
+internal bool FindBaselineResult(
+    const char* baseline,
+    size baselineSize,
+    const char* name,
+    u64* picoseconds
+)
+{
+    char key[128];
+    char keyFormat[] = "\"name\":\"%s\"";
+    size keyLength = FormatString(
+        key, sizeof(key), keyFormat, sizeof(keyFormat) - 1, name
+    );
+
+    size start = SearchForward(baseline, baselineSize, key, keyLength);
+    if (start == SEARCH_NOT_FOUND)
+        return false;
+
+    start += keyLength;
+
+    /* The result ends where the next one begins. */
+    size end = start + SearchForward(
+        &baseline[start], baselineSize - start, "}", 1
+    );
+    if (baselineSize < end)
+        end = baselineSize;
+
+    string field = StringLiteral("\"ns_per_op\":");
+    size fieldStart = SearchForward(
+        &baseline[start], end - start, field.Data, field.Length
+    );
+    if (fieldStart == SEARCH_NOT_FOUND)
+        return false;
+
+    fieldStart += start + field.Length;
+
+    *picoseconds = ParseBenchmarkThousandths(
+        &baseline[fieldStart], end - fieldStart
+    );
+
+    return true;
+}
+
+/**
+ * Formats the results as JSON, compared against the baseline if there is one.
+ *
+ * @param[in|out]	builder			The builder to append the JSON to.
+ * @param[in|out]	comparison		The builder to append a summary of the
+ *									comparison to, for people to read.
+ * @param[in]		results			The results to format.
+ * @param[in]		resultCount		The number of results.
+ * @param[in]		baseline		The JSON of an earlier run, or NULL.
+ * @param[in]		baselineSize	The size of the JSON.
+ * @param[in]		threshold		How many percent slower than the baseline a
+ *									result can be before it counts as a
+ *									regression.
+ *
+ * @return	The number of results that regressed.
+ */
+internal size FormatBenchmarkResults(
+    string_builder* builder,
+    string_builder* comparison,
+    const benchmark_result* results,
+    size resultCount,
+    const char* baseline,
+    size baselineSize,
+    u64 threshold
+)
+{
+    size regressionCount = 0;
+
+    string header = StringLiteral("{\"benchmarks\":[\n");
+    StringBuilderAppend(builder, header.Data, header.Length);
+
+    char resultFormat[] =
+        "{\"name\":\"%s\",\"operations\":%u,\"ns_per_op\":%u.%03u,"
+        "\"bytes_per_frame\":%u";
+    format_descriptor resultDescriptor;
+    ParseFormat(&resultDescriptor, resultFormat, sizeof(resultFormat) - 1);
+
+    char baselineFormat[] =
+        ",\"baseline_ns_per_op\":%u.%03u,\"change_percent\":%s%u.%u";
+    format_descriptor baselineDescriptor;
+    ParseFormat(
+        &baselineDescriptor, baselineFormat, sizeof(baselineFormat) - 1
+    );
+
+    char comparisonFormat[] = "%s: %u.%03u ns -> %u.%03u ns (%s%u.%u%%)%s\n";
+    format_descriptor comparisonDescriptor;
+    ParseFormat(
+        &comparisonDescriptor, comparisonFormat, sizeof(comparisonFormat) - 1
+    );
+
+    for (size i = 0; i < resultCount; i++)
+    {
+        const benchmark_result* result = &results[i];
+        u64 picoseconds = result->PicosecondsPerOperation;
+
+        StringBuilderAppendParsed(
+            builder,
+            &resultDescriptor,
+            result->Name,
+            result->OperationCount,
+            picoseconds / 1000, picoseconds % 1000,
+            result->BytesPerFrame
+        );
+
+        u64 baselinePicoseconds;
+        if (
+            baseline != NULL
+            && FindBaselineResult(
+                baseline, baselineSize, result->Name, &baselinePicoseconds
+            )
+            && baselinePicoseconds != 0
+        )
+        {
+            /* The change is in tenths of a percent, and may be negative. */
+            bool slower = baselinePicoseconds < picoseconds;
+            u64 difference = slower
+                ? picoseconds - baselinePicoseconds
+                : baselinePicoseconds - picoseconds;
+            u64 change = difference * 1000 / baselinePicoseconds;
+            const char* sign = slower || change == 0 ? "" : "-";
+
+            bool regressed = slower && threshold * 10 < change;
+            if (regressed)
+                regressionCount++;
+
+            StringBuilderAppendParsed(
+                builder,
+                &baselineDescriptor,
+                baselinePicoseconds / 1000, baselinePicoseconds % 1000,
+                sign, change / 10, change % 10
+            );
+
+            StringBuilderAppendParsed(
+                comparison,
+                &comparisonDescriptor,
+                result->Name,
+                baselinePicoseconds / 1000, baselinePicoseconds % 1000,
+                picoseconds / 1000, picoseconds % 1000,
+                sign, change / 10, change % 10,
+                regressed ? " regressed" : ""
+            );
+        }
+
+        string end = i + 1 < resultCount
+            ? StringLiteral("},\n")
+            : StringLiteral("}\n");
+        StringBuilderAppend(builder, end.Data, end.Length);
+    }
+
+    string footer = StringLiteral("]}\n");
+    StringBuilderAppend(builder, footer.Data, footer.Length);
+
+    return regressionCount;
+}
+
+/**
+ * Checks whether a command line argument is the given option.
+ *
+ * @param[in]	argument	The argument to check.
+ * @param[in]	option		The option to check for.
+ *
+ * @return	True if they are the same, false if not.
+ */
+internal bool IsBenchmarkOption(const char* argument, const char* option)
+{
+    size i = 0;
+    while (argument[i] != '\0' && argument[i] == option[i])
+        i++;
+
+    return argument[i] == option[i];
+}
+
+i32 main(i32 argumentCount, char** arguments)
+{
+    Platform = (struct platform)
+    {
+        .StandardOutput = open("/dev/null", O_WRONLY | O_CLOEXEC),
+        .StandardError = STDERR_FILENO,
+        .StandardInput = -1,
+    };
+
+    const char* baselinePath = NULL;
+    u64 threshold = 10;
+
+    for (i32 i = 1; i < argumentCount; i++)
+    {
+        if (IsBenchmarkOption(arguments[i], "--baseline")
+            && i + 1 < argumentCount)
+            baselinePath = arguments[++i];
+
+        else if (IsBenchmarkOption(arguments[i], "--threshold")
+            && i + 1 < argumentCount)
+        {
+            const char* percent = arguments[++i];
+
+            size length = 0;
+            while (percent[length] != '\0')
+                length++;
+
+            threshold = ParseBenchmarkThousandths(percent, length) / 1000;
+        }
+
+        else
+        {
+            char usage[] =
+                "Usage: Benchmark [--baseline path] [--threshold percent]\n";
+            WriteAll(STDERR_FILENO, usage, sizeof(usage) - 1);
+
+            return EXIT_NORMAL + 1;
+        }
+    }
+
+    if (Platform.StandardOutput < 0)
+    {
+        Abort(
+            EXIT_COULD_NOT_SET_ACTIVE_SCREEN_BUFFER,
+            "Unable to open /dev/null to blit to."
+        );
+    }
+
+    i32 wakePipe[2];
+    if (pipe2(wakePipe, O_NONBLOCK | O_CLOEXEC) != 0)
+    {
+        Abort(
+            EXIT_COULD_NOT_CREATE_WAKEUP_HANDLE,
+            "Unable to create the pipe used to wake the main loop."
+        );
+    }
+
+    Platform.WakeReadEnd = wakePipe[0];
+    Platform.WakeWriteEnd = wakePipe[1];
+
+    SetupMemoryArena(
+        &MemoryArena,
+        DEFAULT_ARENA_RESERVE_SIZE,
+        ARENA_FLAGS_NONE
+    );
+
+    SetupMemoryArena(&FrameArena, Megabyte(256), ARENA_FLAGS_NONE);
+
+    benchmark_result results[BENCHMARK_MAX_RESULT_COUNT];
+    size resultCount = 0;
+
+    results[resultCount++] = RunBenchmark("ItoA", BenchmarkItoA, NULL);
+    results[resultCount++] = RunBenchmark(
+        "FormatString", BenchmarkFormatString, NULL
+    );
+    results[resultCount++] = RunBenchmark(
+        "Allocate", BenchmarkAllocate, NULL
+    );
+
+    results[resultCount++] = RunBenchmark(
+        "DocumentEdit", BenchmarkDocumentEdit, NULL
+    );
+
+    /* The console is never presented, so it is only ever drawn in here. */
+    console c;
+    SetupConsole(&c, BENCHMARK_CONSOLE_WIDTH, BENCHMARK_CONSOLE_HEIGHT);
+
+    results[resultCount++] = RunBenchmark(
+        "ClearConsole", BenchmarkClearConsole, &c
+    );
+    results[resultCount++] = RunBenchmark(
+        "ConsoleWrite", BenchmarkConsoleWrite, &c
+    );
+
+    blit_benchmark blit = { .Console = &c, .BytesSent = 0, .FrameCount = 0 };
+    results[resultCount] = RunBenchmark(
+        "BlitConsole", BenchmarkBlitConsole, &blit
+    );
+    results[resultCount++].BytesPerFrame = blit.BytesSent / blit.FrameCount;
+
+    input_buffer inputBuffer;
+    SetupInputBuffer(&inputBuffer);
+
+    input_event padding = { .Key = KEY_NONE };
+    for (size i = 0; i < INPUT_BUFFER_SIZE / 2; i++)
+        PushInputEventTo(&inputBuffer, &padding);
+
+    results[resultCount++] = RunBenchmark(
+        "InputRing", BenchmarkInputRing, &inputBuffer
+    );
+
+    results[resultCount++] = BenchmarkMain();
+
+    /* Compare against the baseline, if given. */
+    file baseline = { .Data = NULL, .Size = 0 };
+    bool baselineOpen = false;
+
+    if (baselinePath != NULL)
+    {
+        baselineOpen = OpenReadOnlyFile(&baseline, baselinePath);
+
+        /* It is searched through in place, so it has to have been mapped. */
+        if (baselineOpen && baseline.Data == NULL)
+        {
+            CloseReadOnlyFile(&baseline);
+            baselineOpen = false;
+        }
+
+        if (!baselineOpen)
+        {
+            char format[] = "Could not read the baseline \"%s\".\n";
+            char message[1024];
+            size messageLength = FormatString(
+                message, sizeof(message),
+                format, sizeof(format) - 1,
+                baselinePath
+            );
+
+            WriteAll(STDERR_FILENO, message, messageLength);
+        }
+    }
+
+    string_builder json;
+    SetupStringBuilder(&json, &FrameArena, Kilobyte(4), ALLOCATION_TAG_SCRATCH);
+
+    string_builder comparison;
+    SetupStringBuilder(
+        &comparison, &FrameArena, Kilobyte(1), ALLOCATION_TAG_SCRATCH
+    );
+
+    size regressionCount = FormatBenchmarkResults(
+        &json,
+        &comparison,
+        results,
+        resultCount,
+        baselineOpen ? baseline.Data : NULL,
+        baselineOpen ? baseline.Size : 0,
+        threshold
+    );
+
+    WriteAll(STDOUT_FILENO, json.Data, json.Length);
+    WriteAll(STDERR_FILENO, comparison.Data, comparison.Length);
+
+    if (baselineOpen)
+        CloseReadOnlyFile(&baseline);
+
+    TeardownMemoryArena(&FrameArena);
+    TeardownMemoryArena(&MemoryArena);
+
+    close(Platform.StandardOutput);
+    close(Platform.WakeReadEnd);
+    close(Platform.WakeWriteEnd);
+
+    /* Failing on a regression lets a build script stop on it. */
+    return baselinePath != NULL && (!baselineOpen || 0 < regressionCount)
+        ? EXIT_NORMAL + 1
+        : EXIT_NORMAL;
+}
+
+/*
+    END BENCHMARK
+*/
@@ -0,0 +1,128 @@
+#ifndef __ONTOLOGIC_CPU_H__
+#define __ONTOLOGIC_CPU_H__
+
+#include "Standard.h"
+
+#if defined(__x86_64__) || defined(__i386__) \
+    || defined(_M_X64) || defined(_M_IX86)
+    #define CPU_X86
+
+    #include <immintrin.h>
+
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+/*
+    BEGIN CPU
+*/
+
+/*
+    On x86 the vector routines are compiled for instruction sets the compiler
+    isn't told to assume, and only called once cpuid says they are supported.
+    MSVC allows any intrinsic anywhere, so it needs no annotation.
+*/
+#if defined(CPU_X86) && defined(__GNUC__)
+    #define CPU_TARGET_SSE2 __attribute__((target("sse2")))
+    #define CPU_TARGET_SSSE3 __attribute__((target("ssse3")))
+    #define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define CPU_TARGET_SSE2
+    #define CPU_TARGET_SSSE3
+    #define CPU_TARGET_AVX2
+#endif
+
+/*
+    The instruction sets vector routines can be run with, from slowest to
+    fastest. Each level includes every level before it.
+*/
+typedef enum cpu_level
+{
+    CPU_LEVEL_SCALAR,
+    CPU_LEVEL_SSE2,
+    CPU_LEVEL_SSSE3,
+    CPU_LEVEL_AVX2,
+}
+cpu_level;
+
+#if defined(CPU_X86)
+
+/**
+ * Asks the processor, and the operating system, which instruction sets can be
+ * used.
+ *
+ * @return	The fastest instruction set that can be used.
+ */
+internal cpu_level DetectCpuLevel(void)
+{
+    u32 registers[4] = { 0 };
+
+#if defined(_MSC_VER)
+    __cpuid((int*)registers, 0);
+#else
+    __get_cpuid(0, &registers[0], &registers[1], &registers[2], &registers[3]);
+#endif
+    u32 maxLeaf = registers[0];
+
+    if (maxLeaf < 1)
+        return CPU_LEVEL_SCALAR;
+
+#if defined(_MSC_VER)
+    __cpuid((int*)registers, 1);
+#else
+    __get_cpuid(1, &registers[0], &registers[1], &registers[2], &registers[3]);
+#endif
+    bool hasSse2 = (registers[3] & (1u << 26)) != 0;
+    bool hasSsse3 = (registers[2] & (1u << 9)) != 0;
+    bool hasOsXsave = (registers[2] & (1u << 27)) != 0;
+    bool hasAvx = (registers[2] & (1u << 28)) != 0;
+
+    if (!hasSse2)
+        return CPU_LEVEL_SCALAR;
+
+    if (!hasSsse3)
+        return CPU_LEVEL_SSE2;
+
+    if (maxLeaf < 7 || !hasOsXsave || !hasAvx)
+        return CPU_LEVEL_SSSE3;
+
+    /* The operating system has to save the upper halves of the registers. */
+#if defined(_MSC_VER)
+    u64 enabledState = _xgetbv(0);
+#else
+    u32 enabledLow;
+    u32 enabledHigh;
+    __asm__ volatile ("xgetbv" : "=a"(enabledLow), "=d"(enabledHigh) : "c"(0));
+    u64 enabledState = ((u64)enabledHigh << 32) | enabledLow;
+#endif
+
+    if ((enabledState & 0x6) != 0x6)
+        return CPU_LEVEL_SSSE3;
+
+#if defined(_MSC_VER)
+    __cpuidex((int*)registers, 7, 0);
+#else
+    __cpuid_count(7, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    bool hasAvx2 = (registers[1] & (1u << 5)) != 0;
+
+    return hasAvx2 ? CPU_LEVEL_AVX2 : CPU_LEVEL_SSSE3;
+}
+
+#else
+
+internal cpu_level DetectCpuLevel(void)
+{
+    return CPU_LEVEL_SCALAR;
+}
+
+#endif
+
+/*
+    END CPU
+*/
+
+#endif
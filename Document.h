@@ -0,0 +1,1212 @@
+#ifndef __ONTOLOGIC_DOCUMENT_H__
+#define __ONTOLOGIC_DOCUMENT_H__
+
+#include "Standard.h"
+#include "Platform.h"
+#include "MemoryPool.h"
+#include "Jobs.h"
+#include "Search.h"
+#include "Utf8.h"
+
+/*
+    BEGIN DOCUMENT
+*/
+
+/*
+    Pieces are kept at most this long, so that splitting one or finding a line
+    inside one has a bounded cost, however large the text behind it is.
+*/
+#define DOCUMENT_MAX_PIECE_SIZE Kilobyte(64)
+
+/* The size of each block of memory that inserted text is copied into. */
+#define DOCUMENT_ADD_BUFFER_SIZE Kilobyte(64)
+
+/* The number of nodes the document's pool allocates at a time. */
+#define DOCUMENT_NODES_PER_SLAB 256
+
+/*
+    Marks a line break count that hasn't been computed yet. Text handed to the
+    document by reference isn't read until its line breaks are first needed,
+    so that a large mapped file only has the pages that are viewed read in.
+*/
+#define DOCUMENT_UNCOUNTED ((size)-1)
+
+/**
+ * A piece of a document: a run of text that lives somewhere else, either in
+ * the document's add buffers or in memory handed to the document by its owner.
+ * Nodes form a treap ordered by position in the document, and each one caches
+ * the length and line breaks of its whole subtree.
+ */
+typedef struct document_node
+{
+    struct document_node* Left;
+    struct document_node* Right;
+    /* Random, and kept greater than the priorities of the node's children. */
+    u32 Priority;
+
+    const char* Text;
+    size Length;
+    /* The number of '\n' characters in the text, or DOCUMENT_UNCOUNTED. */
+    size LineBreaks;
+
+    size SubtreeLength;
+    /* DOCUMENT_UNCOUNTED if any node in the subtree is uncounted. */
+    size SubtreeLineBreaks;
+}
+document_node;
+
+/**
+ * A piece table of text. Inserting, deleting, and finding a position or line
+ * all take O(log n) in the number of pieces. Text is never moved once it is in
+ * the document, so pieces can point straight into read-only memory.
+ */
+typedef struct document
+{
+    memory_arena* Arena;
+    memory_pool NodePool;
+
+    document_node* Root;
+
+    /* The block that inserted text is currently being copied into. */
+    char* AddBuffer;
+    size AddBufferUsed;
+    size AddBufferSize;
+
+    /* The state of the generator used for node priorities. */
+    u32 RandomState;
+}
+document;
+
+/**
+ * Initializes an empty document.
+ *
+ * @param[in|out]	document	The document to setup.
+ * @param[in|out]	arena		The arena to allocate nodes and text from.
+ */
+internal void SetupDocument(document* document, memory_arena* arena)
+{
+    *document = (struct document){
+        .Arena = arena,
+
+        .Root = NULL,
+
+        .AddBuffer = NULL,
+        .AddBufferUsed = 0,
+        .AddBufferSize = 0,
+
+        .RandomState = 0x9e3779b9,
+    };
+
+    SetupMemoryPoolFor(
+        &document->NodePool,
+        arena,
+        document_node,
+        DOCUMENT_NODES_PER_SLAB
+    );
+}
+
+/**
+ * Computes the number of characters in the document.
+ *
+ * @param[in]	document	The document to measure.
+ *
+ * @return	The number of characters in the document.
+ */
+internal inline size DocumentLength(document* document)
+{
+    return document->Root ? document->Root->SubtreeLength : 0;
+}
+
+/**
+ * Counts the line breaks in the given text.
+ *
+ * @param[in]	text		The text to count the line breaks of.
+ * @param[in]	textLength	The length of the text.
+ *
+ * @return	The number of '\n' characters in the text.
+ */
+internal size _DocumentCountLineBreaks(const char* text, size textLength)
+{
+    size lineBreaks = 0;
+    for (size i = 0; i < textLength; i++)
+        lineBreaks += text[i] == '\n';
+
+    return lineBreaks;
+}
+
+/**
+ * Recomputes the cached subtree totals of a node from its children.
+ *
+ * @param[in|out]	node	The node to update.
+ */
+internal inline void _DocumentUpdateNode(document_node* node)
+{
+    node->SubtreeLength = node->Length;
+    node->SubtreeLineBreaks = node->LineBreaks;
+
+    if (node->Left)
+    {
+        node->SubtreeLength += node->Left->SubtreeLength;
+
+        if (node->Left->SubtreeLineBreaks == DOCUMENT_UNCOUNTED)
+            node->SubtreeLineBreaks = DOCUMENT_UNCOUNTED;
+
+        else if (node->SubtreeLineBreaks != DOCUMENT_UNCOUNTED)
+            node->SubtreeLineBreaks += node->Left->SubtreeLineBreaks;
+    }
+
+    if (node->Right)
+    {
+        node->SubtreeLength += node->Right->SubtreeLength;
+
+        if (node->Right->SubtreeLineBreaks == DOCUMENT_UNCOUNTED)
+            node->SubtreeLineBreaks = DOCUMENT_UNCOUNTED;
+
+        else if (node->SubtreeLineBreaks != DOCUMENT_UNCOUNTED)
+            node->SubtreeLineBreaks += node->Right->SubtreeLineBreaks;
+    }
+}
+
+/**
+ * Counts the line breaks of every uncounted node in a subtree. Subtrees that
+ * are already counted are skipped.
+ *
+ * @param[in|out]	node	The root of the subtree to count.
+ */
+internal void _DocumentCountSubtree(document_node* node)
+{
+    if (node == NULL || node->SubtreeLineBreaks != DOCUMENT_UNCOUNTED)
+        return;
+
+    _DocumentCountSubtree(node->Left);
+    _DocumentCountSubtree(node->Right);
+
+    if (node->LineBreaks == DOCUMENT_UNCOUNTED)
+        node->LineBreaks = _DocumentCountLineBreaks(node->Text, node->Length);
+
+    _DocumentUpdateNode(node);
+}
+
+/**
+ * Computes the number of lines in the document. An empty document, and the
+ * text after the last line break, both count as a line. The first call after
+ * text is inserted by reference reads all of that text.
+ *
+ * @param[in|out]	document	The document to measure.
+ *
+ * @return	The number of lines in the document.
+ */
+internal size DocumentLineCount(document* document)
+{
+    if (document->Root == NULL)
+        return 1;
+
+    _DocumentCountSubtree(document->Root);
+
+    return document->Root->SubtreeLineBreaks + 1;
+}
+
+/**
+ * Creates a node for a piece of text.
+ *
+ * @param[in|out]	document	The document the node belongs to.
+ * @param[in]		text		The text of the piece.
+ * @param[in]		length		The length of the piece.
+ * @param[in]		lineBreaks	The number of line breaks in the piece.
+ *
+ * @return	The new node, with no children.
+ */
+internal document_node* _DocumentCreateNode(
+    document* document,
+    const char* text,
+    size length,
+    size lineBreaks
+)
+{
+    /* xorshift32, which is plenty for keeping the treap balanced. */
+    u32 random = document->RandomState;
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    document->RandomState = random;
+
+    document_node* node =
+        MemoryPoolAllocateStruct(&document->NodePool, document_node);
+
+    *node = (document_node){
+        .Left = NULL,
+        .Right = NULL,
+        .Priority = random,
+
+        .Text = text,
+        .Length = length,
+        .LineBreaks = lineBreaks,
+
+        .SubtreeLength = length,
+        .SubtreeLineBreaks = lineBreaks,
+    };
+
+    return node;
+}
+
+/**
+ * Returns a node and all of its descendants to the document's pool.
+ *
+ * @param[in|out]	document	The document the nodes belong to.
+ * @param[in]		node		The root of the subtree to free.
+ */
+internal void _DocumentFreeNodes(document* document, document_node* node)
+{
+    while (node)
+    {
+        _DocumentFreeNodes(document, node->Left);
+
+        document_node* right = node->Right;
+        MemoryPoolFree(&document->NodePool, node);
+
+        node = right;
+    }
+}
+
+/**
+ * Joins two treaps, where everything in the first comes before everything in
+ * the second.
+ *
+ * @param[in|out]	left	The treap that comes first.
+ * @param[in|out]	right	The treap that comes second.
+ *
+ * @return	The root of the joined treap.
+ */
+internal document_node* _DocumentMerge(
+    document_node* left,
+    document_node* right
+)
+{
+    if (left == NULL)
+        return right;
+
+    if (right == NULL)
+        return left;
+
+    if (right->Priority < left->Priority)
+    {
+        left->Right = _DocumentMerge(left->Right, right);
+        _DocumentUpdateNode(left);
+
+        return left;
+    }
+
+    else
+    {
+        right->Left = _DocumentMerge(left, right->Left);
+        _DocumentUpdateNode(right);
+
+        return right;
+    }
+}
+
+/**
+ * Splits a treap in two at the given position, splitting the piece that spans
+ * it if there is one.
+ *
+ * @param[in|out]	document	The document the treap belongs to.
+ * @param[in|out]	node		The root of the treap to split.
+ * @param[in]		position	The number of characters to put in the left
+ *								treap.
+ * @param[out]		left		The treap of everything before the position.
+ * @param[out]		right		The treap of everything after the position.
+ */
+internal void _DocumentSplit(
+    document* document,
+    document_node* node,
+    size position,
+    document_node** left,
+    document_node** right
+)
+{
+    if (node == NULL)
+    {
+        *left = NULL;
+        *right = NULL;
+
+        return;
+    }
+
+    size leftLength = node->Left ? node->Left->SubtreeLength : 0;
+
+    if (position <= leftLength)
+    {
+        _DocumentSplit(document, node->Left, position, left, &node->Left);
+        _DocumentUpdateNode(node);
+
+        *right = node;
+    }
+
+    else if (leftLength + node->Length <= position)
+    {
+        _DocumentSplit(
+            document,
+            node->Right,
+            position - leftLength - node->Length,
+            &node->Right,
+            right
+        );
+        _DocumentUpdateNode(node);
+
+        *left = node;
+    }
+
+    else
+    {
+        size offset = position - leftLength;
+        size tailLength = node->Length - offset;
+
+        /* Only the shorter half needs counting, the other is the difference. */
+        size headLineBreaks, tailLineBreaks;
+        if (node->LineBreaks == DOCUMENT_UNCOUNTED)
+        {
+            headLineBreaks = DOCUMENT_UNCOUNTED;
+            tailLineBreaks = DOCUMENT_UNCOUNTED;
+        }
+
+        else if (offset < tailLength)
+        {
+            headLineBreaks = _DocumentCountLineBreaks(node->Text, offset);
+            tailLineBreaks = node->LineBreaks - headLineBreaks;
+        }
+
+        else
+        {
+            tailLineBreaks = _DocumentCountLineBreaks(
+                node->Text + offset,
+                tailLength
+            );
+            headLineBreaks = node->LineBreaks - tailLineBreaks;
+        }
+
+        document_node* tail = _DocumentCreateNode(
+            document,
+            node->Text + offset,
+            tailLength,
+            tailLineBreaks
+        );
+
+        *right = _DocumentMerge(tail, node->Right);
+
+        node->Length = offset;
+        node->LineBreaks = headLineBreaks;
+        node->Right = NULL;
+        _DocumentUpdateNode(node);
+
+        *left = node;
+    }
+}
+
+/**
+ * Splits text into pieces no longer than DOCUMENT_MAX_PIECE_SIZE and joins
+ * them, in order, onto the end of a treap.
+ *
+ * @param[in|out]	document		The document the treap belongs to.
+ * @param[in|out]	node			The root of the treap to add to.
+ * @param[in]		text			The text to add.
+ * @param[in]		textLength		The length of the text.
+ * @param[in]		countLineBreaks	Whether to count the line breaks now,
+ *									rather than when they are first needed.
+ *
+ * @return	The root of the treap with the text added.
+ */
+internal document_node* _DocumentAppendPieces(
+    document* document,
+    document_node* node,
+    const char* text,
+    size textLength,
+    bool countLineBreaks
+)
+{
+    while (0 < textLength)
+    {
+        size length = textLength < DOCUMENT_MAX_PIECE_SIZE
+            ? textLength
+            : DOCUMENT_MAX_PIECE_SIZE;
+
+        document_node* piece = _DocumentCreateNode(
+            document,
+            text,
+            length,
+            countLineBreaks
+                ? _DocumentCountLineBreaks(text, length)
+                : DOCUMENT_UNCOUNTED
+        );
+
+        node = _DocumentMerge(node, piece);
+
+        text += length;
+        textLength -= length;
+    }
+
+    return node;
+}
+
+/**
+ * Inserts text into the document without copying or reading it. The text must
+ * stay valid and unchanged for as long as the document uses it.
+ *
+ * @param[in|out]	document	The document to insert into.
+ * @param[in]		position	Where to insert the text. Clamped to the end.
+ * @param[in]		text		The text to insert.
+ * @param[in]		textLength	The length of the text.
+ */
+internal void DocumentInsertReference(
+    document* document,
+    size position,
+    const char* text,
+    size textLength
+)
+{
+    if (DocumentLength(document) < position)
+        position = DocumentLength(document);
+
+    document_node* left;
+    document_node* right;
+    _DocumentSplit(document, document->Root, position, &left, &right);
+
+    left = _DocumentAppendPieces(document, left, text, textLength, false);
+
+    document->Root = _DocumentMerge(left, right);
+}
+
+/**
+ * Inserts a copy of the given text into the document.
+ *
+ * @param[in|out]	document	The document to insert into.
+ * @param[in]		position	Where to insert the text. Clamped to the end.
+ * @param[in]		text		The text to insert.
+ * @param[in]		textLength	The length of the text.
+ */
+internal void DocumentInsert(
+    document* document,
+    size position,
+    const char* text,
+    size textLength
+)
+{
+    if (textLength == 0)
+        return;
+
+    if (DocumentLength(document) < position)
+        position = DocumentLength(document);
+
+    if (document->AddBufferSize - document->AddBufferUsed < textLength)
+    {
+        document->AddBufferSize = textLength < DOCUMENT_ADD_BUFFER_SIZE
+            ? DOCUMENT_ADD_BUFFER_SIZE
+            : textLength;
+        document->AddBuffer = PushArrayTagged(
+            document->Arena,
+            char,
+            document->AddBufferSize,
+            ALLOCATION_TAG_DOCUMENT
+        );
+        document->AddBufferUsed = 0;
+    }
+
+    char* copy = &document->AddBuffer[document->AddBufferUsed];
+    MemoryCopy(copy, text, textLength);
+
+    document->AddBufferUsed += textLength;
+
+    document_node* left;
+    document_node* right;
+    _DocumentSplit(document, document->Root, position, &left, &right);
+
+    /*
+        Typing inserts one character after another, each straight after the
+        last in the add buffer. Rather than giving each its own piece, the
+        piece before the position is extended whenever it ends where the copy
+        starts.
+    */
+    document_node* last = left;
+    while (last && last->Right)
+        last = last->Right;
+
+    if (last
+        && last->Text + last->Length == copy
+        && last->LineBreaks != DOCUMENT_UNCOUNTED
+        && last->Length + textLength <= DOCUMENT_MAX_PIECE_SIZE)
+    {
+        size lineBreaks = _DocumentCountLineBreaks(copy, textLength);
+
+        last->Length += textLength;
+        last->LineBreaks += lineBreaks;
+
+        /* The last node is on the right spine, as is every node above it. */
+        for (document_node* node = left; node; node = node->Right)
+        {
+            node->SubtreeLength += textLength;
+
+            if (node->SubtreeLineBreaks != DOCUMENT_UNCOUNTED)
+                node->SubtreeLineBreaks += lineBreaks;
+        }
+    }
+
+    else
+        left = _DocumentAppendPieces(document, left, copy, textLength, true);
+
+    document->Root = _DocumentMerge(left, right);
+}
+
+/**
+ * Deletes a range of text from the document.
+ *
+ * @param[in|out]	document	The document to delete from.
+ * @param[in]		position	The position of the first character to delete.
+ * @param[in]		length		The number of characters to delete.
+ */
+internal inline void DocumentDelete(
+    document* document,
+    size position,
+    size length
+)
+{
+    document_node* left;
+    document_node* middle;
+    document_node* right;
+
+    _DocumentSplit(document, document->Root, position, &left, &right);
+    _DocumentSplit(document, right, length, &middle, &right);
+
+    _DocumentFreeNodes(document, middle);
+
+    document->Root = _DocumentMerge(left, right);
+}
+
+/**
+ * Finds the contiguous run of text at the given position, up to the end of the
+ * piece it is in.
+ *
+ * @param[in]	document	The document to search.
+ * @param[in]	position	The position to find.
+ *
+ * @return	The text from the position to the end of its piece, or an empty
+ *			string if the position is past the end of the document.
+ */
+internal string DocumentSpanAt(document* document, size position)
+{
+    document_node* node = document->Root;
+
+    while (node)
+    {
+        size leftLength = node->Left ? node->Left->SubtreeLength : 0;
+
+        if (position < leftLength)
+            node = node->Left;
+
+        else if (position < leftLength + node->Length)
+        {
+            size offset = position - leftLength;
+            return MakeString(node->Text + offset, node->Length - offset);
+        }
+
+        else
+        {
+            position -= leftLength + node->Length;
+            node = node->Right;
+        }
+    }
+
+    return MakeString(NULL, 0);
+}
+
+/**
+ * Finds the contiguous run of text before the given position, back to the
+ * start of the piece it is in.
+ *
+ * @param[in]	document	The document to search.
+ * @param[in]	position	The position the run ends at.
+ *
+ * @return	The text from the start of its piece up to the position, or an
+ *			empty string if the position is at the start of the document.
+ */
+internal string DocumentSpanBefore(document* document, size position)
+{
+    if (position == 0 || DocumentLength(document) < position)
+        return MakeString(NULL, 0);
+
+    /* The piece holding the character before the position. */
+    size offset = position - 1;
+    document_node* node = document->Root;
+
+    while (node)
+    {
+        size leftLength = node->Left ? node->Left->SubtreeLength : 0;
+
+        if (offset < leftLength)
+            node = node->Left;
+
+        else if (offset < leftLength + node->Length)
+            return MakeString(node->Text, offset - leftLength + 1);
+
+        else
+        {
+            offset -= leftLength + node->Length;
+            node = node->Right;
+        }
+    }
+
+    return MakeString(NULL, 0);
+}
+
+/**
+ * Finds the character at the given position.
+ *
+ * @param[in]	document	The document to search.
+ * @param[in]	position	The position of the character.
+ *
+ * @return	The character, or '\0' if the position is past the end.
+ */
+internal char DocumentCharAt(document* document, size position)
+{
+    string span = DocumentSpanAt(document, position);
+    return span.Length ? span.Data[0] : '\0';
+}
+
+/**
+ * Copies a run of text out of the document.
+ *
+ * @param[in]	document	The document to copy from.
+ * @param[in]	position	Where the run starts.
+ * @param[in]	count		The length of the run.
+ * @param[out]	destination	Where to copy the run to.
+ *
+ * @return	The number of characters copied, which is less than count if the
+ *			run goes past the end of the document.
+ */
+internal size DocumentCopy(
+    document* document,
+    size position,
+    size count,
+    char* destination
+)
+{
+    size charsCopied = 0;
+
+    while (charsCopied < count)
+    {
+        string span = DocumentSpanAt(document, position + charsCopied);
+        if (span.Length == 0)
+            break;
+
+        size spanCount = span.Length < count - charsCopied
+            ? span.Length
+            : count - charsCopied;
+
+        for (size i = 0; i < spanCount; i++)
+            destination[charsCopied + i] = span.Data[i];
+
+        charsCopied += spanCount;
+    }
+
+    return charsCopied;
+}
+
+/* A piece of a document for a job to check is valid UTF-8. */
+typedef struct _utf8_validation
+{
+    const char* Text;
+    size Length;
+
+    /* Set by any job that finds its text isn't valid. */
+    volatile bool* Invalid;
+}
+_utf8_validation;
+
+/**
+ * Checks whether a piece of a document is valid UTF-8, as a job.
+ *
+ * @param[in|out]	worker	The worker running the job.
+ * @param[in]		data	The _utf8_validation to check.
+ */
+internal void _ValidateUtf8Job(job_worker* worker, void* data)
+{
+    _utf8_validation* validation = data;
+    (void)worker;
+
+    if (!Utf8Validate(validation->Text, validation->Length))
+        AtomicStoreRelease(validation->Invalid, true);
+}
+
+/**
+ * Checks whether the text of a document is entirely valid UTF-8. Each piece is
+ * checked where it is, by a job of its own. Only the characters that cross
+ * from one piece into the next are checked in a copy.
+ *
+ * @param[in]		document	The document to check.
+ * @param[in|out]	worker		The worker to run the jobs from.
+ *
+ * @return	True if the document is valid UTF-8.
+ */
+internal bool DocumentIsValidUtf8(document* document, job_worker* worker)
+{
+    volatile bool invalid = false;
+    job* validation = CreateJob(worker, NULL, NULL, 0, NULL);
+
+    size length = DocumentLength(document);
+    size position = 0;
+
+    while (position < length && !invalid)
+    {
+        string span = DocumentSpanAt(document, position);
+
+        /* Leave out a character the end of the span cuts short. */
+        size complete = span.Length;
+
+        size lead = span.Length;
+        while (
+            0 < lead && span.Length - lead < UTF8_MAX_LENGTH
+            && Utf8IsContinuation(span.Data[lead - 1])
+        )
+            lead--;
+
+        if (0 < lead)
+        {
+            lead--;
+            if (span.Length - lead < Utf8SequenceLength(span.Data[lead]))
+                complete = lead;
+        }
+
+        _utf8_validation piece = {
+            .Text = span.Data,
+            .Length = complete,
+            .Invalid = &invalid,
+        };
+
+        SubmitJob(
+            worker,
+            CreateJob(
+                worker, _ValidateUtf8Job, &piece, sizeof(piece), validation
+            )
+        );
+
+        position += complete;
+
+        if (complete < span.Length)
+        {
+            char character[UTF8_MAX_LENGTH];
+            size characterLength = Utf8SequenceLength(span.Data[complete]);
+
+            size copied = DocumentCopy(
+                document, position, characterLength, character
+            );
+
+            if (!Utf8Validate(character, copied))
+                invalid = true;
+
+            position += copied;
+        }
+    }
+
+    SubmitJob(worker, validation);
+    WaitForJob(worker, validation);
+
+    return !invalid;
+}
+
+/**
+ * Finds the first occurrence of a needle at or after the given position. Each
+ * piece is searched where it is. Only the occurrences that cross from one
+ * piece into the next are searched for in a copy, which holds the end of the
+ * one and the start of the other.
+ *
+ * @param[in]	document		The document to search.
+ * @param[in]	position		Where to start searching.
+ * @param[in]	needle			The text to search for.
+ * @param[in]	needleLength	The length of the needle. Must not be 0.
+ * @param[in]	scratchArena	The arena to allocate the copy from.
+ *
+ * @return	Where the occurrence starts, or SEARCH_NOT_FOUND.
+ */
+internal size DocumentSearchForward(
+    document* document,
+    size position,
+    const char* needle,
+    size needleLength,
+    memory_arena* scratchArena
+)
+{
+    Assert(0 < needleLength);
+
+    size found = SEARCH_NOT_FOUND;
+    size overlap = needleLength - 1;
+
+    temporary_memory scratch = BeginTemporaryMemory(scratchArena);
+    char* window = PushArrayTagged(
+        scratchArena, char, 2 * overlap + 1, ALLOCATION_TAG_SCRATCH
+    );
+
+    forever
+    {
+        string span = DocumentSpanAt(document, position);
+        if (span.Length == 0)
+            break;
+
+        found = SearchForward(span.Data, span.Length, needle, needleLength);
+        if (found != SEARCH_NOT_FOUND)
+        {
+            found += position;
+            break;
+        }
+
+        size spanEnd = position + span.Length;
+
+        /* Occurrences that start in the last overlap bytes of the span. */
+        size windowStart = overlap < span.Length
+            ? spanEnd - overlap
+            : position;
+        size windowLength = DocumentCopy(
+            document,
+            windowStart,
+            spanEnd - windowStart + overlap,
+            window
+        );
+
+        found = SearchForward(window, windowLength, needle, needleLength);
+        if (found != SEARCH_NOT_FOUND)
+        {
+            found += windowStart;
+            break;
+        }
+
+        position = spanEnd;
+    }
+
+    EndTemporaryMemory(scratch);
+
+    return found;
+}
+
+/**
+ * Finds the last occurrence of a needle that ends at or before the given
+ * position. See DocumentSearchForward.
+ *
+ * @param[in]	document		The document to search.
+ * @param[in]	position		Where the occurrence has to end by.
+ * @param[in]	needle			The text to search for.
+ * @param[in]	needleLength	The length of the needle. Must not be 0.
+ * @param[in]	scratchArena	The arena to allocate the copy from.
+ *
+ * @return	Where the occurrence starts, or SEARCH_NOT_FOUND.
+ */
+internal size DocumentSearchBackward(
+    document* document,
+    size position,
+    const char* needle,
+    size needleLength,
+    memory_arena* scratchArena
+)
+{
+    Assert(0 < needleLength);
+
+    size found = SEARCH_NOT_FOUND;
+    size overlap = needleLength - 1;
+
+    temporary_memory scratch = BeginTemporaryMemory(scratchArena);
+    char* window = PushArrayTagged(
+        scratchArena, char, 2 * overlap + 1, ALLOCATION_TAG_SCRATCH
+    );
+
+    forever
+    {
+        string span = DocumentSpanBefore(document, position);
+        if (span.Length == 0)
+            break;
+
+        size spanStart = position - span.Length;
+
+        found = SearchBackward(span.Data, span.Length, needle, needleLength);
+        if (found != SEARCH_NOT_FOUND)
+        {
+            found += spanStart;
+            break;
+        }
+
+        /* Occurrences that end in the first overlap bytes of the span. */
+        size windowStart = overlap < spanStart ? spanStart - overlap : 0;
+        size windowEnd = spanStart + (overlap < span.Length
+            ? overlap
+            : span.Length);
+        size windowLength = DocumentCopy(
+            document,
+            windowStart,
+            windowEnd - windowStart,
+            window
+        );
+
+        found = SearchBackward(window, windowLength, needle, needleLength);
+        if (found != SEARCH_NOT_FOUND)
+        {
+            found += windowStart;
+            break;
+        }
+
+        position = spanStart;
+    }
+
+    EndTemporaryMemory(scratch);
+
+    return found;
+}
+
+/**
+ * Finds where a line starts within a subtree, walking it in order so that the
+ * uncounted text after the line is never read. Subtrees that are already
+ * counted are stepped over or into without reading their text.
+ *
+ * @param[in|out]	node		The root of the subtree to search.
+ * @param[in|out]	line		The number of line breaks before the line, less
+ *								those before the subtree. Reduced by those in
+ *								the subtree if the line isn't found in it.
+ * @param[in|out]	position	The position of the subtree, moved to the start
+ *								of the line if it is found, and past the
+ *								subtree if not.
+ *
+ * @return	True if the line starts within the subtree.
+ */
+internal bool _DocumentFindLine(
+    document_node* node,
+    size* line,
+    size* position
+)
+{
+    if (node == NULL)
+        return false;
+
+    if (node->SubtreeLineBreaks != DOCUMENT_UNCOUNTED
+        && node->SubtreeLineBreaks < *line)
+    {
+        *line -= node->SubtreeLineBreaks;
+        *position += node->SubtreeLength;
+        return false;
+    }
+
+    if (_DocumentFindLine(node->Left, line, position))
+        return true;
+
+    if (node->LineBreaks == DOCUMENT_UNCOUNTED)
+        node->LineBreaks = _DocumentCountLineBreaks(node->Text, node->Length);
+
+    if (*line <= node->LineBreaks)
+    {
+        for (size i = 0; i < node->Length; i++)
+        {
+            if (node->Text[i] == '\n' && --*line == 0)
+            {
+                *position += i + 1;
+                return true;
+            }
+        }
+    }
+
+    *line -= node->LineBreaks;
+    *position += node->Length;
+
+    bool found = _DocumentFindLine(node->Right, line, position);
+
+    /* Both children are counted now, unless the line was found. */
+    _DocumentUpdateNode(node);
+
+    return found;
+}
+
+/**
+ * Finds where the given line starts. Only the text before the line is read,
+ * and only the first time its line breaks are needed, so finding a line near
+ * the top of a large mapped file reads just the pages above it.
+ *
+ * @param[in|out]	document	The document to search.
+ * @param[in]		line		The line to find, counting from zero.
+ * @param[out]		start		The position of the first character of the
+ *								line, if the document has it.
+ *
+ * @return	True if the document has the line, false if it has fewer lines.
+ */
+internal bool DocumentFindLine(document* document, size line, size* start)
+{
+    *start = 0;
+
+    if (line == 0)
+        return true;
+
+    return _DocumentFindLine(document->Root, &line, start);
+}
+
+/**
+ * Finds where the given line starts. Only the text before the line is read,
+ * as with DocumentFindLine.
+ *
+ * @param[in|out]	document	The document to search.
+ * @param[in]		line		The line to find, counting from zero.
+ *
+ * @return	The position of the first character of the line, or the length of
+ *			the document if it has fewer lines.
+ */
+internal size DocumentLineStart(document* document, size line)
+{
+    size start;
+    if (!DocumentFindLine(document, line, &start))
+        return DocumentLength(document);
+
+    return start;
+}
+
+/**
+ * Finds the line that holds the given position. Only the text before the
+ * position is read, and only the first time its line breaks are needed.
+ *
+ * @param[in|out]	document	The document to search.
+ * @param[in]		position	The position to find the line of.
+ *
+ * @return	The line holding the position, counting from zero. Positions past
+ *			the end are on the last line.
+ */
+internal size DocumentLineOf(document* document, size position)
+{
+    size line = 0;
+    document_node* node = document->Root;
+
+    while (node)
+    {
+        size leftLength = node->Left ? node->Left->SubtreeLength : 0;
+
+        if (position < leftLength)
+        {
+            node = node->Left;
+            continue;
+        }
+
+        if (node->Left)
+        {
+            _DocumentCountSubtree(node->Left);
+            line += node->Left->SubtreeLineBreaks;
+        }
+
+        size offset = position - leftLength;
+        if (offset < node->Length)
+            return line + _DocumentCountLineBreaks(node->Text, offset);
+
+        if (node->LineBreaks == DOCUMENT_UNCOUNTED)
+        {
+            node->LineBreaks = _DocumentCountLineBreaks(
+                node->Text,
+                node->Length
+            );
+        }
+
+        line += node->LineBreaks;
+        position = offset - node->Length;
+        node = node->Right;
+    }
+
+    return line;
+}
+
+/* A position in a document that moves forward a line at a time. */
+typedef struct document_iterator
+{
+    document* Document;
+
+    size Line;
+    size Position;
+    /* Set once the last line has been read. */
+    bool AtEnd;
+}
+document_iterator;
+
+/**
+ * Creates an iterator at the start of the given line.
+ *
+ * @param[in|out]	document	The document to iterate over.
+ * @param[in]		line		The line to start at, counting from zero.
+ *
+ * @return	The iterator, which is already at its end if the document has
+ *			fewer lines.
+ */
+internal document_iterator DocumentIteratorAtLine(
+    document* document,
+    size line
+)
+{
+    document_iterator iterator = {
+        .Document = document,
+
+        .Line = line,
+    };
+
+    iterator.AtEnd = !DocumentFindLine(document, line, &iterator.Position);
+
+    return iterator;
+}
+
+/**
+ * Copies the line at the iterator, without its line break, and moves the
+ * iterator to the start of the next line. Only the text that is copied is
+ * read. The rest of a line too long to copy is stepped over through the line
+ * index, without reading it again once it has been counted.
+ *
+ * @param[in|out]	iterator			The iterator to read from.
+ * @param[out]		destination			Where to copy the line to.
+ * @param[in]		destinationSize		The most characters to copy.
+ *
+ * @return	The number of characters copied.
+ */
+internal size DocumentReadLine(
+    document_iterator* iterator,
+    char* destination,
+    size destinationSize
+)
+{
+    if (iterator->AtEnd)
+        return 0;
+
+    document* document = iterator->Document;
+
+    size charsCopied = 0;
+    while (charsCopied < destinationSize)
+    {
+        string span = DocumentSpanAt(document, iterator->Position);
+        if (span.Length == 0)
+        {
+            iterator->AtEnd = true;
+            return charsCopied;
+        }
+
+        size i = 0;
+        for (; i < span.Length && charsCopied < destinationSize; i++)
+        {
+            if (span.Data[i] == '\n')
+            {
+                iterator->Line++;
+                iterator->Position += i + 1;
+                return charsCopied;
+            }
+
+            destination[charsCopied++] = span.Data[i];
+        }
+
+        iterator->Position += i;
+    }
+
+    iterator->Line++;
+    if (!DocumentFindLine(document, iterator->Line, &iterator->Position))
+    {
+        iterator->Position = DocumentLength(document);
+        iterator->AtEnd = true;
+    }
+
+    return charsCopied;
+}
+
+/*
+    END DOCUMENT
+*/
+
+#endif
@@ -0,0 +1,254 @@
+#ifndef __ONTOLOGIC_FRAME_STATS_H__
+#define __ONTOLOGIC_FRAME_STATS_H__
+
+#include "Standard.h"
+#include "Platform.h"
+#include "StringBuilder.h"
+
+/*
+    BEGIN FRAME STATS
+*/
+
+/* How many of the latest samples of each statistic are kept. */
+#define FRAME_STATS_SAMPLE_COUNT 256
+
+/* What a statistic is measured in. */
+typedef enum frame_stat_unit
+{
+    FRAME_STAT_UNIT_NANOSECONDS,
+    FRAME_STAT_UNIT_BYTES,
+}
+frame_stat_unit;
+
+/*
+    What is measured of the frames: how long each phase of the main loop takes,
+    and how much each blit sends. Each has a short name and a unit.
+*/
+#define FRAME_STATS \
+    _(FRAME_STAT_INPUT, "input", FRAME_STAT_UNIT_NANOSECONDS) \
+    _(FRAME_STAT_DRAW, "draw", FRAME_STAT_UNIT_NANOSECONDS) \
+    _(FRAME_STAT_PRESENT, "present", FRAME_STAT_UNIT_NANOSECONDS) \
+    _(FRAME_STAT_BLIT, "blit", FRAME_STAT_UNIT_NANOSECONDS) \
+    _(FRAME_STAT_BLIT_SIZE, "sent", FRAME_STAT_UNIT_BYTES)
+
+typedef enum frame_stat
+{
+#define _(STAT, NAME, UNIT) STAT,
+    FRAME_STATS
+#undef _
+
+    FRAME_STAT_COUNT
+}
+frame_stat;
+
+global const string FrameStatNames[] = {
+#define _(STAT, NAME, UNIT) { NAME, sizeof(NAME) - 1 },
+    FRAME_STATS
+#undef _
+};
+
+global const frame_stat_unit FrameStatUnits[] = {
+#define _(STAT, NAME, UNIT) UNIT,
+    FRAME_STATS
+#undef _
+};
+
+/**
+ * Keeps the latest samples of every statistic, each in a ring of its own, so
+ * that the statistics always describe the last few seconds rather than the
+ * whole session.
+ */
+typedef struct frame_stats
+{
+    u64 Samples[FRAME_STAT_COUNT][FRAME_STATS_SAMPLE_COUNT];
+    /* How many samples of each statistic have been recorded, ever. */
+    size SampleCounts[FRAME_STAT_COUNT];
+}
+frame_stats;
+
+/* A summary of the samples kept of a statistic. */
+typedef struct frame_stat_summary
+{
+    size SampleCount;
+
+    u64 Minimum;
+    u64 Mean;
+    u64 Median;
+    u64 Percentile99;
+}
+frame_stat_summary;
+
+/**
+ * Initializes a frame_stats with no samples.
+ *
+ * @param[out]	stats	The frame stats to setup.
+ */
+internal void SetupFrameStats(frame_stats* stats)
+{
+    for (size stat = 0; stat < FRAME_STAT_COUNT; stat++)
+        stats->SampleCounts[stat] = 0;
+}
+
+/**
+ * Records a sample of a statistic, replacing its oldest sample once the ring
+ * is full.
+ *
+ * @param[in|out]	stats	The frame stats to record the sample in.
+ * @param[in]		stat	The statistic the sample is of.
+ * @param[in]		sample	The sample, in the statistic's unit.
+ */
+internal void RecordFrameStat(frame_stats* stats, frame_stat stat, u64 sample)
+{
+    size index = stats->SampleCounts[stat]++ % FRAME_STATS_SAMPLE_COUNT;
+    stats->Samples[stat][index] = sample;
+}
+
+/**
+ * Summarizes the samples kept of a statistic.
+ *
+ * @param[in]		stats	The frame stats holding the samples.
+ * @param[in]		stat	The statistic to summarize.
+ * @param[in|out]	arena	An arena to sort a copy of the samples in.
+ *
+ * @return	The summary. Everything but the sample count is 0 if there are no
+ *			samples.
+ */
+internal frame_stat_summary SummarizeFrameStat(
+    const frame_stats* stats,
+    frame_stat stat,
+    memory_arena* arena
+)
+{
+    size count = stats->SampleCounts[stat] < FRAME_STATS_SAMPLE_COUNT
+        ? stats->SampleCounts[stat]
+        : FRAME_STATS_SAMPLE_COUNT;
+
+    frame_stat_summary summary = { .SampleCount = count };
+
+    if (count == 0)
+        return summary;
+
+    temporary_memory scratch = BeginTemporaryMemory(arena);
+
+    u64* sorted = PushArrayTagged(arena, u64, count, ALLOCATION_TAG_SCRATCH);
+    u64 total = 0;
+
+    /* There are few enough samples that inserting each in order is quick. */
+    for (size i = 0; i < count; i++)
+    {
+        u64 sample = stats->Samples[stat][i];
+        total += sample;
+
+        size j = i;
+        for (; 0 < j && sample < sorted[j - 1]; j--)
+            sorted[j] = sorted[j - 1];
+
+        sorted[j] = sample;
+    }
+
+    /* The percentiles are the nearest ranks, so always an actual sample. */
+    summary.Minimum = sorted[0];
+    summary.Mean = total / count;
+    summary.Median = sorted[(count + 1) / 2 - 1];
+    summary.Percentile99 = sorted[(99 * count + 99) / 100 - 1];
+
+    EndTemporaryMemory(scratch);
+
+    return summary;
+}
+
+/**
+ * Formats every statistic on a single line, as its minimum, mean, median and
+ * 99th percentile. Durations are given in microseconds.
+ *
+ * @param[in|out]	builder	The builder to append the line to.
+ * @param[in]		stats	The frame stats to format.
+ * @param[in|out]	arena	An arena for scratch memory.
+ */
+internal void FormatFrameStatsLine(
+    string_builder* builder,
+    const frame_stats* stats,
+    memory_arena* arena
+)
+{
+    string legend = StringLiteral("min/mean/p50/p99");
+    StringBuilderAppend(builder, legend.Data, legend.Length);
+
+    char statFormat[] = " %s %u/%u/%u/%u%s";
+    format_descriptor statDescriptor;
+    ParseFormat(&statDescriptor, statFormat, sizeof(statFormat) - 1);
+
+    for (size stat = 0; stat < FRAME_STAT_COUNT; stat++)
+    {
+        frame_stat_summary summary = SummarizeFrameStat(stats, stat, arena);
+
+        u64 scale = 1;
+        string unit = StringLiteral("B");
+
+        if (FrameStatUnits[stat] == FRAME_STAT_UNIT_NANOSECONDS)
+        {
+            scale = 1000;
+            unit = StringLiteral("us");
+        }
+
+        StringBuilderAppendParsed(
+            builder,
+            &statDescriptor,
+            FrameStatNames[stat],
+            summary.Minimum / scale,
+            summary.Mean / scale,
+            summary.Median / scale,
+            summary.Percentile99 / scale,
+            unit
+        );
+    }
+}
+
+/**
+ * Formats every statistic as a row of CSV, after a header row naming the
+ * columns. Durations are given in nanoseconds.
+ *
+ * @param[in|out]	builder	The builder to append the CSV to.
+ * @param[in]		stats	The frame stats to format.
+ * @param[in|out]	arena	An arena for scratch memory.
+ */
+internal void FormatFrameStatsCsv(
+    string_builder* builder,
+    const frame_stats* stats,
+    memory_arena* arena
+)
+{
+    string header = StringLiteral("stat,unit,samples,min,mean,p50,p99\n");
+    StringBuilderAppend(builder, header.Data, header.Length);
+
+    char rowFormat[] = "%s,%s,%u,%u,%u,%u,%u\n";
+    format_descriptor rowDescriptor;
+    ParseFormat(&rowDescriptor, rowFormat, sizeof(rowFormat) - 1);
+
+    for (size stat = 0; stat < FRAME_STAT_COUNT; stat++)
+    {
+        frame_stat_summary summary = SummarizeFrameStat(stats, stat, arena);
+
+        string unit = FrameStatUnits[stat] == FRAME_STAT_UNIT_NANOSECONDS
+            ? StringLiteral("ns")
+            : StringLiteral("bytes");
+
+        StringBuilderAppendParsed(
+            builder,
+            &rowDescriptor,
+            FrameStatNames[stat],
+            unit,
+            summary.SampleCount,
+            summary.Minimum,
+            summary.Mean,
+            summary.Median,
+            summary.Percentile99
+        );
+    }
+}
+
+/*
+    END FRAME STATS
+*/
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef __ONTOLOGIC_GAP_BUFFER_H__
+#define __ONTOLOGIC_GAP_BUFFER_H__
+
+#include "Standard.h"
+#include "Platform.h"
+
+/*
+    BEGIN GAP BUFFER
+*/
+
+/**
+ * An editable run of text with a gap of unused space at the cursor. Inserting
+ * and deleting at the cursor only moves the edges of the gap, and moving the
+ * cursor moves the text between it and its new position across the gap.
+ */
+typedef struct gap_buffer
+{
+    /* The arena that the text is allocated from. */
+    memory_arena* Arena;
+
+    char* Buffer;
+    size Capacity;
+
+    /* The gap spans [GapStart, GapEnd). The cursor is always at GapStart. */
+    size GapStart;
+    size GapEnd;
+}
+gap_buffer;
+
+/**
+ * Initializes an empty gap_buffer.
+ *
+ * @param[in|out]	gapBuffer	The gap buffer to setup.
+ * @param[in|out]	arena		The arena to allocate the text from.
+ * @param[in]		capacity	The number of characters to make room for.
+ */
+internal void SetupGapBuffer(
+    gap_buffer* gapBuffer,
+    memory_arena* arena,
+    size capacity
+)
+{
+    Assert(0 < capacity);
+
+    *gapBuffer = (gap_buffer){
+        .Arena = arena,
+
+        .Buffer = PushArrayTagged(arena, char, capacity, ALLOCATION_TAG_TEXT),
+        .Capacity = capacity,
+
+        .GapStart = 0,
+        .GapEnd = capacity,
+    };
+}
+
+/**
+ * Computes the number of characters in the gap buffer.
+ *
+ * @param[in]	gapBuffer	The gap buffer to measure.
+ *
+ * @return	The number of characters in the gap buffer.
+ */
+internal inline size GapBufferLength(gap_buffer* gapBuffer)
+{
+    return gapBuffer->Capacity - (gapBuffer->GapEnd - gapBuffer->GapStart);
+}
+
+/**
+ * Finds the position of the cursor in the gap buffer.
+ *
+ * @param[in]	gapBuffer	The gap buffer to find the cursor of.
+ *
+ * @return	The number of characters before the cursor.
+ */
+internal inline size GapBufferCursor(gap_buffer* gapBuffer)
+{
+    return gapBuffer->GapStart;
+}
+
+/**
+ * Widens the gap so that it can hold at least the given number of characters.
+ * The text after the gap is moved to the end of the larger buffer.
+ *
+ * @param[in|out]	gapBuffer	The gap buffer to grow.
+ * @param[in]		gapSize		The number of characters the gap must hold.
+ */
+internal void _GapBufferGrow(gap_buffer* gapBuffer, size gapSize)
+{
+    size length = GapBufferLength(gapBuffer);
+    size afterLength = gapBuffer->Capacity - gapBuffer->GapEnd;
+
+    /* Doubling keeps the cost of growing amortized O(1) per character. */
+    size capacity = gapBuffer->Capacity * 2;
+    if (capacity < length + gapSize)
+        capacity = length + gapSize;
+
+    memory_arena* arena = gapBuffer->Arena;
+    char* buffer;
+
+    /*
+        If the buffer is the last thing allocated from the arena, it can grow in
+        place. Otherwise the text is copied into a new buffer, and the old one
+        is left behind in the arena.
+    */
+    if (gapBuffer->Buffer + gapBuffer->Capacity == (char*)arena->Cursor)
+    {
+        PushArrayTagged(
+            arena, char, capacity - gapBuffer->Capacity, ALLOCATION_TAG_TEXT
+        );
+
+        buffer = gapBuffer->Buffer;
+    }
+
+    else
+    {
+        buffer = PushArrayTagged(arena, char, capacity, ALLOCATION_TAG_TEXT);
+
+        for (size i = 0; i < gapBuffer->GapStart; i++)
+            buffer[i] = gapBuffer->Buffer[i];
+    }
+
+    /* Walk backwards, as the ranges overlap when growing in place. */
+    for (size i = afterLength; 0 < i; i--)
+        buffer[capacity - afterLength + i - 1] =
+            gapBuffer->Buffer[gapBuffer->GapEnd + i - 1];
+
+    gapBuffer->Buffer = buffer;
+    gapBuffer->GapEnd = capacity - afterLength;
+    gapBuffer->Capacity = capacity;
+}
+
+/**
+ * Inserts text at the cursor, leaving the cursor after it.
+ *
+ * @param[in|out]	gapBuffer	The gap buffer to insert into.
+ * @param[in]		text		The text to insert.
+ * @param[in]		textLength	The length of the text.
+ */
+internal void GapBufferInsert(
+    gap_buffer* gapBuffer,
+    const char* text,
+    size textLength
+)
+{
+    if (gapBuffer->GapEnd - gapBuffer->GapStart < textLength)
+        _GapBufferGrow(gapBuffer, textLength);
+
+    for (size i = 0; i < textLength; i++)
+        gapBuffer->Buffer[gapBuffer->GapStart++] = text[i];
+}
+
+/**
+ * Deletes up to count characters before the cursor.
+ *
+ * @param[in|out]	gapBuffer	The gap buffer to delete from.
+ * @param[in]		count		The number of characters to delete.
+ *
+ * @return	The number of characters deleted.
+ */
+internal size GapBufferDeleteBackward(gap_buffer* gapBuffer, size count)
+{
+    if (gapBuffer->GapStart < count)
+        count = gapBuffer->GapStart;
+
+    gapBuffer->GapStart -= count;
+
+    return count;
+}
+
+/**
+ * Deletes up to count characters after the cursor.
+ *
+ * @param[in|out]	gapBuffer	The gap buffer to delete from.
+ * @param[in]		count		The number of characters to delete.
+ *
+ * @return	The number of characters deleted.
+ */
+internal size GapBufferDeleteForward(gap_buffer* gapBuffer, size count)
+{
+    if (gapBuffer->Capacity - gapBuffer->GapEnd < count)
+        count = gapBuffer->Capacity - gapBuffer->GapEnd;
+
+    gapBuffer->GapEnd += count;
+
+    return count;
+}
+
+/**
+ * Moves the cursor to the given position, clamped to the end of the text.
+ *
+ * @param[in|out]	gapBuffer	The gap buffer to move the cursor of.
+ * @param[in]		position	The number of characters to leave before the
+ *								cursor.
+ */
+internal void GapBufferMoveCursor(gap_buffer* gapBuffer, size position)
+{
+    size length = GapBufferLength(gapBuffer);
+    if (length < position)
+        position = length;
+
+    char* buffer = gapBuffer->Buffer;
+
+    while (position < gapBuffer->GapStart)
+        buffer[--gapBuffer->GapEnd] = buffer[--gapBuffer->GapStart];
+
+    while (gapBuffer->GapStart < position)
+        buffer[gapBuffer->GapStart++] = buffer[gapBuffer->GapEnd++];
+}
+
+/**
+ * Deletes all of the text in the gap buffer, keeping its memory.
+ *
+ * @param[in|out]	gapBuffer	The gap buffer to clear.
+ */
+internal inline void ClearGapBuffer(gap_buffer* gapBuffer)
+{
+    gapBuffer->GapStart = 0;
+    gapBuffer->GapEnd = gapBuffer->Capacity;
+}
+
+/**
+ * Copies a range of the text out of the gap buffer, skipping over the gap.
+ *
+ * @param[in]		gapBuffer	The gap buffer to copy from.
+ * @param[in]		start		The position of the first character to copy.
+ * @param[in]		count		The most characters to copy.
+ * @param[in|out]	destination	Where to copy the characters to.
+ *
+ * @return	The number of characters copied.
+ */
+internal size GapBufferCopy(
+    gap_buffer* gapBuffer,
+    size start,
+    size count,
+    char* destination
+)
+{
+    size length = GapBufferLength(gapBuffer);
+    if (length <= start)
+        return 0;
+
+    if (length - start < count)
+        count = length - start;
+
+    size gapSize = gapBuffer->GapEnd - gapBuffer->GapStart;
+
+    size i = 0;
+    for (; i < count && start + i < gapBuffer->GapStart; i++)
+        destination[i] = gapBuffer->Buffer[start + i];
+
+    for (; i < count; i++)
+        destination[i] = gapBuffer->Buffer[start + i + gapSize];
+
+    return count;
+}
+
+/*
+    END GAP BUFFER
+*/
+
+#endif
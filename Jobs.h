@@ -0,0 +1,535 @@
+#ifndef __ONTOLOGIC_JOBS_H__
+#define __ONTOLOGIC_JOBS_H__
+
+#include "Standard.h"
+#include "Platform.h"
+#include "Profile.h"
+
+/*
+    BEGIN JOBS
+*/
+
+/*
+    Jobs are run by a worker per processor. Each worker keeps the jobs it
+    submits in a deque of its own, taking the newest from the bottom while
+    idle workers steal the oldest from the top (Chase and Lev's work-stealing
+    deque). A job counts itself and its unfinished children, and waiting on a
+    job runs other jobs until the count reaches zero, rather than sleeping.
+*/
+
+/* The most jobs a worker's deque can hold. A power of two. */
+#define JOB_DEQUE_CAPACITY 4096
+
+_Static_assert(
+    (JOB_DEQUE_CAPACITY & (JOB_DEQUE_CAPACITY - 1)) == 0,
+    "JOB_DEQUE_CAPACITY must be a power of two."
+);
+
+/* The address space reserved for each worker's jobs and their data. */
+#define JOB_ARENA_SIZE Megabyte(64)
+
+/* How many times an idle worker looks for jobs before going to sleep. */
+#define JOB_IDLE_SPIN_COUNT 64
+
+struct job_worker;
+
+/**
+ * The procedure a job runs.
+ *
+ * @param[in|out]	worker	The worker running the job, for submitting more.
+ * @param[in|out]	data	The job's copy of the data it was created with.
+ */
+typedef void job_procedure(struct job_worker* worker, void* data);
+
+/* A procedure to run on one of the workers, and what it depends on. */
+typedef struct job
+{
+    job_procedure* Procedure;
+    void* Data;
+
+    /* The job that can't finish until this one has, or NULL. */
+    struct job* Parent;
+    /* The job itself, plus each of its children that hasn't finished. */
+    volatile i64 UnfinishedCount;
+}
+job;
+
+/*
+    The jobs a worker has submitted and no worker has started yet. Only the
+    owner pushes and pops at Bottom, while any worker can steal at Top.
+*/
+typedef struct job_deque
+{
+    job* volatile Jobs[JOB_DEQUE_CAPACITY];
+
+    volatile i64 Top;
+    u8 TopPadding[CACHE_LINE_SIZE - sizeof(i64)];
+
+    volatile i64 Bottom;
+    u8 BottomPadding[CACHE_LINE_SIZE - sizeof(i64)];
+}
+job_deque;
+
+/* One of the threads that jobs are run on. */
+typedef struct job_worker
+{
+    struct job_system* System;
+    size Index;
+
+    job_deque Deque;
+
+    /* Where the jobs the worker creates, and their data, are allocated. */
+    memory_arena Arena;
+
+    /* The state of the generator that picks which worker to steal from. */
+    u64 RandomState;
+
+    thread Thread;
+}
+job_worker;
+
+/* A set of workers that jobs can be spread across. */
+typedef struct job_system
+{
+    /* The workers. The first is the thread that set up the system. */
+    job_worker* Workers;
+    size WorkerCount;
+
+    /* Idle workers sleep on this until there may be jobs to steal. */
+    semaphore WakeSemaphore;
+    volatile i64 SleepingCount;
+
+    volatile bool Quitting;
+}
+job_system;
+
+/**
+ * Pushes a job onto the bottom of a worker's deque. Must only be called by
+ * the worker that owns the deque.
+ *
+ * @param[in|out]	deque	The deque to push onto.
+ * @param[in]		job		The job to push.
+ *
+ * @return	False if the deque is full, in which case the job isn't pushed.
+ */
+internal bool _JobDequePush(job_deque* deque, job* job)
+{
+    i64 bottom = deque->Bottom;
+    i64 top = AtomicLoadAcquire(&deque->Top);
+
+    if (JOB_DEQUE_CAPACITY <= bottom - top)
+        return false;
+
+    /* Thieves read the slot concurrently, so it is written atomically. */
+    size slot = bottom & (JOB_DEQUE_CAPACITY - 1);
+    AtomicStoreRelease(&deque->Jobs[slot], job);
+    AtomicStoreRelease(&deque->Bottom, bottom + 1);
+
+    return true;
+}
+
+/**
+ * Pops the newest job off the bottom of a worker's deque. Must only be called
+ * by the worker that owns the deque.
+ *
+ * @param[in|out]	deque	The deque to pop from.
+ *
+ * @return	The job, or NULL if the deque is empty.
+ */
+internal job* _JobDequePop(job_deque* deque)
+{
+    i64 bottom = deque->Bottom - 1;
+    AtomicStoreRelease(&deque->Bottom, bottom);
+
+    /* Thieves have to see the bottom move before the top is read. */
+    AtomicFence();
+
+    i64 top = AtomicLoadAcquire(&deque->Top);
+
+    if (bottom < top)
+    {
+        AtomicStoreRelease(&deque->Bottom, bottom + 1);
+        return NULL;
+    }
+
+    size slot = bottom & (JOB_DEQUE_CAPACITY - 1);
+    job* job = AtomicLoadAcquire(&deque->Jobs[slot]);
+
+    /* The last job may be being stolen, so it is taken the way thieves do. */
+    if (bottom == top)
+    {
+        if (!AtomicCompareExchange64(&deque->Top, top, top + 1))
+            job = NULL;
+
+        AtomicStoreRelease(&deque->Bottom, top + 1);
+    }
+
+    return job;
+}
+
+/**
+ * Steals the oldest job off the top of a worker's deque. Can be called by any
+ * worker.
+ *
+ * @param[in|out]	deque	The deque to steal from.
+ *
+ * @return	The job, or NULL if the deque is empty or another worker took the
+ *			job first.
+ */
+internal job* _JobDequeSteal(job_deque* deque)
+{
+    i64 top = AtomicLoadAcquire(&deque->Top);
+
+    /* The top has to be read before the bottom, as the owner pops. */
+    AtomicFence();
+
+    i64 bottom = AtomicLoadAcquire(&deque->Bottom);
+
+    if (bottom <= top)
+        return NULL;
+
+    size slot = top & (JOB_DEQUE_CAPACITY - 1);
+    job* job = AtomicLoadAcquire(&deque->Jobs[slot]);
+
+    if (!AtomicCompareExchange64(&deque->Top, top, top + 1))
+        return NULL;
+
+    return job;
+}
+
+/**
+ * Finds a job for a worker to run: the newest of its own, or else the oldest
+ * of another worker's, starting from a random one.
+ *
+ * @param[in|out]	worker	The worker looking for a job.
+ *
+ * @return	The job, or NULL if none was found.
+ */
+internal job* _FindJob(job_worker* worker)
+{
+    job* job = _JobDequePop(&worker->Deque);
+    if (job)
+        return job;
+
+    job_system* system = worker->System;
+
+    /* xorshift64, which is plenty to keep thieves from all picking the same. */
+    u64 random = worker->RandomState;
+    random ^= random << 13;
+    random ^= random >> 7;
+    random ^= random << 17;
+    worker->RandomState = random;
+
+    for (size i = 0; i < system->WorkerCount; i++)
+    {
+        size victim = (random + i) % system->WorkerCount;
+        if (victim == worker->Index)
+            continue;
+
+        job = _JobDequeSteal(&system->Workers[victim].Deque);
+        if (job)
+            return job;
+    }
+
+    return NULL;
+}
+
+/**
+ * Marks a job as finished, which finishes its parent too if that was the last
+ * thing the parent was waiting on.
+ *
+ * @param[in|out]	job	The job to finish.
+ */
+internal void _FinishJob(job* job)
+{
+    while (job)
+    {
+        /* Once the count is zero the job's memory may be reused. */
+        struct job* parent = job->Parent;
+
+        if (AtomicFetchAdd64(&job->UnfinishedCount, -1) != 1)
+            break;
+
+        job = parent;
+    }
+}
+
+/**
+ * Runs a job on the given worker, then finishes it.
+ *
+ * @param[in|out]	worker	The worker to run the job on.
+ * @param[in|out]	job		The job to run.
+ */
+internal void _RunJob(job_worker* worker, job* job)
+{
+    if (job->Procedure)
+    {
+        ProfileZone("job")
+        {
+            job->Procedure(worker, job->Data);
+        }
+    }
+
+    _FinishJob(job);
+}
+
+/**
+ * Runs jobs on one of the workers that has a thread of its own, sleeping when
+ * there are none, until the job system is torn down.
+ *
+ * @param[in|out]	parameter	The worker.
+ */
+internal void _JobWorkerThread(void* parameter)
+{
+    job_worker* worker = parameter;
+    job_system* system = worker->System;
+
+    NameProfileThread("job worker");
+
+    until (AtomicLoadAcquire(&system->Quitting))
+    {
+        job* job = NULL;
+
+        for (size i = 0; i < JOB_IDLE_SPIN_COUNT && job == NULL; i++)
+        {
+            job = _FindJob(worker);
+            if (job == NULL)
+                SpinPause();
+        }
+
+        if (job == NULL)
+        {
+            /*
+                Submitting a job checks for sleepers after pushing it, so
+                looking once more after counting ourselves as asleep means
+                that either we find the job or the submitter wakes us.
+            */
+            AtomicFetchAdd64(&system->SleepingCount, 1);
+
+            job = _FindJob(worker);
+            if (job == NULL && !AtomicLoadAcquire(&system->Quitting))
+                WaitOnSemaphore(&system->WakeSemaphore);
+
+            AtomicFetchAdd64(&system->SleepingCount, -1);
+        }
+
+        if (job)
+            _RunJob(worker, job);
+    }
+}
+
+/**
+ * Initializes a job system, starting a thread for every worker but the first,
+ * which is the calling thread. If a thread can't be started, the system makes
+ * do with the workers it has.
+ *
+ * @param[out]		system		The job system to setup.
+ * @param[in|out]	arena		The arena to allocate the workers from.
+ * @param[in]		workerCount	The number of workers, or 0 for one per
+ *								processor.
+ */
+internal void SetupJobSystem(
+    job_system* system,
+    memory_arena* arena,
+    size workerCount
+)
+{
+    if (workerCount == 0)
+        workerCount = GetProcessorCount();
+
+    *system = (struct job_system){
+        .Workers = PushArrayTagged(
+            arena, job_worker, workerCount, ALLOCATION_TAG_JOBS
+        ),
+        .WorkerCount = workerCount,
+
+        .SleepingCount = 0,
+        .Quitting = false,
+    };
+
+    SetupSemaphore(&system->WakeSemaphore, 0);
+
+    for (size i = 0; i < workerCount; i++)
+    {
+        job_worker* worker = &system->Workers[i];
+
+        worker->System = system;
+        worker->Index = i;
+
+        worker->Deque.Top = 0;
+        worker->Deque.Bottom = 0;
+
+        SetupMemoryArena(&worker->Arena, JOB_ARENA_SIZE, ARENA_FLAGS_NONE);
+
+        /* Any odd number will do, as long as each worker's is different. */
+        worker->RandomState = 0x9E3779B97F4A7C15ull * (i + 1) | 1;
+    }
+
+    for (size i = 1; i < workerCount; i++)
+    {
+        job_worker* worker = &system->Workers[i];
+
+        if (!StartThread(&worker->Thread, _JobWorkerThread, worker))
+        {
+            /* The workers without threads never use their arenas. */
+            for (size j = i; j < workerCount; j++)
+                TeardownMemoryArena(&system->Workers[j].Arena);
+
+            system->WorkerCount = i;
+            break;
+        }
+    }
+}
+
+/**
+ * Stops the job system's threads once they have finished the jobs they are
+ * running. Jobs that haven't been started are never run.
+ *
+ * @param[in|out]	system	The job system to teardown.
+ */
+internal void TeardownJobSystem(job_system* system)
+{
+    AtomicStoreRelease(&system->Quitting, true);
+    SignalSemaphore(&system->WakeSemaphore, (u32)system->WorkerCount);
+
+    for (size i = 1; i < system->WorkerCount; i++)
+        JoinThread(&system->Workers[i].Thread);
+
+    for (size i = 0; i < system->WorkerCount; i++)
+        TeardownMemoryArena(&system->Workers[i].Arena);
+
+    TeardownSemaphore(&system->WakeSemaphore);
+}
+
+/**
+ * Gets the worker that stands for the thread that set up the job system.
+ *
+ * @param[in]	system	The job system.
+ *
+ * @return	The worker to submit and wait on jobs with from that thread.
+ */
+internal inline job_worker* MainJobWorker(job_system* system)
+{
+    return &system->Workers[0];
+}
+
+/**
+ * Creates a job, copying its data into the worker's arena. The job isn't run
+ * until it is submitted.
+ *
+ * @param[in|out]	worker		The worker creating the job.
+ * @param[in]		procedure	The procedure for the job to run, or NULL for a
+ *								job that only waits on its children.
+ * @param[in]		data		The data to pass to the procedure, or NULL.
+ * @param[in]		dataSize	The size of the data.
+ * @param[in|out]	parent		The job that can't finish until this one has,
+ *								or NULL.
+ *
+ * @return	The job.
+ */
+internal job* CreateJob(
+    job_worker* worker,
+    job_procedure* procedure,
+    const void* data,
+    size dataSize,
+    job* parent
+)
+{
+    job* job = PushSizeTagged(
+        &worker->Arena,
+        sizeof(struct job) + dataSize,
+        DEFAULT_ALIGNMENT,
+        ALLOCATION_TAG_JOBS
+    );
+
+    job->Procedure = procedure;
+    job->Data = NULL;
+    job->Parent = parent;
+    job->UnfinishedCount = 1;
+
+    if (0 < dataSize)
+    {
+        job->Data = (u8*)job + sizeof(struct job);
+        MemoryCopy(job->Data, data, dataSize);
+    }
+
+    if (parent)
+        AtomicFetchAdd64(&parent->UnfinishedCount, 1);
+
+    return job;
+}
+
+/**
+ * Hands a job over to be run by whichever worker gets to it first. If the
+ * worker's deque is full, the job is run right away instead.
+ *
+ * @param[in|out]	worker	The worker submitting the job.
+ * @param[in|out]	job		The job to submit.
+ */
+internal void SubmitJob(job_worker* worker, job* job)
+{
+    if (!_JobDequePush(&worker->Deque, job))
+    {
+        _RunJob(worker, job);
+        return;
+    }
+
+    job_system* system = worker->System;
+
+    /* Pairs with the sleeping count being raised before the final look. */
+    AtomicFence();
+
+    if (0 < AtomicLoadAcquire(&system->SleepingCount))
+        SignalSemaphore(&system->WakeSemaphore, 1);
+}
+
+/**
+ * Checks whether a job, and every one of its children, has finished.
+ *
+ * @param[in]	job	The job to check.
+ *
+ * @return	True if the job has finished.
+ */
+internal inline bool JobIsFinished(job* job)
+{
+    return AtomicLoadAcquire(&job->UnfinishedCount) == 0;
+}
+
+/**
+ * Runs jobs on the given worker until the given job, and every one of its
+ * children, has finished.
+ *
+ * @param[in|out]	worker	The worker to run jobs on while waiting.
+ * @param[in]		job		The job to wait for.
+ */
+internal void WaitForJob(job_worker* worker, job* job)
+{
+    until (JobIsFinished(job))
+    {
+        struct job* next = _FindJob(worker);
+
+        if (next)
+            _RunJob(worker, next);
+
+        else
+            SpinPause();
+    }
+}
+
+/**
+ * Frees the memory of every job created so far, for reuse. Must only be called
+ * from the first worker's thread, once every job has finished.
+ *
+ * @param[in|out]	system	The job system.
+ */
+internal void ResetJobMemory(job_system* system)
+{
+    for (size i = 0; i < system->WorkerCount; i++)
+        ResetMemoryArena(&system->Workers[i].Arena);
+}
+
+/*
+    END JOBS
+*/
+
+#endif
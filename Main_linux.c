@@ -0,0 +1,1862 @@
+#define _GNU_SOURCE
+
+/*
+    The system headers must come before our own, as Standard.h redefines a
+    number of common identifiers (size, bool, etc.) as macros.
+*/
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Standard.h"
+#include "Platform.h"
+
+#include "./Ontologic.c"
+
+typedef struct platform
+{
+    i32 StandardOutput;
+    i32 StandardError;
+    i32 StandardInput;
+
+    /* The terminal mode we found at startup, restored when exiting. */
+    struct termios OriginalTerminalMode;
+    bool TerminalModeChanged;
+
+    /* The buffer BlitConsoleFrame assembles each frame into before writing. */
+    char* FrameBuffer;
+    size FrameBufferSize;
+
+    /* The thread that blits frames, so that slow writes never hold up input. */
+    thread OutputThread;
+    /* Signaled when there may be a frame for the output thread to blit. */
+    semaphore FrameSemaphore;
+    volatile bool OutputQuitting;
+
+    /* Where the terminal's cursor is, or -1 when we can't be sure. */
+    i32 TerminalCursorTop;
+    i32 TerminalCursorLeft;
+    /* Whether the terminal's cursor is currently shown. */
+    bool TerminalCursorVisible;
+    /* The colors and attributes the terminal is currently drawing with. */
+    u8 TerminalForeground;
+    u8 TerminalBackground;
+    u8 TerminalAttributes;
+
+    /* The start of a character that the last read of input cut short. */
+    char PendingInput[UTF8_MAX_LENGTH - 1];
+    size PendingInputLength;
+
+    /* A pipe written to by WakeFromWait to interrupt WaitForEvents. */
+    i32 WakeReadEnd;
+    i32 WakeWriteEnd;
+}
+platform;
+
+global platform Platform;
+
+/**
+ * Writes the entire buffer to the given file descriptor, retrying on partial
+ * writes and interruptions.
+ *
+ * @param[in]	fileDescriptor	The file descriptor to write to.
+ * @param[in]	buffer			The bytes to write.
+ * @param[in]	bufferSize		The number of bytes to write.
+ *
+ * @return	True if every byte was written, false if writing failed.
+ */
+internal
+bool WriteAll(i32 fileDescriptor, const char* buffer, size bufferSize)
+{
+    while (0 < bufferSize)
+    {
+        ssize_t bytesWritten = write(fileDescriptor, buffer, bufferSize);
+
+        if (bytesWritten < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+
+            return false;
+        }
+
+        buffer += bytesWritten;
+        bufferSize -= bytesWritten;
+    }
+
+    return true;
+}
+
+/**
+ * Puts the terminal back the way we found it: leaves the alternate screen,
+ * shows the cursor, and restores the original terminal mode. Safe to call more
+ * than once.
+ */
+internal
+void RestoreTerminal(void)
+{
+    if (Platform.TerminalModeChanged)
+    {
+        char restore[] = "\x1b[0m\x1b[?25h\x1b[?1049l";
+        WriteAll(Platform.StandardOutput, restore, sizeof(restore) - 1);
+
+        tcsetattr(
+            Platform.StandardInput,
+            TCSAFLUSH,
+            &Platform.OriginalTerminalMode
+        );
+
+        Platform.TerminalModeChanged = false;
+    }
+}
+
+void Exit(exit_code code)
+{
+    RestoreTerminal();
+    _exit(code);
+}
+
+void _Assert(
+    const bool predicate,
+    const char* expression,
+    const size expressionLength,
+    const char* fileName,
+    const size fileNameLength,
+    const size line
+)
+{
+    if (!predicate)
+    {
+        RestoreTerminal();
+
+        char lineString[32];
+        size lineStringLength = ItoA(lineString, sizeof(lineString), line);
+
+        WriteAll(Platform.StandardError, "Assertion \"", 11);
+        WriteAll(Platform.StandardError, expression, expressionLength);
+        WriteAll(Platform.StandardError, "\" on line ", 10);
+        WriteAll(Platform.StandardError, lineString, lineStringLength);
+        WriteAll(Platform.StandardError, " in file \"", 10);
+        WriteAll(Platform.StandardError, fileName, fileNameLength);
+        WriteAll(Platform.StandardError, "\" failed.\n", 10);
+
+        Exit(EXIT_ASSERT_FAILED);
+    }
+}
+
+void _AssertWithMessage(
+    bool predicate,
+    const char* message,
+    const size messageSize
+)
+{
+    if (!predicate)
+    {
+        RestoreTerminal();
+
+        WriteAll(Platform.StandardError, message, messageSize);
+        WriteAll(Platform.StandardError, "\n", 1);
+
+        Exit(EXIT_ASSERT_FAILED);
+    }
+}
+
+void _Abort(exit_code code, const char* message, const size messageSize)
+{
+    RestoreTerminal();
+
+    WriteAll(Platform.StandardError, message, messageSize);
+    WriteAll(Platform.StandardError, "\n", 1);
+
+    Exit(code);
+}
+
+global memory_arena MemoryArena;
+
+/* Scratch memory that is freed at the end of every frame. */
+global memory_arena FrameArena;
+
+/*
+    Pages are committed in chunks of this size, so that only the occasional
+    allocation needs a system call.
+*/
+#define ARENA_COMMIT_GRANULARITY Kilobyte(64)
+
+/* The size of a transparent huge page on the platforms we run on. */
+#define HUGE_PAGE_SIZE Megabyte(2)
+
+void SetupMemoryArena(
+    memory_arena* arena,
+    const size arenaSize,
+    const memory_arena_flags flags
+)
+{
+    /*
+        PROT_NONE pages are only address space: they cost nothing until they
+        are committed with mprotect.
+    */
+    arena->Start = mmap(
+        NULL,
+        arenaSize,
+        PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+        -1,
+        0
+    );
+
+    AssertWithMessage(
+        arena->Start != MAP_FAILED,
+        "Not enough address space available to initialize."
+    );
+
+    /* This is only a hint, so there's nothing to do if it isn't supported. */
+    if (flags & ARENA_FLAGS_HUGE_PAGES)
+        madvise(arena->Start, arenaSize, MADV_HUGEPAGE);
+
+    arena->Cursor = arena->Start;
+    arena->Size = arenaSize;
+    arena->CommittedSize = 0;
+    arena->Flags = flags;
+    arena->TemporaryCount = 0;
+    arena->Stats = (memory_arena_stats){ 0 };
+}
+
+/**
+ * Commits enough pages that the first requiredSize bytes of the arena can be
+ * used.
+ *
+ * @param[in|out]	arena			The arena to commit pages for.
+ * @param[in]		requiredSize	The number of bytes that must be usable.
+ */
+internal
+void CommitMemoryArena(memory_arena* arena, size requiredSize)
+{
+    size granularity = (arena->Flags & ARENA_FLAGS_HUGE_PAGES)
+        ? HUGE_PAGE_SIZE
+        : ARENA_COMMIT_GRANULARITY;
+
+    size newCommittedSize =
+        (requiredSize + (granularity - 1)) & ~(granularity - 1);
+
+    if (arena->Size < newCommittedSize)
+        newCommittedSize = arena->Size;
+
+    i32 result = mprotect(
+        (void*)((size)arena->Start + arena->CommittedSize),
+        newCommittedSize - arena->CommittedSize,
+        PROT_READ | PROT_WRITE
+    );
+
+    if (result != 0)
+    {
+        Abort(
+            EXIT_SYSTEM_OUT_OF_MEMORY,
+            "Unable to commit memory for the arena."
+        );
+    }
+
+    arena->CommittedSize = newCommittedSize;
+}
+
+/**
+ * Gives all of the arena's committed pages back to the host.
+ *
+ * @param[in|out]	arena	The arena to decommit the pages of.
+ */
+internal
+void DecommitMemoryArena(memory_arena* arena)
+{
+    if (0 < arena->CommittedSize)
+    {
+        madvise(arena->Start, arena->CommittedSize, MADV_DONTNEED);
+        mprotect(arena->Start, arena->CommittedSize, PROT_NONE);
+
+        arena->CommittedSize = 0;
+    }
+}
+
+void TeardownMemoryArena(memory_arena* arena)
+{
+    munmap(arena->Start, arena->Size);
+}
+
+/**
+ * Aborts the process after running out of memory, reporting what was being
+ * allocated and how the arena was being used at the time.
+ *
+ * @param[in]	arena			The arena that ran out of memory.
+ * @param[in]	allocationSize	The size of the allocation that failed.
+ * @param[in]	tag				The tag of the allocation that failed.
+ * @param[in]	filepath		The path to the file making the allocation.
+ * @param[in]	line			The line of the file making the allocation.
+ */
+internal
+void AbortOutOfMemory(
+    memory_arena* arena,
+    const size allocationSize,
+    const allocation_tag tag,
+    const char* filepath,
+    const size line
+)
+{
+    persist struct { const char* Name; size Length; } tagNames[] = {
+#define _(TAG) { #TAG, sizeof(#TAG) - 1 },
+        ALLOCATION_TAGS
+#undef _
+    };
+
+    /*
+        The message is built in the other arena, which is unlikely to have run
+        out as well. If it has, there is nowhere left to build it.
+    */
+    persist bool isAborting = false;
+    if (isAborting)
+        Abort(EXIT_SYSTEM_OUT_OF_MEMORY, "Ran out of available memory.");
+
+    isAborting = true;
+
+    memory_arena* messageArena = arena == &FrameArena
+        ? &MemoryArena
+        : &FrameArena;
+
+    string_builder message;
+    SetupStringBuilder(&message, messageArena, 256, ALLOCATION_TAG_SCRATCH);
+
+    char format[] =
+        "Aborted: Ran out of available memory allocating %u bytes (%s) at "
+        "%s:%u. In use: %u bytes, high-water mark: %u bytes, reserved: %u "
+        "bytes.\n";
+
+    StringBuilderAppendF(
+        &message,
+        format, sizeof(format) - 1,
+        allocationSize,
+        MakeString(tagNames[tag].Name, tagNames[tag].Length),
+        filepath,
+        line,
+        (size)arena->Cursor - (size)arena->Start,
+        arena->Stats.HighWaterMark,
+        arena->Size
+    );
+
+    _Abort(EXIT_SYSTEM_OUT_OF_MEMORY, message.Data, message.Length);
+}
+
+void* _Allocate(
+    const size allocationSize,
+    const allocation_tag tag,
+    const char* filepath,
+    const size line
+)
+{
+    return _PushSize(
+        &MemoryArena,
+        allocationSize,
+        DEFAULT_ALIGNMENT,
+        tag,
+        filepath,
+        line
+    );
+}
+
+memory_arena* GetGlobalMemoryArena(void)
+{
+    return &MemoryArena;
+}
+
+void* _PushSize(
+    memory_arena* arena,
+    const size allocationSize,
+    const size alignment,
+    const allocation_tag tag,
+    const char* filepath,
+    const size line
+)
+{
+    Assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+    Assert(tag < ALLOCATION_TAG_COUNT);
+
+    size arenaEnd = (size)arena->Start + arena->Size;
+    size alignedCursor =
+        ((size)arena->Cursor + (alignment - 1)) & ~(alignment - 1);
+
+    if (alignedCursor <= arenaEnd && allocationSize <= arenaEnd - alignedCursor)
+    {
+        size usedSize = alignedCursor + allocationSize - (size)arena->Start;
+        if (arena->CommittedSize < usedSize)
+            CommitMemoryArena(arena, usedSize);
+
+        arena->Cursor = (void*)(alignedCursor + allocationSize);
+
+        memory_arena_stats* stats = &arena->Stats;
+        stats->TagBytes[tag] += allocationSize;
+        stats->TagCounts[tag]++;
+        stats->FrameAllocationCount++;
+        stats->FrameAllocatedBytes += allocationSize;
+
+        if (stats->HighWaterMark < usedSize)
+            stats->HighWaterMark = usedSize;
+
+        return (void*)alignedCursor;
+    }
+    else
+    {
+        AbortOutOfMemory(arena, allocationSize, tag, filepath, line);
+
+        return NULL;
+    }
+}
+
+temporary_memory BeginTemporaryMemory(memory_arena* arena)
+{
+    arena->TemporaryCount++;
+
+    return (temporary_memory){
+        .Arena = arena,
+        .Cursor = arena->Cursor,
+    };
+}
+
+void EndTemporaryMemory(temporary_memory temporaryMemory)
+{
+    memory_arena* arena = temporaryMemory.Arena;
+
+    Assert(0 < arena->TemporaryCount);
+    Assert(
+        (size)arena->Start <= (size)temporaryMemory.Cursor
+        && (size)temporaryMemory.Cursor <= (size)arena->Cursor
+    );
+
+    arena->Cursor = temporaryMemory.Cursor;
+    arena->TemporaryCount--;
+}
+
+void ResetMemoryArena(memory_arena* arena)
+{
+    Assert(arena->TemporaryCount == 0);
+
+    arena->Cursor = arena->Start;
+
+    if (arena->Flags & ARENA_FLAGS_DECOMMIT_ON_RESET)
+        DecommitMemoryArena(arena);
+}
+
+size ReadEnvironmentVariable(
+    const char* name,
+    char* buffer,
+    const size bufferSize
+)
+{
+    const char* value = getenv(name);
+    if (value == NULL)
+        return 0;
+
+    size valueLength = 0;
+    while (value[valueLength] != '\0')
+        valueLength++;
+
+    if (bufferSize <= valueLength)
+        return 0;
+
+    for (size i = 0; i <= valueLength; i++)
+        buffer[i] = value[i];
+
+    return valueLength;
+}
+
+bool WriteEntireFile(const char* path, const void* data, const size dataSize)
+{
+    i32 fileDescriptor = open(
+        path,
+        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+        0644
+    );
+
+    if (fileDescriptor < 0)
+        return false;
+
+    bool written = WriteAll(fileDescriptor, data, dataSize);
+
+    return close(fileDescriptor) == 0 && written;
+}
+
+bool OpenReadOnlyFile(file* file, const char* path)
+{
+    i32 fileDescriptor = open(path, O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor < 0)
+        return false;
+
+    *file = (struct file){
+        .Data = NULL,
+        .Size = 0,
+
+        .Handle = fileDescriptor,
+    };
+
+    struct stat status;
+    if (fstat(fileDescriptor, &status) != 0 || !S_ISREG(status.st_mode))
+        return true;
+
+    /* Empty files can't be mapped, but there is nothing to read either. */
+    if (status.st_size == 0)
+        file->Data = "";
+
+    else
+    {
+        void* data = mmap(
+            NULL,
+            status.st_size,
+            PROT_READ,
+            MAP_PRIVATE,
+            fileDescriptor,
+            0
+        );
+
+        if (data == MAP_FAILED)
+            return true;
+
+        file->Data = data;
+        file->Size = status.st_size;
+    }
+
+    /* The mapping keeps the file open on its own. */
+    close(fileDescriptor);
+    file->Handle = (size)-1;
+
+    return true;
+}
+
+size ReadFileStream(file* file, void* buffer, const size bufferSize)
+{
+    if (file->Data != NULL)
+        return 0;
+
+    ssize_t bytesRead;
+    do
+        bytesRead = read((i32)file->Handle, buffer, bufferSize);
+    while (bytesRead < 0 && errno == EINTR);
+
+    return 0 < bytesRead ? bytesRead : 0;
+}
+
+void CloseReadOnlyFile(file* file)
+{
+    if (file->Data != NULL && 0 < file->Size)
+        munmap((void*)file->Data, file->Size);
+
+    if (file->Data == NULL)
+        close((i32)file->Handle);
+
+    file->Data = NULL;
+    file->Size = 0;
+}
+
+/*
+    Moving the cursor costs at most this many bytes, so unchanged runs shorter
+    than this are cheaper to rewrite than to skip over.
+*/
+#define CURSOR_MOVE_COST 8
+
+/**
+ * Computes how many bytes a single frame can take up in the frame buffer.
+ *
+ * @param[in]	width	The width of the console, in cells.
+ * @param[in]	height	The height of the console, in cells.
+ *
+ * @return	The size of the frame buffer needed to blit the console.
+ */
+internal
+size FrameBufferSizeFor(size width, size height)
+{
+    /*
+        Every span is at least one cell long and followed by more than
+        CURSOR_MOVE_COST unchanged cells, so a row holds at most one cursor
+        move (at most 14 bytes) per 1 + CURSOR_MOVE_COST cells.
+    */
+    size maxSpansPerRow = width / (1 + CURSOR_MOVE_COST) + 1;
+
+    /*
+        A cell's character takes at most UTF8_MAX_LENGTH bytes, and it can also
+        change the colors and attributes, which takes at most 18 more.
+    */
+    size maxCellSize = UTF8_MAX_LENGTH + 18;
+
+    /* Moving the caret into place and showing or hiding it takes 20 more. */
+    return height * (width * maxCellSize + 14 * maxSpansPerRow) + 20;
+}
+
+/**
+ * Appends the shortest escape sequence that moves the terminal's cursor to the
+ * given cell, if it isn't already there.
+ *
+ * @param[in|out]	frame		The frame buffer to append to.
+ * @param[in]		frameSize	The number of bytes already in the frame.
+ * @param[in]		top			The row to move to.
+ * @param[in]		left		The column to move to.
+ *
+ * @return	The number of bytes now in the frame.
+ */
+internal
+size AppendCursorMove(char* frame, size frameSize, i32 top, i32 left)
+{
+    if (Platform.TerminalCursorTop == top
+        && Platform.TerminalCursorLeft == left)
+        return frameSize;
+
+    frame[frameSize++] = '\x1b';
+    frame[frameSize++] = '[';
+
+    if (Platform.TerminalCursorTop == top
+        && Platform.TerminalCursorLeft != -1
+        && Platform.TerminalCursorLeft < left)
+    {
+        /* Same row, further right: a relative move is shorter. */
+        frameSize += ItoA(
+            &frame[frameSize], 5, left - Platform.TerminalCursorLeft
+        );
+        frame[frameSize++] = 'C';
+    }
+
+    else
+    {
+        frameSize += ItoA(&frame[frameSize], 5, top + 1);
+        frame[frameSize++] = ';';
+        frameSize += ItoA(&frame[frameSize], 5, left + 1);
+        frame[frameSize++] = 'H';
+    }
+
+    Platform.TerminalCursorTop = top;
+    Platform.TerminalCursorLeft = left;
+
+    return frameSize;
+}
+
+/**
+ * Appends the SGR sequence that switches the terminal to drawing with the
+ * given colors and attributes. Only what differs from what the terminal draws
+ * with now is named, and nothing is appended if nothing differs.
+ *
+ * @param[in|out]	frame		The frame buffer to append to.
+ * @param[in]		frameSize	The number of bytes already in the frame.
+ * @param[in]		foreground	The console_color to draw characters in.
+ * @param[in]		background	The console_color to draw behind them.
+ * @param[in]		attributes	The console_attribute flags to draw with.
+ *
+ * @return	The number of bytes in the frame afterward.
+ */
+internal
+size AppendStyleChange(
+    char* frame,
+    size frameSize,
+    u8 foreground,
+    u8 background,
+    u8 attributes
+)
+{
+    persist const struct { u8 Flag; u8 On; u8 Off; } attributeCodes[] = {
+        { CONSOLE_ATTRIBUTE_BOLD, 1, 22 },
+        { CONSOLE_ATTRIBUTE_UNDERLINE, 4, 24 },
+        { CONSOLE_ATTRIBUTE_HIGHLIGHT, 7, 27 },
+    };
+
+    u8 changedAttributes = attributes ^ Platform.TerminalAttributes;
+
+    if (changedAttributes == 0
+        && foreground == Platform.TerminalForeground
+        && background == Platform.TerminalBackground)
+        return frameSize;
+
+    frame[frameSize++] = '\x1b';
+    frame[frameSize++] = '[';
+
+    /* Every parameter is followed by ';', and the last one becomes 'm'. */
+    for (size i = 0; i < ArrayCount(attributeCodes); i++)
+    {
+        if ((changedAttributes & attributeCodes[i].Flag) == 0)
+            continue;
+
+        u8 code = attributes & attributeCodes[i].Flag
+            ? attributeCodes[i].On
+            : attributeCodes[i].Off;
+
+        frameSize += U64toA(&frame[frameSize], 2, code);
+        frame[frameSize++] = ';';
+    }
+
+    if (foreground != Platform.TerminalForeground)
+    {
+        u32 code = foreground == CONSOLE_COLOR_DEFAULT ? 39
+            : foreground < CONSOLE_COLOR_BRIGHT_BLACK
+                ? 30 + (foreground - CONSOLE_COLOR_BLACK)
+                : 90 + (foreground - CONSOLE_COLOR_BRIGHT_BLACK);
+
+        frameSize += U64toA(&frame[frameSize], 2, code);
+        frame[frameSize++] = ';';
+    }
+
+    if (background != Platform.TerminalBackground)
+    {
+        u32 code = background == CONSOLE_COLOR_DEFAULT ? 49
+            : background < CONSOLE_COLOR_BRIGHT_BLACK
+                ? 40 + (background - CONSOLE_COLOR_BLACK)
+                : 100 + (background - CONSOLE_COLOR_BRIGHT_BLACK);
+
+        frameSize += U64toA(&frame[frameSize], 3, code);
+        frame[frameSize++] = ';';
+    }
+
+    frame[frameSize - 1] = 'm';
+
+    Platform.TerminalForeground = foreground;
+    Platform.TerminalBackground = background;
+    Platform.TerminalAttributes = attributes;
+
+    return frameSize;
+}
+
+/**
+ * "Blits" a frame of the console to the terminal. Only the rows flagged as
+ * dirty, or that were showing anything, are inspected, and only the cells that
+ * differ from the front buffer are sent, so a frame with no changes produces
+ * no output at all. Only called on the output thread.
+ *
+ * @param[in|out]	console			The console the frame belongs to.
+ * @param[in|out]	consoleFrame	The frame to blit.
+ *
+ * @return	The number of bytes sent to the terminal.
+ */
+internal
+size BlitConsoleFrame(console* console, console_frame* consoleFrame)
+{
+    console_cells* cells = &consoleFrame->Cells;
+    console_cells* frontCells = &console->FrontCells;
+
+    char* frame = Platform.FrameBuffer;
+    size frameSize = 0;
+
+    size width = console->BufferWidth;
+
+    for (size y = 0; y < console->BufferHeight; y++)
+    {
+        /* Rows that were showing anything may have to be blanked. */
+        u64 rows = consoleFrame->DirtyRows[y / 64] | console->ShownRows[y / 64];
+
+        if (rows == 0)
+        {
+            y += 63 - (y % 64);
+            continue;
+        }
+
+        if ((rows & (1ull << (y % 64))) == 0)
+            continue;
+
+        size rowStart = y * width;
+        u32* row = &cells->Glyphs[rowStart];
+
+        size x = 0;
+        while (x < width)
+        {
+            if (!ConsoleCellChanged(console, cells, rowStart + x))
+            {
+                x++;
+                continue;
+            }
+
+            /* Half of a wide character is redrawn by drawing all of it. */
+            if (row[x] == CONSOLE_CELL_WIDE_TAIL && 0 < x)
+                x--;
+
+            /*
+                Grow the span over any unchanged gaps that are cheaper to
+                rewrite than to move the cursor past.
+            */
+            size spanEnd = x + 1;
+            size gap = 0;
+            for (size i = spanEnd; i < width && gap <= CURSOR_MOVE_COST; i++)
+            {
+                if (ConsoleCellChanged(console, cells, rowStart + i))
+                {
+                    spanEnd = i + 1;
+                    gap = 0;
+                }
+
+                else
+                    gap++;
+            }
+
+            /* A wide character at the end of the span moves past its tail. */
+            if (spanEnd < width && row[spanEnd] == CONSOLE_CELL_WIDE_TAIL)
+                spanEnd++;
+
+            frameSize = AppendCursorMove(frame, frameSize, y, x);
+
+            size spanStart = rowStart + x;
+            size spanLength = spanEnd - x;
+
+            for (; x < spanEnd; x++)
+            {
+                u32 c = row[x];
+
+                /* The terminal covers the tail when it draws the character. */
+                if (c == CONSOLE_CELL_WIDE_TAIL)
+                    continue;
+
+                /* Only the changes between cells are sent, not every cell's. */
+                frameSize = AppendStyleChange(
+                    frame, frameSize,
+                    cells->Foregrounds[rowStart + x],
+                    cells->Backgrounds[rowStart + x],
+                    cells->Attributes[rowStart + x]
+                );
+
+                /*
+                    Anything the terminal would interpret rather than print has
+                    to be replaced, otherwise it would corrupt the rest of the
+                    frame.
+                */
+                if (c == '\0')
+                    c = ' ';
+
+                else if (c < ' ' || ('\x7f' <= c && c < 0xA0))
+                    c = '?';
+
+                if (c < 0x80)
+                    frame[frameSize++] = (char)c;
+
+                else
+                    frameSize += Utf8Encode(c, &frame[frameSize]);
+            }
+
+            /*
+                Writing into the last column leaves the cursor in a state that
+                differs between terminals, so forget where it is.
+            */
+            Platform.TerminalCursorLeft = spanEnd < width ? (i32)spanEnd : -1;
+
+            MemoryCopy(
+                &frontCells->Glyphs[spanStart],
+                &cells->Glyphs[spanStart],
+                sizeof(u32) * spanLength
+            );
+            MemoryCopy(
+                &frontCells->Foregrounds[spanStart],
+                &cells->Foregrounds[spanStart],
+                spanLength
+            );
+            MemoryCopy(
+                &frontCells->Backgrounds[spanStart],
+                &cells->Backgrounds[spanStart],
+                spanLength
+            );
+            MemoryCopy(
+                &frontCells->Attributes[spanStart],
+                &cells->Attributes[spanStart],
+                spanLength
+            );
+        }
+    }
+
+    /*
+        The frame was cleared before it was drawn, so only the rows written to
+        can have been left showing anything.
+    */
+    for (size i = 0; i < DirtyRowWordCount(console->BufferHeight); i++)
+    {
+        console->ShownRows[i] = consoleFrame->DirtyRows[i];
+        consoleFrame->DirtyRows[i] = 0;
+    }
+
+    i16 caretTop = consoleFrame->CaretTop;
+    i16 caretLeft = consoleFrame->CaretLeft;
+
+    bool caretVisible = 0 <= caretTop && 0 <= caretLeft
+        && (size)caretTop < console->BufferHeight
+        && (size)caretLeft < width;
+
+    if (caretVisible)
+        frameSize = AppendCursorMove(frame, frameSize, caretTop, caretLeft);
+
+    if (caretVisible != Platform.TerminalCursorVisible)
+    {
+        char* sequence = caretVisible ? "\x1b[?25h" : "\x1b[?25l";
+        for (size i = 0; i < 6; i++)
+            frame[frameSize++] = sequence[i];
+
+        Platform.TerminalCursorVisible = caretVisible;
+    }
+
+    Assert(frameSize <= Platform.FrameBufferSize);
+
+    if (0 < frameSize)
+        WriteAll(Platform.StandardOutput, frame, frameSize);
+
+    return frameSize;
+}
+
+/**
+ * Blits each frame that PresentConsole hands over, until told to quit. Run on
+ * a thread of its own, as writing to the terminal can take as long as whatever
+ * is at the other end takes to read it.
+ *
+ * @param[in|out]	parameter	The console to blit frames of.
+ */
+internal
+void ConsoleOutputThread(void* parameter)
+{
+    console* console = parameter;
+
+    NameProfileThread("output");
+
+    bool quitting = false;
+    until (quitting)
+    {
+        WaitOnSemaphore(&Platform.FrameSemaphore);
+
+        /* Frames presented before quitting still get blitted. */
+        quitting = AtomicLoadAcquire(&Platform.OutputQuitting);
+
+        i64 pending = AtomicLoadAcquire(&console->PendingFrame);
+        if ((pending & CONSOLE_FRAME_FRESH) == 0)
+            continue;
+
+        /* The frame just blitted is the one left waiting, to be drawn over. */
+        pending = AtomicExchange64(
+            &console->PendingFrame, (i64)console->BlittingFrame
+        );
+
+        console->BlittingFrame = (size)(pending & ~CONSOLE_FRAME_FRESH);
+        console_frame* frame = &console->Frames[console->BlittingFrame];
+
+        u64 blitStart = ReadClock();
+
+        ProfileZone("blit")
+        {
+            frame->BlitSize = BlitConsoleFrame(console, frame);
+        }
+
+        frame->BlitDuration = ReadClock() - blitStart;
+        frame->Blitted = true;
+    }
+}
+
+void PresentConsole(console* console)
+{
+    console->Frames[console->DrawingFrame] = (console_frame){
+        .Cells = console->Cells,
+        .DirtyRows = console->DirtyRows,
+
+        .CaretTop = console->CaretTop,
+        .CaretLeft = console->CaretLeft,
+    };
+
+    i64 previous = AtomicExchange64(
+        &console->PendingFrame,
+        (i64)console->DrawingFrame | CONSOLE_FRAME_FRESH
+    );
+
+    /* Drawing carries on in whichever frame was waiting before. */
+    console->DrawingFrame = (size)(previous & ~CONSOLE_FRAME_FRESH);
+    console->Cells = console->Frames[console->DrawingFrame].Cells;
+    console->DirtyRows = console->Frames[console->DrawingFrame].DirtyRows;
+
+    console->PresentedFrameCount++;
+
+    /*
+        A frame still waiting was never taken, and the output thread has yet to
+        wake up for it, so it takes this one instead.
+    */
+    if (previous & CONSOLE_FRAME_FRESH)
+        console->DroppedFrameCount++;
+
+    else
+        SignalSemaphore(&Platform.FrameSemaphore, 1);
+}
+
+/**
+ * Starts the thread that blits the frames of the given console.
+ *
+ * @param[in|out]	console	The console to blit frames of. It must stay where
+ *							it is until StopConsoleOutput.
+ */
+internal
+void StartConsoleOutput(console* console)
+{
+    SetupSemaphore(&Platform.FrameSemaphore, 0);
+    Platform.OutputQuitting = false;
+
+    if (!StartThread(&Platform.OutputThread, ConsoleOutputThread, console))
+    {
+        Abort(
+            EXIT_COULD_NOT_START_THREAD,
+            "Unable to start the thread that writes to the terminal."
+        );
+    }
+}
+
+/**
+ * Stops the thread that blits frames, once it has blitted the last frame
+ * presented.
+ */
+internal
+void StopConsoleOutput(void)
+{
+    AtomicStoreRelease(&Platform.OutputQuitting, true);
+    SignalSemaphore(&Platform.FrameSemaphore, 1);
+
+    JoinThread(&Platform.OutputThread);
+
+    TeardownSemaphore(&Platform.FrameSemaphore);
+}
+
+/**
+ * Allocates the arrays for the given number of console cells, and blanks every
+ * cell.
+ *
+ * @param[in]	cellCount	The number of cells to allocate.
+ *
+ * @return	The blank cells.
+ */
+internal
+console_cells AllocateConsoleCells(size cellCount)
+{
+    console_cells cells = {
+        .Glyphs = AllocateTagged(
+            sizeof(u32) * cellCount, ALLOCATION_TAG_CONSOLE
+        ),
+        .Foregrounds = AllocateTagged(cellCount, ALLOCATION_TAG_CONSOLE),
+        .Backgrounds = AllocateTagged(cellCount, ALLOCATION_TAG_CONSOLE),
+        .Attributes = AllocateTagged(cellCount, ALLOCATION_TAG_CONSOLE),
+    };
+
+    MemoryFill32(cells.Glyphs, '\0', cellCount);
+    MemoryFill(cells.Foregrounds, CONSOLE_COLOR_DEFAULT, cellCount);
+    MemoryFill(cells.Backgrounds, CONSOLE_COLOR_DEFAULT, cellCount);
+    MemoryFill(cells.Attributes, CONSOLE_ATTRIBUTE_NONE, cellCount);
+
+    return cells;
+}
+
+/**
+ * Allocates a blank frame of the console, with no dirty rows and no caret.
+ *
+ * @param[in]	width	The width of the console, in cells.
+ * @param[in]	height	The height of the console, in rows.
+ *
+ * @return	The blank frame.
+ */
+internal
+console_frame AllocateConsoleFrame(size width, size height)
+{
+    console_frame frame = {
+        .Cells = AllocateConsoleCells(width * height),
+        .DirtyRows = AllocateTagged(
+            sizeof(u64) * DirtyRowWordCount(height), ALLOCATION_TAG_CONSOLE
+        ),
+
+        .CaretTop = -1,
+        .CaretLeft = -1,
+    };
+
+    MemoryFill(frame.DirtyRows, 0, sizeof(u64) * DirtyRowWordCount(height));
+
+    return frame;
+}
+
+void ClearConsole(console* console)
+{
+    console_cells* cells = &console->Cells;
+    size width = console->BufferWidth;
+
+    for (size y = 0; y < console->BufferHeight; y++)
+    {
+        size rowStart = y * width;
+
+        /* Rows that are already blank don't need to be blitted again. */
+        if (MemoryIsZero(&cells->Glyphs[rowStart], sizeof(u32) * width)
+            && MemoryIsZero(&cells->Foregrounds[rowStart], width)
+            && MemoryIsZero(&cells->Backgrounds[rowStart], width)
+            && MemoryIsZero(&cells->Attributes[rowStart], width))
+            continue;
+
+        MemoryFill32(&cells->Glyphs[rowStart], '\0', width);
+        MemoryFill(&cells->Foregrounds[rowStart], CONSOLE_COLOR_DEFAULT, width);
+        MemoryFill(&cells->Backgrounds[rowStart], CONSOLE_COLOR_DEFAULT, width);
+        MemoryFill(&cells->Attributes[rowStart], CONSOLE_ATTRIBUTE_NONE, width);
+
+        MarkConsoleRowDirty(console, y);
+    }
+}
+
+i32 ConsoleWrite(
+    console* console,
+    const char* string,
+    const size stringLength
+)
+{
+    size width = console->BufferWidth;
+    size cursorLeft = console->CursorLeft;
+    size cursorTop = console->CursorTop;
+
+    /* Past the last row there is nowhere to write to. */
+    if (console->BufferHeight <= cursorTop || width <= cursorLeft)
+        return 0;
+
+    console_cells* cells = &console->Cells;
+    size rowStart = cursorTop * width;
+    u32* row = &cells->Glyphs[rowStart];
+
+    bool splitsWideCharacter =
+        0 < cursorLeft && row[cursorLeft] == CONSOLE_CELL_WIDE_TAIL;
+
+    size cellsWritten = Utf8ToCells(
+        string, stringLength,
+        &row[cursorLeft], width - cursorLeft
+    );
+
+    if (cellsWritten == 0)
+        return 0;
+
+    size spanStart = rowStart + cursorLeft;
+    MemoryFill(
+        &cells->Foregrounds[spanStart], CONSOLE_COLOR_DEFAULT, cellsWritten
+    );
+    MemoryFill(
+        &cells->Backgrounds[spanStart], CONSOLE_COLOR_DEFAULT, cellsWritten
+    );
+    MemoryFill(
+        &cells->Attributes[spanStart], CONSOLE_ATTRIBUTE_NONE, cellsWritten
+    );
+
+    /*
+        A wide character that is partly written over can't be drawn any more,
+        so what is left of it is blanked.
+    */
+    if (splitsWideCharacter)
+        row[cursorLeft - 1] = '\0';
+
+    size end = cursorLeft + cellsWritten;
+    if (end < width && row[end] == CONSOLE_CELL_WIDE_TAIL)
+        row[end] = '\0';
+
+    MarkConsoleRowDirty(console, cursorTop);
+
+    return (i32)cellsWritten;
+}
+
+i32 ConsoleWriteLine(
+    console* console,
+    const char* string,
+    const size stringLength
+)
+{
+    i32 charactersWritten = ConsoleWrite(console, string, stringLength);
+
+    if ((size)console->CursorTop < console->BufferHeight)
+        console->CursorTop++;
+
+    return charactersWritten;
+}
+
+i32 _ConsoleWriteF(
+    console* console,
+    const char* format,
+    const size formatSize,
+    const format_arg* args,
+    const size argCount
+)
+{
+    /* Most text is ASCII, so the rest of the row usually holds all of it. */
+    size capacity = (size)console->CursorLeft < console->BufferWidth
+        ? console->BufferWidth - console->CursorLeft
+        : 0;
+
+    temporary_memory scratch = BeginTemporaryMemory(&FrameArena);
+
+    string_builder builder;
+    SetupStringBuilder(
+        &builder, &FrameArena, capacity, ALLOCATION_TAG_SCRATCH
+    );
+    _StringBuilderAppendF(&builder, format, formatSize, args, argCount);
+
+    i32 charactersWritten = ConsoleWrite(
+        console, builder.Data, builder.Length
+    );
+
+    EndTemporaryMemory(scratch);
+
+    return charactersWritten;
+}
+
+i32 _ConsoleWriteLineF(
+    console* console,
+    const char* format,
+    const size formatSize,
+    const format_arg* args,
+    const size argCount
+)
+{
+    i32 charactersWritten = _ConsoleWriteF(
+        console,
+        format, formatSize,
+        args, argCount
+    );
+
+    if ((size)console->CursorTop < console->BufferHeight)
+        console->CursorTop++;
+
+    return charactersWritten;
+}
+
+/**
+ * Runs the procedure of a thread started by StartThread, on that thread.
+ *
+ * @param[in]	parameter	The thread.
+ *
+ * @return	Nothing, as threads have no result to join with.
+ */
+internal
+void* RunThread(void* parameter)
+{
+    thread* thread = parameter;
+    thread->Procedure(thread->Parameter);
+
+    return NULL;
+}
+
+bool StartThread(
+    thread* thread,
+    thread_procedure* procedure,
+    void* parameter
+)
+{
+    thread->Procedure = procedure;
+    thread->Parameter = parameter;
+
+    pthread_t handle;
+    if (pthread_create(&handle, NULL, RunThread, thread) != 0)
+        return false;
+
+    thread->Handle = (size)handle;
+
+    return true;
+}
+
+void JoinThread(thread* thread)
+{
+    pthread_join((pthread_t)thread->Handle, NULL);
+}
+
+u32 GetProcessorCount(void)
+{
+    long processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return processorCount < 1 ? 1 : (u32)processorCount;
+}
+
+void SetupSemaphore(semaphore* semaphore, u32 initialCount)
+{
+    /* A sem_t can't be moved once set up, so it gets a place of its own. */
+    sem_t* handle = AllocateTagged(sizeof(sem_t), ALLOCATION_TAG_JOBS);
+
+    if (sem_init(handle, 0, initialCount) != 0)
+    {
+        Abort(
+            EXIT_COULD_NOT_CREATE_SEMAPHORE,
+            "Unable to create a semaphore."
+        );
+    }
+
+    semaphore->Handle = (size)handle;
+}
+
+void TeardownSemaphore(semaphore* semaphore)
+{
+    sem_destroy((sem_t*)semaphore->Handle);
+}
+
+void SignalSemaphore(semaphore* semaphore, u32 count)
+{
+    for (u32 i = 0; i < count; i++)
+        sem_post((sem_t*)semaphore->Handle);
+}
+
+void WaitOnSemaphore(semaphore* semaphore)
+{
+    while (sem_wait((sem_t*)semaphore->Handle) != 0 && errno == EINTR);
+}
+
+u64 ReadClock(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (u64)time.tv_sec * 1000000000 + (u64)time.tv_nsec;
+}
+
+wait_result WaitForEvents(const i32 timeoutMilliseconds)
+{
+    struct pollfd fileDescriptors[2] = {
+        { .fd = Platform.StandardInput, .events = POLLIN },
+        { .fd = Platform.WakeReadEnd, .events = POLLIN },
+    };
+
+    i32 readyCount;
+    do
+        readyCount = poll(fileDescriptors, 2, timeoutMilliseconds);
+    while (readyCount < 0 && errno == EINTR);
+
+    if (readyCount <= 0)
+        return WAIT_RESULT_TIMEOUT;
+
+    if (fileDescriptors[1].revents & POLLIN)
+    {
+        /* Drain the pipe so that later waits block again. */
+        char drain[64];
+        while (0 < read(Platform.WakeReadEnd, drain, sizeof(drain)));
+    }
+
+    return fileDescriptors[0].revents
+        ? WAIT_RESULT_INPUT
+        : WAIT_RESULT_WAKEUP;
+}
+
+void WakeFromWait(void)
+{
+    char wake = 0;
+    ssize_t bytesWritten = write(Platform.WakeWriteEnd, &wake, 1);
+
+    /* A full pipe means a wakeup is already pending. */
+    (void)bytesWritten;
+}
+
+/**
+ * Translates a byte read from the terminal into a platform independent
+ * keycode.
+ *
+ * @param[in]	character	The byte read from the terminal.
+ *
+ * @return	The keycode for the given byte, or KEY_NONE if it has none.
+ */
+internal
+keycode CharacterToKeyCode(char character)
+{
+    if ('a' <= character && character <= 'z')
+        return KEY_A + (character - 'a');
+
+    if ('A' <= character && character <= 'Z')
+        return KEY_A + (character - 'A');
+
+    if ('0' <= character && character <= '9')
+        return KEY_0 + (character - '0');
+
+    switch (character)
+    {
+    case '\x1b':
+        return KEY_ESCAPE;
+
+    case ' ':
+        return KEY_SPACE;
+
+    case '\b':
+    case '\x7f':
+        return KEY_BACKSPACE;
+
+    case '\r':
+    case '\n':
+        return KEY_ENTER;
+
+    default:
+        return KEY_NONE;
+    }
+}
+
+/**
+ * Translates a control sequence read from the terminal into a platform
+ * independent keycode.
+ *
+ * @param[in]	sequence	The sequence, starting after the escape.
+ * @param[in]	length		The length of the sequence, including its final
+ *							byte.
+ *
+ * @return	The keycode for the given sequence, or KEY_NONE if it has none.
+ */
+internal
+keycode ControlSequenceToKeyCode(const char* sequence, size length)
+{
+    char final = sequence[length - 1];
+
+    /* F1-F4 are sent as SS3 sequences: ESC O P through ESC O S. */
+    if (sequence[0] == 'O' && length == 2 && 'P' <= final && final <= 'S')
+        return KEY_F1 + (final - 'P');
+
+    /*
+        The arrows, Home and End are sent as either ESC [ X or ESC O X,
+        depending on the terminal's mode, possibly with modifiers before X.
+    */
+    switch (final)
+    {
+    case 'A':
+        return KEY_UP;
+
+    case 'B':
+        return KEY_DOWN;
+
+    case 'C':
+        return KEY_RIGHT;
+
+    case 'D':
+        return KEY_LEFT;
+
+    case 'H':
+        return KEY_HOME;
+
+    case 'F':
+        return KEY_END;
+    }
+
+    /* The rest are sent as ESC [ n ~, with gaps in the numbering. */
+    if (sequence[0] == '[' && final == '~')
+    {
+        i32 number = 0;
+        for (size i = 1; i < length - 1; i++)
+        {
+            if (sequence[i] < '0' || '9' < sequence[i])
+                break;
+
+            number = number * 10 + (sequence[i] - '0');
+        }
+
+        switch (number)
+        {
+        case 1: case 7:
+            return KEY_HOME;
+
+        case 3:
+            return KEY_DELETE;
+
+        case 4: case 8:
+            return KEY_END;
+
+        case 5:
+            return KEY_PAGE_UP;
+
+        case 6:
+            return KEY_PAGE_DOWN;
+
+        case 11: case 12: case 13: case 14: case 15:
+            return KEY_F1 + (number - 11);
+
+        case 17: case 18: case 19: case 20: case 21:
+            return KEY_F6 + (number - 17);
+
+        case 23: case 24:
+            return KEY_F11 + (number - 23);
+        }
+    }
+
+    return KEY_NONE;
+}
+
+/**
+ * Terminals only report key presses, so each one is stored as a key down event
+ * followed by a key up event, matching what the other platforms report.
+ *
+ * @param[in|out]	inputBuffer	The buffer to store the events in.
+ * @param[in]		key			The key that was pressed.
+ * @param[in]		control		Whether a control key was held down.
+ * @param[in]		character	The character that was typed, or 0.
+ *
+ * @return	The number of events pushed onto the buffer.
+ */
+internal
+i32 PushKeyPress(
+    input_buffer* inputBuffer,
+    keycode key,
+    bool control,
+    u32 character
+)
+{
+    input_event event = (input_event){
+        .Key = key,
+        .KeyDown = true,
+        .KeyUp = false,
+        .Control = control,
+
+        .Character = character,
+    };
+
+    i32 eventsPushed = PushInputEventTo(inputBuffer, &event);
+
+    event.KeyDown = false;
+    event.KeyUp = true;
+
+    eventsPushed += PushInputEventTo(inputBuffer, &event);
+
+    return eventsPushed;
+}
+
+i32 InputBufferRead(input_buffer* inputBuffer)
+{
+    persist char bytes[UTF8_MAX_LENGTH - 1 + 64];
+
+    /*
+        Every byte can turn into two events. Anything we don't have room for is
+        left with the terminal until the buffer drains, rather than dropped.
+    */
+    size freeEventCount = inputBuffer->MaxEventCount
+        - (inputBuffer->TailIndex - AtomicLoadAcquire(&inputBuffer->HeadIndex));
+
+    size bytesToRead = freeEventCount / 2;
+    if (64 < bytesToRead)
+        bytesToRead = 64;
+
+    if (bytesToRead == 0)
+        return 0;
+
+    size pendingLength = Platform.PendingInputLength;
+    for (size i = 0; i < pendingLength; i++)
+        bytes[i] = Platform.PendingInput[i];
+
+    ssize_t newBytesRead = read(
+        Platform.StandardInput, &bytes[pendingLength], bytesToRead
+    );
+
+    if (newBytesRead <= 0)
+        return 0;
+
+    ssize_t bytesRead = pendingLength + newBytesRead;
+    Platform.PendingInputLength = 0;
+
+    i32 eventsPushed = 0;
+    for (ssize_t i = 0; i < bytesRead; i++)
+    {
+        char c = bytes[i];
+
+        /*
+            An escape followed by '[' or 'O' in the same read is the start of a
+            control sequence (arrow keys, function keys, etc.), not a lone
+            escape. Sequences for keys that aren't mapped are skipped.
+        */
+        if (c == '\x1b' && i + 1 < bytesRead
+            && (bytes[i + 1] == '[' || bytes[i + 1] == 'O'))
+        {
+            ssize_t sequenceStart = ++i;
+
+            i++;
+            while (i < bytesRead && (bytes[i] < '@' || '~' < bytes[i]))
+                i++;
+
+            if (i < bytesRead)
+            {
+                keycode key = ControlSequenceToKeyCode(
+                    &bytes[sequenceStart],
+                    i - sequenceStart + 1
+                );
+
+                if (key != KEY_NONE)
+                    eventsPushed += PushKeyPress(
+                        inputBuffer, key, false, '\0'
+                    );
+            }
+        }
+
+        /* Anything else past ASCII is the start of a UTF-8 character. */
+        else if (0x80 <= (u8)c)
+        {
+            size remaining = bytesRead - i;
+            size expectedLength = Utf8SequenceLength((u8)c);
+
+            /*
+                The terminal can split a character between reads, in which
+                case the rest of it comes with the next one.
+            */
+            if (remaining < expectedLength)
+            {
+                size continued = 1;
+                while (
+                    continued < remaining
+                    && Utf8IsContinuation(bytes[i + continued])
+                )
+                    continued++;
+
+                if (continued == remaining)
+                {
+                    for (size j = 0; j < remaining; j++)
+                        Platform.PendingInput[j] = bytes[i + j];
+
+                    Platform.PendingInputLength = remaining;
+                    break;
+                }
+            }
+
+            u32 codepoint;
+            i += Utf8Decode(&bytes[i], remaining, &codepoint) - 1;
+
+            eventsPushed += PushKeyPress(
+                inputBuffer, KEY_NONE, false, codepoint
+            );
+        }
+
+        /*
+            Holding control turns a letter into the byte 1 through 26, but some
+            of those are also keys of their own, like tab and enter.
+        */
+        else if ('\x01' <= c && c <= '\x1a'
+            && c != '\b' && c != '\t' && c != '\n' && c != '\r')
+        {
+            eventsPushed += PushKeyPress(
+                inputBuffer, KEY_A + (c - '\x01'), true, '\0'
+            );
+        }
+
+        else
+            eventsPushed += PushKeyPress(
+                inputBuffer, CharacterToKeyCode(c), false, (u8)c
+            );
+    }
+
+    return eventsPushed;
+}
+
+bool PushInputEventTo(input_buffer* inputBuffer, const input_event* event)
+{
+    size tail = inputBuffer->TailIndex;
+    size head = AtomicLoadAcquire(&inputBuffer->HeadIndex);
+
+    if (tail - head == inputBuffer->MaxEventCount)
+    {
+        AtomicStoreRelease(
+            &inputBuffer->DroppedEventCount,
+            inputBuffer->DroppedEventCount + 1
+        );
+
+        return false;
+    }
+
+    inputBuffer->Events[tail & (inputBuffer->MaxEventCount - 1)] = *event;
+    AtomicStoreRelease(&inputBuffer->TailIndex, tail + 1);
+
+    return true;
+}
+
+bool PopInputEventFrom(input_buffer* inputBuffer, input_event* event)
+{
+    size head = inputBuffer->HeadIndex;
+    size tail = AtomicLoadAcquire(&inputBuffer->TailIndex);
+
+    if (head == tail)
+        return false;
+
+    *event = inputBuffer->Events[head & (inputBuffer->MaxEventCount - 1)];
+    AtomicStoreRelease(&inputBuffer->HeadIndex, head + 1);
+
+    return true;
+}
+
+input_event* PeekInputEventFrom(input_buffer* inputBuffer)
+{
+    size head = inputBuffer->HeadIndex;
+    size tail = AtomicLoadAcquire(&inputBuffer->TailIndex);
+
+    return head != tail
+        ? &inputBuffer->Events[head & (inputBuffer->MaxEventCount - 1)]
+        : NULL;
+}
+
+/**
+ * Initializes a blank console of the given size, along with the buffer its
+ * frames are assembled in before being written. The thread that blits them is
+ * started separately, by StartConsoleOutput.
+ *
+ * @param[out]	console	The console to setup.
+ * @param[in]	width	The width of the console, in cells.
+ * @param[in]	height	The height of the console, in rows.
+ */
+internal
+void SetupConsole(console* console, size width, size height)
+{
+    console_cells frontCells = AllocateConsoleCells(width * height);
+
+    u64* shownRows = AllocateTagged(
+        sizeof(u64) * DirtyRowWordCount(height),
+        ALLOCATION_TAG_CONSOLE
+    );
+
+    MemoryFill(shownRows, 0, sizeof(u64) * DirtyRowWordCount(height));
+
+    Platform.FrameBufferSize = FrameBufferSizeFor(width, height);
+    Platform.FrameBuffer = AllocateTagged(
+        Platform.FrameBufferSize,
+        ALLOCATION_TAG_CONSOLE
+    );
+
+    Platform.TerminalCursorTop = -1;
+    Platform.TerminalCursorLeft = -1;
+    Platform.TerminalForeground = CONSOLE_COLOR_DEFAULT;
+    Platform.TerminalBackground = CONSOLE_COLOR_DEFAULT;
+    Platform.TerminalAttributes = CONSOLE_ATTRIBUTE_NONE;
+
+    *console = (struct console){
+        .BufferWidth = width,
+        .BufferHeight = height,
+
+        .CursorLeft = 0,
+        .CursorTop = 0,
+
+        .CaretLeft = -1,
+        .CaretTop = -1,
+
+        /* One frame is drawn, one waits and one is blitted. */
+        .DrawingFrame = 0,
+        .PendingFrame = 1,
+        .PresentedFrameCount = 0,
+        .DroppedFrameCount = 0,
+
+        .BlittingFrame = 2,
+        .FrontCells = frontCells,
+        .ShownRows = shownRows,
+    };
+
+    for (size i = 0; i < CONSOLE_FRAME_COUNT; i++)
+        console->Frames[i] = AllocateConsoleFrame(width, height);
+
+    console->Cells = console->Frames[console->DrawingFrame].Cells;
+    console->DirtyRows = console->Frames[console->DrawingFrame].DirtyRows;
+}
+
+/**
+ * Initializes an empty input buffer.
+ *
+ * @param[out]	inputBuffer	The input buffer to setup.
+ */
+internal
+void SetupInputBuffer(input_buffer* inputBuffer)
+{
+    *inputBuffer = (struct input_buffer){
+        .Events = AllocateTagged(
+            sizeof(input_event) * INPUT_BUFFER_SIZE,
+            ALLOCATION_TAG_INPUT
+        ),
+        .MaxEventCount = INPUT_BUFFER_SIZE,
+
+        .HeadIndex = 0,
+        .TailIndex = 0,
+        .DroppedEventCount = 0,
+    };
+}
+
+/*
+    A program that brings its own entry point, such as the benchmarks, defines
+    ONTOLOGIC_NO_MAIN to use the platform layer without this one.
+*/
+#if !defined(ONTOLOGIC_NO_MAIN)
+
+i32 main(i32 argumentCount, char** arguments)
+{
+    Platform = (struct platform)
+    {
+        .StandardOutput = STDOUT_FILENO,
+        .StandardError = STDERR_FILENO,
+        .StandardInput = STDIN_FILENO,
+    };
+
+    i32 wakePipe[2];
+    if (pipe2(wakePipe, O_NONBLOCK | O_CLOEXEC) != 0)
+    {
+        Abort(
+            EXIT_COULD_NOT_CREATE_WAKEUP_HANDLE,
+            "Unable to create the pipe used to wake the main loop."
+        );
+    }
+
+    Platform.WakeReadEnd = wakePipe[0];
+    Platform.WakeWriteEnd = wakePipe[1];
+
+    struct winsize windowSize;
+    if (ioctl(Platform.StandardOutput, TIOCGWINSZ, &windowSize) != 0
+        || windowSize.ws_col == 0 || windowSize.ws_row == 0)
+    {
+        Abort(
+            EXIT_COULD_NOT_GET_SCREEN_BUFFER_INFO,
+            "Unable to retreive terminal size."
+        );
+    }
+
+    if (tcgetattr(Platform.StandardInput, &Platform.OriginalTerminalMode) != 0)
+    {
+        Abort(
+            EXIT_COULD_NOT_SET_TERMINAL_MODE,
+            "Unable to read the terminal mode of standard input."
+        );
+    }
+
+    /*
+        Raw mode: no echo, no line buffering, no signal keys, and reads return
+        immediately with whatever is available.
+    */
+    struct termios rawMode = Platform.OriginalTerminalMode;
+    rawMode.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    rawMode.c_oflag &= ~(OPOST);
+    rawMode.c_cflag |= CS8;
+    rawMode.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    rawMode.c_cc[VMIN] = 0;
+    rawMode.c_cc[VTIME] = 0;
+
+    if (tcsetattr(Platform.StandardInput, TCSAFLUSH, &rawMode) != 0)
+    {
+        Abort(
+            EXIT_COULD_NOT_SET_TERMINAL_MODE,
+            "Unable to put the terminal into raw mode."
+        );
+    }
+
+    Platform.TerminalModeChanged = true;
+
+    /* Switch to the alternate screen and hide the cursor. */
+    char setup[] = "\x1b[?1049h\x1b[?25l\x1b[2J";
+    WriteAll(Platform.StandardOutput, setup, sizeof(setup) - 1);
+
+    size consoleWidth = windowSize.ws_col;
+    size consoleHeight = windowSize.ws_row;
+
+    SetupMemoryArena(
+        &MemoryArena,
+        DEFAULT_ARENA_RESERVE_SIZE,
+        ARENA_FLAGS_NONE
+    );
+
+    SetupMemoryArena(&FrameArena, Megabyte(256), ARENA_FLAGS_NONE);
+
+    console c;
+    SetupConsole(&c, consoleWidth, consoleHeight);
+
+    StartConsoleOutput(&c);
+
+    input_buffer inputBuffer;
+    SetupInputBuffer(&inputBuffer);
+
+    Main(&c, &inputBuffer, &FrameArena, argumentCount, arguments);
+
+    StopConsoleOutput();
+
+    TeardownMemoryArena(&FrameArena);
+    TeardownMemoryArena(&MemoryArena);
+
+    RestoreTerminal();
+
+    close(Platform.WakeReadEnd);
+    close(Platform.WakeWriteEnd);
+
+    return EXIT_NORMAL;
+}
+
+#endif
@@ -12,11 +12,44 @@ typedef struct platform
     HANDLE hStandardInput;
 
     HANDLE hConsole;
+    /* Where the console's cursor was last placed, and whether it is shown. */
+    COORD CursorPosition;
+    bool CursorVisible;
+    /* The colors the console was using at startup, for unhighlighted cells. */
+    WORD DefaultAttributes;
+
+    /* Where BlitConsoleFrame assembles each span before writing it. */
+    WCHAR* SpanCharacters;
+    WORD* SpanAttributes;
+
+    /* The thread that blits frames, so that slow writes never hold up input. */
+    thread OutputThread;
+    /* Signaled when there may be a frame for the output thread to blit. */
+    semaphore FrameSemaphore;
+    volatile bool OutputQuitting;
+
+    /*
+        The console reads characters past U+FFFF as two key events, one for
+        each half of their surrogate pair. This is the first half, until the
+        second arrives.
+    */
+    WCHAR PendingHighSurrogate;
+
+    /* Signaled by WakeFromWait to interrupt WaitForEvents. */
+    HANDLE hWakeEvent;
+
+    /* How many times a second the performance counter ticks. */
+    u64 ClockFrequency;
 }
 platform;
 
 global platform Platform;
 
+global memory_arena MemoryArena;
+
+/* Scratch memory that is freed at the end of every frame. */
+global memory_arena FrameArena;
+
 internal
 void Exit(exit_code code)
 {
@@ -35,25 +68,28 @@ void _Assert(
 {
     if (!predicate)
     {
-        char buffer[1024];
-        char message[] =
-            "Assertion \"%s\" on line %i in file \"%s\" failed.\n\0";
-
-        size messageLength = FormatString(
-            buffer, 1024,
-            message, sizeof(message),
-            expression, expressionLength,
+        string_builder message;
+        SetupStringBuilder(&message, &FrameArena, 256, ALLOCATION_TAG_SCRATCH);
+
+        char format[] =
+            "Assertion \"%s\" on line %u in file \"%s\" failed.\n\0";
+
+        StringBuilderAppendF(
+            &message,
+            format, sizeof(format) - 1,
+            MakeString(expression, expressionLength),
             line,
-            fileName, fileNameLength
+            MakeString(fileName, fileNameLength)
         );
 
-        OutputDebugStringA(buffer);
+        OutputDebugStringA(message.Data);
 
+        /* The '\0' is only there for OutputDebugStringA. */
         u32 charactersWritten;
         WriteConsoleA(
             Platform.hStandardOutput,
-            buffer,
-            messageLength,
+            message.Data,
+            message.Length - 1,
             &charactersWritten,
             NULL
         );
@@ -103,25 +139,93 @@ void _Abort(exit_code code, const char* message, const size messageSize)
     Exit(code);
 }
 
-global memory_arena MemoryArena;
+/*
+    Pages are committed in chunks of this size, so that only the occasional
+    allocation needs a system call.
+*/
+#define ARENA_COMMIT_GRANULARITY Kilobyte(64)
 
 internal
-void SetupMemoryArena(memory_arena* arena, const size arenaSize)
+void SetupMemoryArena(
+    memory_arena* arena,
+    const size arenaSize,
+    const memory_arena_flags flags
+)
 {
+    /*
+        Reserved pages are only address space: they cost nothing until they
+        are committed. Large pages need privileges we don't ask for, so
+        ARENA_FLAGS_HUGE_PAGES is ignored here.
+    */
     arena->Start = VirtualAlloc(
         NULL,
         arenaSize,
-        MEM_RESERVE | MEM_COMMIT,
-        PAGE_READWRITE
+        MEM_RESERVE,
+        PAGE_NOACCESS
     );
 
     AssertWithMessage(
         arena->Start != NULL,
-        "Not enough memory available to initialize."
+        "Not enough address space available to initialize."
     );
 
     arena->Cursor = arena->Start;
     arena->Size = arenaSize;
+    arena->CommittedSize = 0;
+    arena->Flags = flags;
+    arena->TemporaryCount = 0;
+    arena->Stats = (memory_arena_stats){ 0 };
+}
+
+/**
+ * Commits enough pages that the first requiredSize bytes of the arena can be
+ * used.
+ *
+ * @param[in|out]	arena			The arena to commit pages for.
+ * @param[in]		requiredSize	The number of bytes that must be usable.
+ */
+internal
+void CommitMemoryArena(memory_arena* arena, size requiredSize)
+{
+    size newCommittedSize =
+        (requiredSize + (ARENA_COMMIT_GRANULARITY - 1))
+        & ~(ARENA_COMMIT_GRANULARITY - 1);
+
+    if (arena->Size < newCommittedSize)
+        newCommittedSize = arena->Size;
+
+    void* committed = VirtualAlloc(
+        (void*)((size)arena->Start + arena->CommittedSize),
+        newCommittedSize - arena->CommittedSize,
+        MEM_COMMIT,
+        PAGE_READWRITE
+    );
+
+    if (committed == NULL)
+    {
+        Abort(
+            EXIT_SYSTEM_OUT_OF_MEMORY,
+            "Unable to commit memory for the arena."
+        );
+    }
+
+    arena->CommittedSize = newCommittedSize;
+}
+
+/**
+ * Gives all of the arena's committed pages back to the host.
+ *
+ * @param[in|out]	arena	The arena to decommit the pages of.
+ */
+internal
+void DecommitMemoryArena(memory_arena* arena)
+{
+    if (0 < arena->CommittedSize)
+    {
+        VirtualFree(arena->Start, arena->CommittedSize, MEM_DECOMMIT);
+
+        arena->CommittedSize = 0;
+    }
 }
 
 internal
@@ -130,55 +234,776 @@ void TeardownMemoryArena(memory_arena* arena)
     VirtualFree(arena->Start, 0, MEM_RELEASE);
 }
 
+/**
+ * Aborts the process after running out of memory, reporting what was being
+ * allocated and how the arena was being used at the time.
+ *
+ * @param[in]	arena			The arena that ran out of memory.
+ * @param[in]	allocationSize	The size of the allocation that failed.
+ * @param[in]	tag				The tag of the allocation that failed.
+ * @param[in]	filepath		The path to the file making the allocation.
+ * @param[in]	line			The line of the file making the allocation.
+ */
 internal
-void* Allocate(const size allocationSize)
+void AbortOutOfMemory(
+    memory_arena* arena,
+    const size allocationSize,
+    const allocation_tag tag,
+    const char* filepath,
+    const size line
+)
 {
-    size currentlyAllocatedSize =
-        (size)MemoryArena.Cursor - (size)MemoryArena.Start;
-    size newAllocationSize = currentlyAllocatedSize + allocationSize;
+    persist struct { const char* Name; size Length; } tagNames[] = {
+#define _(TAG) { #TAG, sizeof(#TAG) - 1 },
+        ALLOCATION_TAGS
+#undef _
+    };
+
+    /*
+        The message is built in the other arena, which is unlikely to have run
+        out as well. If it has, there is nowhere left to build it.
+    */
+    persist bool isAborting = false;
+    if (isAborting)
+        Abort(EXIT_SYSTEM_OUT_OF_MEMORY, "Ran out of available memory.");
+
+    isAborting = true;
+
+    memory_arena* messageArena = arena == &FrameArena
+        ? &MemoryArena
+        : &FrameArena;
+
+    string_builder message;
+    SetupStringBuilder(&message, messageArena, 256, ALLOCATION_TAG_SCRATCH);
+
+    char format[] =
+        "Aborted: Ran out of available memory allocating %u bytes (%s) at "
+        "%s:%u. In use: %u bytes, high-water mark: %u bytes, reserved: %u "
+        "bytes.\n\0";
+
+    StringBuilderAppendF(
+        &message,
+        format, sizeof(format) - 1,
+        allocationSize,
+        MakeString(tagNames[tag].Name, tagNames[tag].Length),
+        filepath,
+        line,
+        (size)arena->Cursor - (size)arena->Start,
+        arena->Stats.HighWaterMark,
+        arena->Size
+    );
+
+    /* The '\0' is only there for OutputDebugStringA. */
+    _Abort(EXIT_SYSTEM_OUT_OF_MEMORY, message.Data, message.Length - 1);
+}
 
-    if (newAllocationSize <= MemoryArena.Size)
+internal
+void* _Allocate(
+    const size allocationSize,
+    const allocation_tag tag,
+    const char* filepath,
+    const size line
+)
+{
+    return _PushSize(
+        &MemoryArena,
+        allocationSize,
+        DEFAULT_ALIGNMENT,
+        tag,
+        filepath,
+        line
+    );
+}
+
+internal
+memory_arena* GetGlobalMemoryArena(void)
+{
+    return &MemoryArena;
+}
+
+internal
+void* _PushSize(
+    memory_arena* arena,
+    const size allocationSize,
+    const size alignment,
+    const allocation_tag tag,
+    const char* filepath,
+    const size line
+)
+{
+    Assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+    Assert(tag < ALLOCATION_TAG_COUNT);
+
+    size arenaEnd = (size)arena->Start + arena->Size;
+    size alignedCursor =
+        ((size)arena->Cursor + (alignment - 1)) & ~(alignment - 1);
+
+    if (alignedCursor <= arenaEnd && allocationSize <= arenaEnd - alignedCursor)
     {
-        void* oldCursor = MemoryArena.Cursor;
-        MemoryArena.Cursor = (void*)
-            ((size)MemoryArena.Cursor + allocationSize);
+        size usedSize = alignedCursor + allocationSize - (size)arena->Start;
+        if (arena->CommittedSize < usedSize)
+            CommitMemoryArena(arena, usedSize);
+
+        arena->Cursor = (void*)(alignedCursor + allocationSize);
+
+        memory_arena_stats* stats = &arena->Stats;
+        stats->TagBytes[tag] += allocationSize;
+        stats->TagCounts[tag]++;
+        stats->FrameAllocationCount++;
+        stats->FrameAllocatedBytes += allocationSize;
 
-        return oldCursor;
+        if (stats->HighWaterMark < usedSize)
+            stats->HighWaterMark = usedSize;
+
+        return (void*)alignedCursor;
     }
     else
     {
-        Abort(
-            EXIT_SYSTEM_OUT_OF_MEMORY,
-            "Ran out of available memory."
+        AbortOutOfMemory(arena, allocationSize, tag, filepath, line);
+
+        return NULL;
+    }
+}
+
+internal
+temporary_memory BeginTemporaryMemory(memory_arena* arena)
+{
+    arena->TemporaryCount++;
+
+    return (temporary_memory){
+        .Arena = arena,
+        .Cursor = arena->Cursor,
+    };
+}
+
+internal
+void EndTemporaryMemory(temporary_memory temporaryMemory)
+{
+    memory_arena* arena = temporaryMemory.Arena;
+
+    Assert(0 < arena->TemporaryCount);
+    Assert(
+        (size)arena->Start <= (size)temporaryMemory.Cursor
+        && (size)temporaryMemory.Cursor <= (size)arena->Cursor
+    );
+
+    arena->Cursor = temporaryMemory.Cursor;
+    arena->TemporaryCount--;
+}
+
+internal
+void ResetMemoryArena(memory_arena* arena)
+{
+    Assert(arena->TemporaryCount == 0);
+
+    arena->Cursor = arena->Start;
+
+    if (arena->Flags & ARENA_FLAGS_DECOMMIT_ON_RESET)
+        DecommitMemoryArena(arena);
+}
+
+internal
+size ReadEnvironmentVariable(
+    const char* name,
+    char* buffer,
+    const size bufferSize
+)
+{
+    u32 valueLength = GetEnvironmentVariableA(name, buffer, bufferSize);
+
+    /* When the value doesn't fit, the size it needs is returned instead. */
+    return valueLength < bufferSize ? valueLength : 0;
+}
+
+internal
+bool WriteEntireFile(const char* path, const void* data, const size dataSize)
+{
+    HANDLE hFile = CreateFileA(
+        path,
+        GENERIC_WRITE,
+        0,
+        NULL,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL
+    );
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool written = true;
+
+    const char* bytes = data;
+    size bytesRemaining = dataSize;
+    while (written && 0 < bytesRemaining)
+    {
+        u32 chunkSize = bytesRemaining < 0x40000000
+            ? (u32)bytesRemaining
+            : 0x40000000;
+
+        u32 bytesWritten;
+        written = WriteFile(hFile, bytes, chunkSize, &bytesWritten, NULL);
+
+        bytes += bytesWritten;
+        bytesRemaining -= bytesWritten;
+    }
+
+    CloseHandle(hFile);
+
+    return written;
+}
+
+internal
+bool OpenReadOnlyFile(file* file, const char* path)
+{
+    HANDLE hFile = CreateFileA(
+        path,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL
+    );
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    *file = (struct file){
+        .Data = NULL,
+        .Size = 0,
+
+        .Handle = (size)hFile,
+    };
+
+    LARGE_INTEGER fileSize;
+    if (GetFileType(hFile) != FILE_TYPE_DISK
+        || !GetFileSizeEx(hFile, &fileSize)
+        || (u64)fileSize.QuadPart != (size)fileSize.QuadPart)
+        return true;
+
+    /* Empty files can't be mapped, but there is nothing to read either. */
+    if (fileSize.QuadPart == 0)
+        file->Data = "";
+
+    else
+    {
+        HANDLE hMapping = CreateFileMappingA(
+            hFile,
+            NULL,
+            PAGE_READONLY,
+            0,
+            0,
+            NULL
         );
+
+        if (hMapping == NULL)
+            return true;
+
+        void* data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+        /* The view keeps the mapping open on its own. */
+        CloseHandle(hMapping);
+
+        if (data == NULL)
+            return true;
+
+        file->Data = data;
+        file->Size = (size)fileSize.QuadPart;
     }
+
+    CloseHandle(hFile);
+    file->Handle = (size)INVALID_HANDLE_VALUE;
+
+    return true;
+}
+
+internal
+size ReadFileStream(file* file, void* buffer, const size bufferSize)
+{
+    if (file->Data != NULL)
+        return 0;
+
+    u32 bytesToRead = bufferSize < 0x40000000 ? (u32)bufferSize : 0x40000000;
+
+    u32 bytesRead;
+    if (!ReadFile((HANDLE)file->Handle, buffer, bytesToRead, &bytesRead, NULL))
+        return 0;
+
+    return bytesRead;
+}
+
+internal
+void CloseReadOnlyFile(file* file)
+{
+    if (file->Data != NULL && 0 < file->Size)
+        UnmapViewOfFile(file->Data);
+
+    if (file->Data == NULL)
+        CloseHandle((HANDLE)file->Handle);
+
+    file->Data = NULL;
+    file->Size = 0;
+}
+
+/*
+    Every call to WriteConsoleOutputCharacterW has a fixed cost, so unchanged
+    runs shorter than this are cheaper to rewrite than to skip over.
+*/
+#define UNCHANGED_RUN_COST 8
+
+/* The console_colors as the bits of a Windows console foreground attribute. */
+global const WORD ConsoleColorBits[] = {
+    /* CONSOLE_COLOR_DEFAULT comes from the console's own attributes. */
+    0,
+
+    0,
+    FOREGROUND_RED,
+    FOREGROUND_GREEN,
+    FOREGROUND_RED | FOREGROUND_GREEN,
+    FOREGROUND_BLUE,
+    FOREGROUND_RED | FOREGROUND_BLUE,
+    FOREGROUND_GREEN | FOREGROUND_BLUE,
+    FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE,
+
+    FOREGROUND_INTENSITY,
+    FOREGROUND_INTENSITY | FOREGROUND_RED,
+    FOREGROUND_INTENSITY | FOREGROUND_GREEN,
+    FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_GREEN,
+    FOREGROUND_INTENSITY | FOREGROUND_BLUE,
+    FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_BLUE,
+    FOREGROUND_INTENSITY | FOREGROUND_GREEN | FOREGROUND_BLUE,
+    FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE,
+};
+
+/**
+ * Converts the colors and attributes of a cell to a Windows console attribute.
+ * The console has no bold, so bold characters are drawn brighter instead.
+ *
+ * @param[in]	foreground	The console_color of the cell's character.
+ * @param[in]	background	The console_color behind it.
+ * @param[in]	attributes	The console_attribute flags of the cell.
+ *
+ * @return	The Windows console attribute to draw the cell with.
+ */
+internal
+WORD CellAttribute(u8 foreground, u8 background, u8 attributes)
+{
+    WORD defaults = Platform.DefaultAttributes;
+    WORD attribute = defaults & ~(0xFF | COMMON_LVB_REVERSE_VIDEO);
+
+    attribute |= foreground == CONSOLE_COLOR_DEFAULT
+        ? defaults & 0x0F
+        : ConsoleColorBits[foreground];
+
+    attribute |= background == CONSOLE_COLOR_DEFAULT
+        ? defaults & 0xF0
+        : ConsoleColorBits[background] << 4;
+
+    if (attributes & CONSOLE_ATTRIBUTE_BOLD)
+        attribute |= FOREGROUND_INTENSITY;
+
+    if (attributes & CONSOLE_ATTRIBUTE_UNDERLINE)
+        attribute |= COMMON_LVB_UNDERSCORE;
+
+    if (attributes & CONSOLE_ATTRIBUTE_HIGHLIGHT)
+        attribute |= COMMON_LVB_REVERSE_VIDEO;
+
+    return attribute;
 }
 
+/**
+ * "Blits" a frame of the console to the platform's console. Only the rows
+ * flagged as dirty, or that were showing anything, are inspected, and only the
+ * cells that differ from the front buffer are written. Only called on the
+ * output thread.
+ *
+ * @param[in|out]	console			The console the frame belongs to.
+ * @param[in|out]	consoleFrame	The frame to blit.
+ *
+ * @return	The number of bytes sent to the platform's console.
+ */
 internal
-void BlitConsole(console* console)
+size BlitConsoleFrame(console* console, console_frame* consoleFrame)
 {
     i32 charactersWritten;
 
+    console_cells* cells = &consoleFrame->Cells;
+    console_cells* frontCells = &console->FrontCells;
+
+    size width = console->BufferWidth;
+
+    WORD* spanAttributes = Platform.SpanAttributes;
+    WCHAR* spanCharacters = Platform.SpanCharacters;
+
+    size bytesSent = 0;
+
     for (size y = 0; y < console->BufferHeight; y++)
     {
-        for (size x = 0; x < console->BufferWidth; x++)
+        /* Rows that were showing anything may have to be blanked. */
+        u64 rows = consoleFrame->DirtyRows[y / 64] | console->ShownRows[y / 64];
+
+        if (rows == 0)
         {
-            WriteConsoleOutputCharacterA(
+            y += 63 - (y % 64);
+            continue;
+        }
+
+        if ((rows & (1ull << (y % 64))) == 0)
+            continue;
+
+        size rowStart = y * width;
+        u32* row = &cells->Glyphs[rowStart];
+
+        size x = 0;
+        while (x < width)
+        {
+            if (!ConsoleCellChanged(console, cells, rowStart + x))
+            {
+                x++;
+                continue;
+            }
+
+            /* Half of a wide character is redrawn by drawing all of it. */
+            if (row[x] == CONSOLE_CELL_WIDE_TAIL && 0 < x)
+                x--;
+
+            size spanEnd = x + 1;
+            size gap = 0;
+            for (size i = spanEnd; i < width && gap <= UNCHANGED_RUN_COST; i++)
+            {
+                if (ConsoleCellChanged(console, cells, rowStart + i))
+                {
+                    spanEnd = i + 1;
+                    gap = 0;
+                }
+
+                else
+                    gap++;
+            }
+
+            if (spanEnd < width && row[spanEnd] == CONSOLE_CELL_WIDE_TAIL)
+                spanEnd++;
+
+            /* The console covers the tail when it draws a wide character. */
+            size characterCount = 0;
+            for (size i = x; i < spanEnd; i++)
+            {
+                u32 c = row[i];
+
+                if (c == CONSOLE_CELL_WIDE_TAIL)
+                    continue;
+
+                if (c == '\0')
+                    c = ' ';
+
+                if (c < 0x10000)
+                    spanCharacters[characterCount++] = (WCHAR)c;
+
+                else
+                {
+                    c -= 0x10000;
+                    spanCharacters[characterCount++] =
+                        (WCHAR)(0xD800 + (c >> 10));
+                    spanCharacters[characterCount++] =
+                        (WCHAR)(0xDC00 + (c & 0x3FF));
+                }
+            }
+
+            WriteConsoleOutputCharacterW(
+                Platform.hConsole,
+                spanCharacters,
+                characterCount,
+                (COORD) { .X = x, .Y = y, },
+                &charactersWritten
+            );
+
+            bytesSent += sizeof(WCHAR) * characterCount;
+
+            for (size i = x; i < spanEnd; i++)
+            {
+                spanAttributes[i - x] = CellAttribute(
+                    cells->Foregrounds[rowStart + i],
+                    cells->Backgrounds[rowStart + i],
+                    cells->Attributes[rowStart + i]
+                );
+            }
+
+            WriteConsoleOutputAttribute(
                 Platform.hConsole,
-                &(console->Buffer[y * console->BufferWidth + x]),
-                1,
+                spanAttributes,
+                spanEnd - x,
                 (COORD) { .X = x, .Y = y, },
                 &charactersWritten
             );
+
+            bytesSent += sizeof(WORD) * (spanEnd - x);
+
+            size spanStart = rowStart + x;
+            size spanLength = spanEnd - x;
+
+            MemoryCopy(
+                &frontCells->Glyphs[spanStart],
+                &cells->Glyphs[spanStart],
+                sizeof(u32) * spanLength
+            );
+            MemoryCopy(
+                &frontCells->Foregrounds[spanStart],
+                &cells->Foregrounds[spanStart],
+                spanLength
+            );
+            MemoryCopy(
+                &frontCells->Backgrounds[spanStart],
+                &cells->Backgrounds[spanStart],
+                spanLength
+            );
+            MemoryCopy(
+                &frontCells->Attributes[spanStart],
+                &cells->Attributes[spanStart],
+                spanLength
+            );
+
+            x = spanEnd;
         }
     }
+
+    /*
+        The frame was cleared before it was drawn, so only the rows written to
+        can have been left showing anything.
+    */
+    for (size i = 0; i < DirtyRowWordCount(console->BufferHeight); i++)
+    {
+        console->ShownRows[i] = consoleFrame->DirtyRows[i];
+        consoleFrame->DirtyRows[i] = 0;
+    }
+
+    i16 caretTop = consoleFrame->CaretTop;
+    i16 caretLeft = consoleFrame->CaretLeft;
+
+    bool caretVisible = 0 <= caretTop && 0 <= caretLeft
+        && (size)caretTop < console->BufferHeight
+        && (size)caretLeft < width;
+
+    if (caretVisible
+        && (Platform.CursorPosition.X != caretLeft
+            || Platform.CursorPosition.Y != caretTop))
+    {
+        Platform.CursorPosition = (COORD){
+            .X = caretLeft,
+            .Y = caretTop,
+        };
+
+        SetConsoleCursorPosition(Platform.hConsole, Platform.CursorPosition);
+    }
+
+    if (caretVisible != Platform.CursorVisible)
+    {
+        CONSOLE_CURSOR_INFO cursorInfo;
+        GetConsoleCursorInfo(Platform.hConsole, &cursorInfo);
+
+        cursorInfo.bVisible = caretVisible;
+        SetConsoleCursorInfo(Platform.hConsole, &cursorInfo);
+
+        Platform.CursorVisible = caretVisible;
+    }
+
+    return bytesSent;
+}
+
+/**
+ * Blits each frame that PresentConsole hands over, until told to quit. Run on
+ * a thread of its own, as writing to the console can take as long as whatever
+ * is drawing it takes to keep up.
+ *
+ * @param[in|out]	parameter	The console to blit frames of.
+ */
+internal
+void ConsoleOutputThread(void* parameter)
+{
+    console* console = parameter;
+
+    NameProfileThread("output");
+
+    bool quitting = false;
+    until (quitting)
+    {
+        WaitOnSemaphore(&Platform.FrameSemaphore);
+
+        /* Frames presented before quitting still get blitted. */
+        quitting = AtomicLoadAcquire(&Platform.OutputQuitting);
+
+        i64 pending = AtomicLoadAcquire(&console->PendingFrame);
+        if ((pending & CONSOLE_FRAME_FRESH) == 0)
+            continue;
+
+        /* The frame just blitted is the one left waiting, to be drawn over. */
+        pending = AtomicExchange64(
+            &console->PendingFrame, (i64)console->BlittingFrame
+        );
+
+        console->BlittingFrame = (size)(pending & ~CONSOLE_FRAME_FRESH);
+        console_frame* frame = &console->Frames[console->BlittingFrame];
+
+        u64 blitStart = ReadClock();
+
+        ProfileZone("blit")
+        {
+            frame->BlitSize = BlitConsoleFrame(console, frame);
+        }
+
+        frame->BlitDuration = ReadClock() - blitStart;
+        frame->Blitted = true;
+    }
+}
+
+internal
+void PresentConsole(console* console)
+{
+    console->Frames[console->DrawingFrame] = (console_frame){
+        .Cells = console->Cells,
+        .DirtyRows = console->DirtyRows,
+
+        .CaretTop = console->CaretTop,
+        .CaretLeft = console->CaretLeft,
+    };
+
+    i64 previous = AtomicExchange64(
+        &console->PendingFrame,
+        (i64)console->DrawingFrame | CONSOLE_FRAME_FRESH
+    );
+
+    /* Drawing carries on in whichever frame was waiting before. */
+    console->DrawingFrame = (size)(previous & ~CONSOLE_FRAME_FRESH);
+    console->Cells = console->Frames[console->DrawingFrame].Cells;
+    console->DirtyRows = console->Frames[console->DrawingFrame].DirtyRows;
+
+    console->PresentedFrameCount++;
+
+    /*
+        A frame still waiting was never taken, and the output thread has yet to
+        wake up for it, so it takes this one instead.
+    */
+    if (previous & CONSOLE_FRAME_FRESH)
+        console->DroppedFrameCount++;
+
+    else
+        SignalSemaphore(&Platform.FrameSemaphore, 1);
+}
+
+/**
+ * Starts the thread that blits the frames of the given console.
+ *
+ * @param[in|out]	console	The console to blit frames of. It must stay where
+ *							it is until StopConsoleOutput.
+ */
+internal
+void StartConsoleOutput(console* console)
+{
+    SetupSemaphore(&Platform.FrameSemaphore, 0);
+    Platform.OutputQuitting = false;
+
+    if (!StartThread(&Platform.OutputThread, ConsoleOutputThread, console))
+    {
+        Abort(
+            EXIT_COULD_NOT_START_THREAD,
+            "Unable to start the thread that writes to the console."
+        );
+    }
+}
+
+/**
+ * Stops the thread that blits frames, once it has blitted the last frame
+ * presented.
+ */
+internal
+void StopConsoleOutput(void)
+{
+    AtomicStoreRelease(&Platform.OutputQuitting, true);
+    SignalSemaphore(&Platform.FrameSemaphore, 1);
+
+    JoinThread(&Platform.OutputThread);
+
+    TeardownSemaphore(&Platform.FrameSemaphore);
+}
+
+/**
+ * Allocates the arrays for the given number of console cells, and blanks every
+ * cell.
+ *
+ * @param[in]	cellCount	The number of cells to allocate.
+ *
+ * @return	The blank cells.
+ */
+internal
+console_cells AllocateConsoleCells(size cellCount)
+{
+    console_cells cells = {
+        .Glyphs = AllocateTagged(
+            sizeof(u32) * cellCount, ALLOCATION_TAG_CONSOLE
+        ),
+        .Foregrounds = AllocateTagged(cellCount, ALLOCATION_TAG_CONSOLE),
+        .Backgrounds = AllocateTagged(cellCount, ALLOCATION_TAG_CONSOLE),
+        .Attributes = AllocateTagged(cellCount, ALLOCATION_TAG_CONSOLE),
+    };
+
+    MemoryFill32(cells.Glyphs, '\0', cellCount);
+    MemoryFill(cells.Foregrounds, CONSOLE_COLOR_DEFAULT, cellCount);
+    MemoryFill(cells.Backgrounds, CONSOLE_COLOR_DEFAULT, cellCount);
+    MemoryFill(cells.Attributes, CONSOLE_ATTRIBUTE_NONE, cellCount);
+
+    return cells;
+}
+
+/**
+ * Allocates a blank frame of the console, with no dirty rows and no caret.
+ *
+ * @param[in]	width	The width of the console, in cells.
+ * @param[in]	height	The height of the console, in rows.
+ *
+ * @return	The blank frame.
+ */
+internal
+console_frame AllocateConsoleFrame(size width, size height)
+{
+    console_frame frame = {
+        .Cells = AllocateConsoleCells(width * height),
+        .DirtyRows = AllocateTagged(
+            sizeof(u64) * DirtyRowWordCount(height), ALLOCATION_TAG_CONSOLE
+        ),
+
+        .CaretTop = -1,
+        .CaretLeft = -1,
+    };
+
+    MemoryFill(frame.DirtyRows, 0, sizeof(u64) * DirtyRowWordCount(height));
+
+    return frame;
 }
 
 internal
 void ClearConsole(console* console)
 {
-    for (size i = 0; i < console->BufferHeight * console->BufferWidth; i++)
-        console->Buffer[i] = '\0';
+    console_cells* cells = &console->Cells;
+    size width = console->BufferWidth;
+
+    for (size y = 0; y < console->BufferHeight; y++)
+    {
+        size rowStart = y * width;
+
+        /* Rows that are already blank don't need to be blitted again. */
+        if (MemoryIsZero(&cells->Glyphs[rowStart], sizeof(u32) * width)
+            && MemoryIsZero(&cells->Foregrounds[rowStart], width)
+            && MemoryIsZero(&cells->Backgrounds[rowStart], width)
+            && MemoryIsZero(&cells->Attributes[rowStart], width))
+            continue;
+
+        MemoryFill32(&cells->Glyphs[rowStart], '\0', width);
+        MemoryFill(&cells->Foregrounds[rowStart], CONSOLE_COLOR_DEFAULT, width);
+        MemoryFill(&cells->Backgrounds[rowStart], CONSOLE_COLOR_DEFAULT, width);
+        MemoryFill(&cells->Attributes[rowStart], CONSOLE_ATTRIBUTE_NONE, width);
+
+        MarkConsoleRowDirty(console, y);
+    }
 }
 
 internal
@@ -188,27 +1013,54 @@ i32 ConsoleWrite(
     const size stringLength
 )
 {
-    i32 charactersWritten = 0;
-
+    size width = console->BufferWidth;
     size cursorLeft = console->CursorLeft;
     size cursorTop = console->CursorTop;
-    
-    for (size i = 0; i < stringLength; i++)
-    {
-        size left = cursorLeft + i;
-        size top = cursorTop;
 
-        if (left < console->BufferWidth)
-        {
-            console->Buffer[top * console->BufferWidth + left] = string[i];
-            charactersWritten++;
-        }
+    /* Past the last row there is nowhere to write to. */
+    if (console->BufferHeight <= cursorTop || width <= cursorLeft)
+        return 0;
 
-        else
-            break;
-    }
+    console_cells* cells = &console->Cells;
+    size rowStart = cursorTop * width;
+    u32* row = &cells->Glyphs[rowStart];
 
-    return charactersWritten;
+    bool splitsWideCharacter =
+        0 < cursorLeft && row[cursorLeft] == CONSOLE_CELL_WIDE_TAIL;
+
+    size cellsWritten = Utf8ToCells(
+        string, stringLength,
+        &row[cursorLeft], width - cursorLeft
+    );
+
+    if (cellsWritten == 0)
+        return 0;
+
+    size spanStart = rowStart + cursorLeft;
+    MemoryFill(
+        &cells->Foregrounds[spanStart], CONSOLE_COLOR_DEFAULT, cellsWritten
+    );
+    MemoryFill(
+        &cells->Backgrounds[spanStart], CONSOLE_COLOR_DEFAULT, cellsWritten
+    );
+    MemoryFill(
+        &cells->Attributes[spanStart], CONSOLE_ATTRIBUTE_NONE, cellsWritten
+    );
+
+    /*
+        A wide character that is partly written over can't be drawn any more,
+        so what is left of it is blanked.
+    */
+    if (splitsWideCharacter)
+        row[cursorLeft - 1] = '\0';
+
+    size end = cursorLeft + cellsWritten;
+    if (end < width && row[end] == CONSOLE_CELL_WIDE_TAIL)
+        row[end] = '\0';
+
+    MarkConsoleRowDirty(console, cursorTop);
+
+    return (i32)cellsWritten;
 }
 
 internal
@@ -220,55 +1072,194 @@ i32 ConsoleWriteLine(
 {
     i32 charactersWritten = ConsoleWrite(console, string, stringLength);
 
-    console->CursorTop++;
+    if ((size)console->CursorTop < console->BufferHeight)
+        console->CursorTop++;
 
     return charactersWritten;
 }
 
 internal
-i32 ConsoleWriteF(
+i32 _ConsoleWriteF(
     console* console,
     const char* format,
     const size formatSize,
-    ...
+    const format_arg* args,
+    const size argCount
 )
 {
-    arg_list args;
-    SetupArgList(args, formatSize);
+    /* Most text is ASCII, so the rest of the row usually holds all of it. */
+    size capacity = (size)console->CursorLeft < console->BufferWidth
+        ? console->BufferWidth - console->CursorLeft
+        : 0;
 
-    char buffer[128];
-    size stringLength = _FormatString(
-        buffer, 128,
-        format, formatSize,
-        args
+    temporary_memory scratch = BeginTemporaryMemory(&FrameArena);
+
+    string_builder builder;
+    SetupStringBuilder(
+        &builder, &FrameArena, capacity, ALLOCATION_TAG_SCRATCH
     );
+    _StringBuilderAppendF(&builder, format, formatSize, args, argCount);
 
-    TeardownArgList(args);
+    i32 charactersWritten = ConsoleWrite(
+        console, builder.Data, builder.Length
+    );
 
-    return ConsoleWrite(console, buffer, stringLength);
+    EndTemporaryMemory(scratch);
+
+    return charactersWritten;
 }
 
 internal
-i32 ConsoleWriteLineF(
+i32 _ConsoleWriteLineF(
     console* console,
     const char* format,
     const size formatSize,
-    ...
+    const format_arg* args,
+    const size argCount
 )
 {
-    arg_list args;
-    SetupArgList(args, formatSize);
-
-    char buffer[128];
-    size stringLength = _FormatString(
-        buffer, 128,
+    i32 charactersWritten = _ConsoleWriteF(
+        console,
         format, formatSize,
-        args
+        args, argCount
     );
 
-    TeardownArgList(args);
+    if ((size)console->CursorTop < console->BufferHeight)
+        console->CursorTop++;
 
-    return ConsoleWriteLine(console, buffer, stringLength);
+    return charactersWritten;
+}
+
+/**
+ * Runs the procedure of a thread started by StartThread, on that thread.
+ *
+ * @param[in]	parameter	The thread.
+ *
+ * @return	Nothing, as threads have no result to join with.
+ */
+internal
+DWORD WINAPI RunThread(LPVOID parameter)
+{
+    thread* thread = parameter;
+    thread->Procedure(thread->Parameter);
+
+    return 0;
+}
+
+internal
+bool StartThread(
+    thread* thread,
+    thread_procedure* procedure,
+    void* parameter
+)
+{
+    thread->Procedure = procedure;
+    thread->Parameter = parameter;
+
+    HANDLE handle = CreateThread(NULL, 0, RunThread, thread, 0, NULL);
+    if (handle == NULL)
+        return false;
+
+    thread->Handle = (size)handle;
+
+    return true;
+}
+
+internal
+void JoinThread(thread* thread)
+{
+    WaitForSingleObject((HANDLE)thread->Handle, INFINITE);
+    CloseHandle((HANDLE)thread->Handle);
+}
+
+internal
+u32 GetProcessorCount(void)
+{
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+
+    return systemInfo.dwNumberOfProcessors < 1
+        ? 1
+        : systemInfo.dwNumberOfProcessors;
+}
+
+internal
+void SetupSemaphore(semaphore* semaphore, u32 initialCount)
+{
+    HANDLE handle = CreateSemaphoreA(NULL, initialCount, MAXLONG, NULL);
+
+    if (handle == NULL)
+    {
+        Abort(
+            EXIT_COULD_NOT_CREATE_SEMAPHORE,
+            "Unable to create a semaphore."
+        );
+    }
+
+    semaphore->Handle = (size)handle;
+}
+
+internal
+void TeardownSemaphore(semaphore* semaphore)
+{
+    CloseHandle((HANDLE)semaphore->Handle);
+}
+
+internal
+void SignalSemaphore(semaphore* semaphore, u32 count)
+{
+    ReleaseSemaphore((HANDLE)semaphore->Handle, count, NULL);
+}
+
+internal
+void WaitOnSemaphore(semaphore* semaphore)
+{
+    WaitForSingleObject((HANDLE)semaphore->Handle, INFINITE);
+}
+
+internal
+u64 ReadClock(void)
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    /* Whole seconds are split off first, so the count can't overflow. */
+    u64 ticks = counter.QuadPart;
+    u64 frequency = Platform.ClockFrequency;
+
+    return ticks / frequency * 1000000000
+        + ticks % frequency * 1000000000 / frequency;
+}
+
+internal
+wait_result WaitForEvents(const i32 timeoutMilliseconds)
+{
+    HANDLE handles[2] = { Platform.hStandardInput, Platform.hWakeEvent };
+
+    DWORD result = WaitForMultipleObjects(
+        2,
+        handles,
+        FALSE,
+        timeoutMilliseconds == WAIT_FOREVER ? INFINITE : timeoutMilliseconds
+    );
+
+    switch (result)
+    {
+    case WAIT_OBJECT_0:
+        return WAIT_RESULT_INPUT;
+
+    case WAIT_OBJECT_0 + 1:
+        return WAIT_RESULT_WAKEUP;
+
+    default:
+        return WAIT_RESULT_TIMEOUT;
+    }
+}
+
+internal
+void WakeFromWait(void)
+{
+    SetEvent(Platform.hWakeEvent);
 }
 
 internal
@@ -279,40 +1270,81 @@ i32 InputBufferRead(input_buffer* inputBuffer)
     u32 numberOfEvents;
     GetNumberOfConsoleInputEvents(Platform.hStandardInput, &numberOfEvents);
 
+    /*
+        Anything we don't have room for is left with the console until the
+        buffer drains, rather than dropped.
+    */
+    size freeEventCount = inputBuffer->MaxEventCount
+        - (inputBuffer->TailIndex - AtomicLoadAcquire(&inputBuffer->HeadIndex));
+
+    if (64 < numberOfEvents)
+        numberOfEvents = 64;
+
+    if (freeEventCount < numberOfEvents)
+        numberOfEvents = (u32)freeEventCount;
+
+    if (numberOfEvents == 0)
+        return 0;
+
     u32 eventsRead;
-    ReadConsoleInputA(
+    ReadConsoleInputW(
         Platform.hStandardInput,
         inputRecords,
         numberOfEvents,
         &eventsRead
     );
 
-    inputBuffer->EventCount = 0;
-
+    i32 eventsPushed = 0;
     for (size i = 0; i < eventsRead; i++)
     {
-        if (
-            inputBuffer->EventCount < inputBuffer->MaxEventCount
-            && inputRecords[i].EventType == KEY_EVENT
-        )
+        if (inputRecords[i].EventType == KEY_EVENT)
         {
-            inputBuffer->Events[inputBuffer->EventCount] = (input_event){
+            bool control = (
+                inputRecords[i].Event.KeyEvent.dwControlKeyState
+                & (LEFT_CTRL_PRESSED | RIGHT_CTRL_PRESSED)
+            ) != 0;
+
+            u32 character = inputRecords[i].Event.KeyEvent.uChar.UnicodeChar;
+
+            if (0xD800 <= character && character <= 0xDBFF)
+            {
+                if (inputRecords[i].Event.KeyEvent.bKeyDown)
+                    Platform.PendingHighSurrogate = (WCHAR)character;
+
+                continue;
+            }
+
+            if (0xDC00 <= character && character <= 0xDFFF)
+            {
+                WCHAR highSurrogate = Platform.PendingHighSurrogate;
+                if (highSurrogate == 0)
+                    continue;
+
+                character = 0x10000
+                    + ((u32)(highSurrogate - 0xD800) << 10)
+                    + (character - 0xDC00);
+
+                if (!inputRecords[i].Event.KeyEvent.bKeyDown)
+                    Platform.PendingHighSurrogate = 0;
+            }
+
+            input_event event = (input_event){
                 .Key = VirtualKeyToKeyCode(
                     inputRecords[i].Event.KeyEvent.wVirtualKeyCode
                 ),
                 .KeyDown = inputRecords[i].Event.KeyEvent.bKeyDown,
                 .KeyUp = !inputRecords[i].Event.KeyEvent.bKeyDown,
+                .Control = control,
 
-                .Character = inputRecords[i].Event.KeyEvent.uChar.AsciiChar,
+                /* Control turns letters into control characters, not text. */
+                .Character = control ? 0 : character,
             };
 
-            inputBuffer->EventCount++;
+            eventsPushed += PushInputEventTo(inputBuffer, &event);
         }
-        else
-            break;
     }
 
-    return eventsRead;
+    return eventsPushed;
 }
 
 internal
@@ -329,6 +1361,50 @@ keycode VirtualKeyToKeyCode(WORD virtualKey)
     case VK_BACK:
         return KEY_BACKSPACE;
 
+    case VK_F1:
+    case VK_F2:
+    case VK_F3:
+    case VK_F4:
+    case VK_F5:
+    case VK_F6:
+    case VK_F7:
+    case VK_F8:
+    case VK_F9:
+    case VK_F10:
+    case VK_F11:
+    case VK_F12:
+        return KEY_F1 + (virtualKey - VK_F1);
+
+    case VK_LEFT:
+        return KEY_LEFT;
+
+    case VK_RIGHT:
+        return KEY_RIGHT;
+
+    case VK_UP:
+        return KEY_UP;
+
+    case VK_DOWN:
+        return KEY_DOWN;
+
+    case VK_HOME:
+        return KEY_HOME;
+
+    case VK_END:
+        return KEY_END;
+
+    case VK_DELETE:
+        return KEY_DELETE;
+
+    case VK_PRIOR:
+        return KEY_PAGE_UP;
+
+    case VK_NEXT:
+        return KEY_PAGE_DOWN;
+
+    case VK_RETURN:
+        return KEY_ENTER;
+
     case 0x30:
         return KEY_0;
 
@@ -443,14 +1519,54 @@ keycode VirtualKeyToKeyCode(WORD virtualKey)
 }
 
 internal
-input_event* PopInputEventFrom(input_buffer* inputBuffer)
+bool PushInputEventTo(input_buffer* inputBuffer, const input_event* event)
 {
-    return inputBuffer->EventCount
-        ? &inputBuffer->Events[--inputBuffer->EventCount]
+    size tail = inputBuffer->TailIndex;
+    size head = AtomicLoadAcquire(&inputBuffer->HeadIndex);
+
+    if (tail - head == inputBuffer->MaxEventCount)
+    {
+        AtomicStoreRelease(
+            &inputBuffer->DroppedEventCount,
+            inputBuffer->DroppedEventCount + 1
+        );
+
+        return false;
+    }
+
+    inputBuffer->Events[tail & (inputBuffer->MaxEventCount - 1)] = *event;
+    AtomicStoreRelease(&inputBuffer->TailIndex, tail + 1);
+
+    return true;
+}
+
+internal
+bool PopInputEventFrom(input_buffer* inputBuffer, input_event* event)
+{
+    size head = inputBuffer->HeadIndex;
+    size tail = AtomicLoadAcquire(&inputBuffer->TailIndex);
+
+    if (head == tail)
+        return false;
+
+    *event = inputBuffer->Events[head & (inputBuffer->MaxEventCount - 1)];
+    AtomicStoreRelease(&inputBuffer->HeadIndex, head + 1);
+
+    return true;
+}
+
+internal
+input_event* PeekInputEventFrom(input_buffer* inputBuffer)
+{
+    size head = inputBuffer->HeadIndex;
+    size tail = AtomicLoadAcquire(&inputBuffer->TailIndex);
+
+    return head != tail
+        ? &inputBuffer->Events[head & (inputBuffer->MaxEventCount - 1)]
         : NULL;
 }
 
-i32 wmain(void)
+i32 wmain(i32 argumentCount, WCHAR** wideArguments)
 {
     HANDLE hStandardOutput = GetStdHandle(STD_OUTPUT_HANDLE);
     HANDLE hStandardInput = GetStdHandle(STD_INPUT_HANDLE);
@@ -483,41 +1599,137 @@ i32 wmain(void)
                 .hStandardError = hStandardError,
 
                 .hConsole = hConsole,
+                .CursorPosition = bufferInfo.dwCursorPosition,
+                .CursorVisible = false,
+                .DefaultAttributes = bufferInfo.wAttributes,
+
+                .hWakeEvent = CreateEventA(NULL, FALSE, FALSE, NULL),
             };
 
-            SetupMemoryArena(&MemoryArena, Kilobyte(10));
+            if (Platform.hWakeEvent == NULL)
+            {
+                Abort(
+                    EXIT_COULD_NOT_CREATE_WAKEUP_HANDLE,
+                    "Unable to create the event used to wake the main loop."
+                );
+            }
+
+            LARGE_INTEGER clockFrequency;
+            QueryPerformanceFrequency(&clockFrequency);
+            Platform.ClockFrequency = clockFrequency.QuadPart;
+
+            SetupMemoryArena(
+                &MemoryArena,
+                DEFAULT_ARENA_RESERVE_SIZE,
+                ARENA_FLAGS_NONE
+            );
+
+            SetupMemoryArena(&FrameArena, Megabyte(256), ARENA_FLAGS_NONE);
 
-            char* consoleBuffer = Allocate(
-                sizeof(char)
-                * bufferInfo.dwMaximumWindowSize.X
-                * bufferInfo.dwMaximumWindowSize.Y
+            size consoleWidth = bufferInfo.dwMaximumWindowSize.X;
+            size consoleHeight = bufferInfo.dwMaximumWindowSize.Y;
+
+            console_cells consoleFrontCells = AllocateConsoleCells(
+                consoleWidth * consoleHeight
             );
 
-            console c = (console){
-                .Buffer = consoleBuffer,
+            u64* consoleShownRows = AllocateTagged(
+                sizeof(u64) * DirtyRowWordCount(consoleHeight),
+                ALLOCATION_TAG_CONSOLE
+            );
 
-                .BufferWidth = bufferInfo.dwMaximumWindowSize.X,
-                .BufferHeight = bufferInfo.dwMaximumWindowSize.Y,
+            MemoryFill(
+                consoleShownRows,
+                0,
+                sizeof(u64) * DirtyRowWordCount(consoleHeight)
+            );
+
+            Platform.SpanAttributes = AllocateTagged(
+                sizeof(WORD) * consoleWidth, ALLOCATION_TAG_CONSOLE
+            );
+            /* Characters past U+FFFF take two UTF-16 units. */
+            Platform.SpanCharacters = AllocateTagged(
+                sizeof(WCHAR) * 2 * consoleWidth, ALLOCATION_TAG_CONSOLE
+            );
+
+            console c = (console){
+                .BufferWidth = consoleWidth,
+                .BufferHeight = consoleHeight,
 
                 .CursorLeft = bufferInfo.dwCursorPosition.X,
-                .CursorTop = bufferInfo.dwCursorPosition.Y
+                .CursorTop = bufferInfo.dwCursorPosition.Y,
+
+                .CaretLeft = -1,
+                .CaretTop = -1,
+
+                /* One frame is drawn, one waits and one is blitted. */
+                .DrawingFrame = 0,
+                .PendingFrame = 1,
+                .PresentedFrameCount = 0,
+                .DroppedFrameCount = 0,
+
+                .BlittingFrame = 2,
+                .FrontCells = consoleFrontCells,
+                .ShownRows = consoleShownRows,
             };
 
-            input_buffer inputBuffer = (input_buffer){
-                .Events = Allocate(sizeof(input_event) * 32),
-                .EventCount = 0,
+            for (size i = 0; i < CONSOLE_FRAME_COUNT; i++)
+            {
+                c.Frames[i] = AllocateConsoleFrame(
+                    consoleWidth, consoleHeight
+                );
+            }
+
+            c.Cells = c.Frames[c.DrawingFrame].Cells;
+            c.DirtyRows = c.Frames[c.DrawingFrame].DirtyRows;
 
-                .MaxEventCount = 1024,
+            StartConsoleOutput(&c);
+
+            input_buffer inputBuffer = (input_buffer){
+                .Events = AllocateTagged(
+                    sizeof(input_event) * INPUT_BUFFER_SIZE,
+                    ALLOCATION_TAG_INPUT
+                ),
+                .MaxEventCount = INPUT_BUFFER_SIZE,
 
                 .HeadIndex = 0,
                 .TailIndex = 0,
+                .DroppedEventCount = 0,
             };
 
-            Main(&c, &inputBuffer);
+            /* CreateFileA and friends expect paths in the ANSI code page. */
+            char** arguments = AllocateTagged(
+                sizeof(char*) * (argumentCount + 1),
+                ALLOCATION_TAG_UNTAGGED
+            );
 
+            for (i32 i = 0; i < argumentCount; i++)
+            {
+                i32 argumentSize = WideCharToMultiByte(
+                    CP_ACP, 0, wideArguments[i], -1, NULL, 0, NULL, NULL
+                );
+
+                arguments[i] = Allocate(argumentSize);
+                WideCharToMultiByte(
+                    CP_ACP, 0,
+                    wideArguments[i], -1,
+                    arguments[i], argumentSize,
+                    NULL, NULL
+                );
+            }
+
+            arguments[argumentCount] = NULL;
+
+            Main(&c, &inputBuffer, &FrameArena, argumentCount, arguments);
+
+            StopConsoleOutput();
+
+            TeardownMemoryArena(&FrameArena);
             TeardownMemoryArena(&MemoryArena);
 
             SetConsoleActiveScreenBuffer(hStandardOutput);
+
+            CloseHandle(Platform.hWakeEvent);
         }
 
         else
@@ -0,0 +1,289 @@
+#ifndef __ONTOLOGIC_MEMORY_POOL_H__
+#define __ONTOLOGIC_MEMORY_POOL_H__
+
+#include "Standard.h"
+#include "Platform.h"
+
+/*
+    BEGIN MEMORY POOL
+*/
+
+#if defined(_DEBUG)
+    /* Freed elements are filled with this, and checked when handed out again. */
+    #define POOL_FREED_POISON ((u8)0xdd)
+    /* Newly allocated elements are filled with this. */
+    #define POOL_ALLOCATED_POISON ((u8)0xcd)
+#endif
+
+/* A free element in a memory pool, linked through the element's own memory. */
+typedef struct memory_pool_free_element
+{
+    struct memory_pool_free_element* Next;
+}
+memory_pool_free_element;
+
+/* A block of elements carved out of the pool's arena in one allocation. */
+typedef struct memory_pool_slab
+{
+    struct memory_pool_slab* Next;
+}
+memory_pool_slab;
+
+/**
+ * Hands out fixed-size elements carved from slabs of a memory_arena. Freed
+ * elements go onto an intrusive free list and are reused before any new memory
+ * is touched. Slabs are never returned to the arena, but ClearMemoryPool makes
+ * all of them available again at once.
+ */
+typedef struct memory_pool
+{
+    /* The arena that slabs are allocated from. */
+    memory_arena* Arena;
+
+    /* The size of an element, padded to its alignment. */
+    size ElementSize;
+    size ElementAlignment;
+    size ElementsPerSlab;
+
+    /* Elements that were freed and can be handed out again. */
+    memory_pool_free_element* FreeList;
+
+    /* Every slab allocated so far, in the order they were allocated. */
+    memory_pool_slab* FirstSlab;
+    /* The slab new elements are being carved from. */
+    memory_pool_slab* CurrentSlab;
+    /* The next element in the current slab that has never been handed out. */
+    u8* SlabCursor;
+    /* The end of the elements in the current slab. */
+    u8* SlabEnd;
+
+    /* The number of elements currently handed out. */
+    size ElementCount;
+}
+memory_pool;
+
+/**
+ * Initializes a memory_pool that allocates elements of the given size.
+ *
+ * @param[in|out]	pool				The pool to setup.
+ * @param[in|out]	arena				The arena to allocate slabs from.
+ * @param[in]		elementSize			The size of an element, in bytes.
+ * @param[in]		elementAlignment	The alignment of an element. A power of two.
+ * @param[in]		elementsPerSlab		How many elements to allocate at a time.
+ */
+internal void SetupMemoryPool(
+    memory_pool* pool,
+    memory_arena* arena,
+    size elementSize,
+    size elementAlignment,
+    size elementsPerSlab
+)
+{
+    /* Every element has to be able to hold a free list link. */
+    if (elementSize < sizeof(memory_pool_free_element))
+        elementSize = sizeof(memory_pool_free_element);
+
+    if (elementAlignment < _Alignof(memory_pool_free_element))
+        elementAlignment = _Alignof(memory_pool_free_element);
+
+    Assert(0 < elementsPerSlab);
+
+    *pool = (memory_pool){
+        .Arena = arena,
+
+        .ElementSize =
+            (elementSize + (elementAlignment - 1)) & ~(elementAlignment - 1),
+        .ElementAlignment = elementAlignment,
+        .ElementsPerSlab = elementsPerSlab,
+
+        .FreeList = NULL,
+
+        .FirstSlab = NULL,
+        .CurrentSlab = NULL,
+        .SlabCursor = NULL,
+        .SlabEnd = NULL,
+
+        .ElementCount = 0,
+    };
+}
+
+/**
+ * Initializes a memory_pool that allocates elements of type T.
+ *
+ * @param[in|out]	P	The pool to setup.
+ * @param[in|out]	A	The arena to allocate slabs from.
+ * @param[in]		T	The type of the elements.
+ * @param[in]		N	How many elements to allocate at a time.
+ */
+#define SetupMemoryPoolFor(P, A, T, N) \
+    SetupMemoryPool((P), (A), sizeof(T), _Alignof(T), (N))
+
+/**
+ * Finds where the elements of a slab start, after its header.
+ *
+ * @param[in]	pool	The pool the slab belongs to.
+ * @param[in]	slab	The slab to find the elements of.
+ *
+ * @return	A pointer to the first element in the slab.
+ */
+internal inline u8* _MemoryPoolSlabElements(
+    memory_pool* pool,
+    memory_pool_slab* slab
+)
+{
+    size elements = (size)slab + sizeof(memory_pool_slab);
+    return (u8*)(
+        (elements + (pool->ElementAlignment - 1))
+        & ~(pool->ElementAlignment - 1)
+    );
+}
+
+/**
+ * Moves the pool on to the next slab, allocating a new one from the arena if
+ * all of the existing slabs are in use.
+ *
+ * @param[in|out]	pool	The pool to move to the next slab.
+ */
+internal void _MemoryPoolNextSlab(memory_pool* pool)
+{
+    memory_pool_slab* slab = pool->CurrentSlab
+        ? pool->CurrentSlab->Next
+        : pool->FirstSlab;
+
+    if (slab == NULL)
+    {
+        size slabAlignment = pool->ElementAlignment;
+        if (slabAlignment < _Alignof(memory_pool_slab))
+            slabAlignment = _Alignof(memory_pool_slab);
+
+        slab = PushSizeTagged(
+            pool->Arena,
+            sizeof(memory_pool_slab)
+                + pool->ElementAlignment
+                + pool->ElementSize * pool->ElementsPerSlab,
+            slabAlignment,
+            ALLOCATION_TAG_POOL
+        );
+
+        slab->Next = NULL;
+
+        if (pool->CurrentSlab)
+            pool->CurrentSlab->Next = slab;
+
+        else
+            pool->FirstSlab = slab;
+    }
+
+    pool->CurrentSlab = slab;
+    pool->SlabCursor = _MemoryPoolSlabElements(pool, slab);
+    pool->SlabEnd =
+        pool->SlabCursor + pool->ElementSize * pool->ElementsPerSlab;
+}
+
+/**
+ * Takes an element from the pool. Recently freed elements are handed out
+ * first, as they are the most likely to still be in the cache.
+ *
+ * @param[in|out]	pool	The pool to allocate from.
+ *
+ * @return	A pointer to the element. Its contents are undefined.
+ */
+internal void* MemoryPoolAllocate(memory_pool* pool)
+{
+    u8* element;
+
+    if (pool->FreeList)
+    {
+        element = (u8*)pool->FreeList;
+        pool->FreeList = pool->FreeList->Next;
+
+#if defined(_DEBUG)
+        /* Anything that isn't poison was written after the element was freed. */
+        for (
+            size i = sizeof(memory_pool_free_element);
+            i < pool->ElementSize;
+            i++
+        )
+        {
+            AssertWithMessage(
+                element[i] == POOL_FREED_POISON,
+                "A memory pool element was written to after being freed."
+            );
+        }
+#endif
+    }
+
+    else
+    {
+        if (pool->SlabCursor == pool->SlabEnd)
+            _MemoryPoolNextSlab(pool);
+
+        element = pool->SlabCursor;
+        pool->SlabCursor += pool->ElementSize;
+    }
+
+#if defined(_DEBUG)
+    for (size i = 0; i < pool->ElementSize; i++)
+        element[i] = POOL_ALLOCATED_POISON;
+#endif
+
+    pool->ElementCount++;
+
+    return element;
+}
+
+/**
+ * Takes an element of type T from the pool.
+ *
+ * @param[in|out]	P	The pool to allocate from.
+ * @param[in]		T	The type of the element.
+ *
+ * @return	A pointer to the element, as T*.
+ */
+#define MemoryPoolAllocateStruct(P, T) ((T*)MemoryPoolAllocate(P))
+
+/**
+ * Returns an element to the pool so that it can be handed out again.
+ *
+ * @param[in|out]	pool	The pool the element was allocated from.
+ * @param[in]		element	The element to free.
+ */
+internal void MemoryPoolFree(memory_pool* pool, void* element)
+{
+    Assert(element != NULL);
+    Assert(0 < pool->ElementCount);
+
+#if defined(_DEBUG)
+    for (size i = 0; i < pool->ElementSize; i++)
+        ((u8*)element)[i] = POOL_FREED_POISON;
+#endif
+
+    memory_pool_free_element* freeElement = element;
+    freeElement->Next = pool->FreeList;
+    pool->FreeList = freeElement;
+
+    pool->ElementCount--;
+}
+
+/**
+ * Frees every element in the pool at once. The pool's slabs are kept and
+ * reused for later allocations.
+ *
+ * @param[in|out]	pool	The pool to clear.
+ */
+internal inline void ClearMemoryPool(memory_pool* pool)
+{
+    pool->FreeList = NULL;
+
+    pool->CurrentSlab = NULL;
+    pool->SlabCursor = NULL;
+    pool->SlabEnd = NULL;
+
+    pool->ElementCount = 0;
+}
+
+/*
+    END MEMORY POOL
+*/
+
+#endif
@@ -1,45 +1,1454 @@
 #include "Standard.h"
 #include "Platform.h"
+#include "Profile.h"
+#include "MemoryPool.h"
+#include "Jobs.h"
+#include "GapBuffer.h"
+#include "Document.h"
+#include "Scrollback.h"
+#include "UndoJournal.h"
+#include "Search.h"
+#include "Utf8.h"
+#include "StringBuilder.h"
+#include "FrameStats.h"
+
+/* The names of the allocation tags, without their ALLOCATION_TAG_ prefix. */
+global const string AllocationTagNames[] = {
+#define _(TAG) { #TAG + 15, sizeof(#TAG) - 16 },
+    ALLOCATION_TAGS
+#undef _
+};
+
+/**
+ * Formats a report of how the given memory arena has been used, one line per
+ * statistic, followed by a line for every tag that has been allocated under.
+ *
+ * @param[in|out]	builder	The builder to append the report to.
+ * @param[in]		name	The name to give the arena in the report.
+ * @param[in]		arena	The arena to report on.
+ */
+internal void FormatMemoryArenaReport(
+    string_builder* builder,
+    string name,
+    memory_arena* arena
+)
+{
+    memory_arena_stats* stats = &arena->Stats;
+
+    char summaryFormat[] =
+        "%s: %u bytes in use, %u high-water mark, %u committed, %u reserved\n"
+        "  last frame: %u allocations, %u bytes\n";
+
+    StringBuilderAppendF(
+        builder,
+        summaryFormat, sizeof(summaryFormat) - 1,
+        name,
+        (size)arena->Cursor - (size)arena->Start,
+        stats->HighWaterMark,
+        arena->CommittedSize,
+        arena->Size,
+        stats->LastFrameAllocationCount,
+        stats->LastFrameAllocatedBytes
+    );
+
+    char tagFormat[] = "  %s: %u allocations, %u bytes\n";
+    format_descriptor tagDescriptor;
+    ParseFormat(&tagDescriptor, tagFormat, sizeof(tagFormat) - 1);
+
+    for (size tag = 0; tag < ALLOCATION_TAG_COUNT; tag++)
+    {
+        if (stats->TagCounts[tag] == 0)
+            continue;
+
+        StringBuilderAppendParsed(
+            builder,
+            &tagDescriptor,
+            AllocationTagNames[tag],
+            stats->TagCounts[tag],
+            stats->TagBytes[tag]
+        );
+    }
+}
+
+/**
+ * Formats a report covering both the global memory arena and the frame arena.
+ *
+ * @param[in|out]	builder		The builder to append the report to.
+ * @param[in]		frameArena	The arena used for per-frame scratch memory.
+ */
+internal void FormatMemoryReport(
+    string_builder* builder,
+    memory_arena* frameArena
+)
+{
+    FormatMemoryArenaReport(
+        builder,
+        StringLiteral("global"),
+        GetGlobalMemoryArena()
+    );
+
+    FormatMemoryArenaReport(
+        builder,
+        StringLiteral("frame"),
+        frameArena
+    );
+}
+
+/**
+ * Draws the memory report over the console, one line per row, starting at the
+ * given row.
+ *
+ * @param[in|out]	console		The console to draw to.
+ * @param[in]		top			The row to start drawing at.
+ * @param[in]		frameArena	The arena used for per-frame scratch memory.
+ */
+internal void DrawMemoryOverlay(
+    console* console,
+    size top,
+    memory_arena* frameArena
+)
+{
+    string_builder builder;
+    SetupStringBuilder(
+        &builder, frameArena, Kilobyte(1), ALLOCATION_TAG_SCRATCH
+    );
+
+    FormatMemoryReport(&builder, frameArena);
+    string report = StringBuilderToString(&builder);
+
+    console->CursorLeft = 0;
+    console->CursorTop = top;
+
+    size lineStart = 0;
+    for (size i = 0; i < report.Length; i++)
+    {
+        if (report.Data[i] != '\n')
+            continue;
+
+        if (console->BufferHeight <= (size)console->CursorTop)
+            break;
+
+        ConsoleWriteLine(console, &report.Data[lineStart], i - lineStart);
+        lineStart = i + 1;
+    }
+
+    console->CursorLeft = 0;
+    console->CursorTop = 0;
+}
+
+/**
+ * Draws the frame stats over the console on a single row, along with how many
+ * frames and input events have been dropped.
+ *
+ * @param[in|out]	console		The console to draw to.
+ * @param[in]		top			The row to draw on.
+ * @param[in]		stats		The frame stats to draw.
+ * @param[in]		inputBuffer	The input buffer events are dropped from.
+ * @param[in]		frameArena	The arena used for per-frame scratch memory.
+ */
+internal void DrawFrameStatsOverlay(
+    console* console,
+    size top,
+    const frame_stats* stats,
+    input_buffer* inputBuffer,
+    memory_arena* frameArena
+)
+{
+    string_builder builder;
+    SetupStringBuilder(&builder, frameArena, 256, ALLOCATION_TAG_SCRATCH);
+
+    FormatFrameStatsLine(&builder, stats, frameArena);
+
+    char droppedFormat[] = ", dropped %u of %u frames and %u input events";
+    StringBuilderAppendF(
+        &builder,
+        droppedFormat, sizeof(droppedFormat) - 1,
+        console->DroppedFrameCount,
+        console->PresentedFrameCount,
+        AtomicLoadAcquire(&inputBuffer->DroppedEventCount)
+    );
+
+    console->CursorLeft = 0;
+    console->CursorTop = top;
+
+    ConsoleWrite(console, builder.Data, builder.Length);
+
+    console->CursorLeft = 0;
+    console->CursorTop = 0;
+}
+
+/**
+ * Makes an edit to the line being edited, or reverses it. Only the text of the
+ * edit, and the text between it and the cursor, is touched.
+ *
+ * @param[in|out]	line	The line being edited.
+ * @param[in]		edit	The edit to make.
+ * @param[in]		reverse	Whether to reverse the edit instead.
+ */
+internal void ApplyLineEdit(gap_buffer* line, const undo_edit* edit, bool reverse)
+{
+    GapBufferMoveCursor(line, edit->Position);
+
+    if ((edit->Kind == UNDO_EDIT_INSERT) != reverse)
+        GapBufferInsert(line, edit->Text, edit->Length);
+
+    else
+        GapBufferDeleteForward(line, edit->Length);
+}
+
+/**
+ * Finds the length of the character that ends at the given position in the
+ * line being edited.
+ *
+ * @param[in]	line		The line being edited.
+ * @param[in]	position	The position the character ends at.
+ *
+ * @return	The length of the character, or 0 at the start of the line.
+ */
+internal size LineCharacterBefore(gap_buffer* line, size position)
+{
+    char bytes[UTF8_MAX_LENGTH];
+
+    size start = position < UTF8_MAX_LENGTH ? 0 : position - UTF8_MAX_LENGTH;
+    size count = GapBufferCopy(line, start, position - start, bytes);
+
+    if (count == 0)
+        return 0;
+
+    size length = 1;
+    while (length < count && Utf8IsContinuation(bytes[count - length]))
+        length++;
+
+    /* A continuation byte with no lead before it is a character of its own. */
+    if (Utf8IsContinuation(bytes[count - length]))
+        return 1;
+
+    return length;
+}
+
+/**
+ * Finds the length of the character that starts at the given position in the
+ * line being edited.
+ *
+ * @param[in]	line		The line being edited.
+ * @param[in]	position	The position the character starts at.
+ *
+ * @return	The length of the character, or 0 at the end of the line.
+ */
+internal size LineCharacterAfter(gap_buffer* line, size position)
+{
+    char bytes[UTF8_MAX_LENGTH];
+    size count = GapBufferCopy(line, position, UTF8_MAX_LENGTH, bytes);
+
+    if (count == 0)
+        return 0;
+
+    u32 codepoint;
+    return Utf8Decode(bytes, count, &codepoint);
+}
+
+/**
+ * Applies a key press to the line being edited, recording any change to its
+ * text in the journal. Control-Z undoes the last change and Control-Y redoes
+ * it.
+ *
+ * @param[in|out]	line	The line being edited.
+ * @param[in|out]	journal	The journal of the line's edits.
+ * @param[in]		event	The key down event to apply.
+ */
+internal void EditLine(
+    gap_buffer* line,
+    undo_journal* journal,
+    const input_event* event
+)
+{
+    size cursor = GapBufferCursor(line);
+    undo_edit edit;
+
+    if (event->Control)
+    {
+        if (event->Key == KEY_Z && UndoJournalUndo(journal, &edit))
+            ApplyLineEdit(line, &edit, true);
+
+        else if (event->Key == KEY_Y && UndoJournalRedo(journal, &edit))
+            ApplyLineEdit(line, &edit, false);
+
+        return;
+    }
+
+    /* The text is UTF-8, so every change is a whole character at a time. */
+    char text[UTF8_MAX_LENGTH];
+    size textLength;
+
+    switch (event->Key)
+    {
+    case KEY_BACKSPACE:
+        textLength = LineCharacterBefore(line, cursor);
+        if (textLength == 0)
+            break;
+
+        GapBufferCopy(line, cursor - textLength, textLength, text);
+        GapBufferDeleteBackward(line, textLength);
+
+        edit = (undo_edit){
+            UNDO_EDIT_DELETE, cursor - textLength, text, textLength
+        };
+        UndoJournalRecord(journal, &edit);
+        break;
+
+    case KEY_DELETE:
+        textLength = LineCharacterAfter(line, cursor);
+        if (textLength == 0)
+            break;
+
+        GapBufferCopy(line, cursor, textLength, text);
+        GapBufferDeleteForward(line, textLength);
+
+        edit = (undo_edit){ UNDO_EDIT_DELETE, cursor, text, textLength };
+        UndoJournalRecord(journal, &edit);
+        break;
+
+    /* Moving the cursor ends the run of typing that would be undone at once. */
+    case KEY_LEFT:
+        GapBufferMoveCursor(line, cursor - LineCharacterBefore(line, cursor));
+        UndoJournalSeal(journal);
+        break;
+
+    case KEY_RIGHT:
+        GapBufferMoveCursor(line, cursor + LineCharacterAfter(line, cursor));
+        UndoJournalSeal(journal);
+        break;
+
+    case KEY_HOME:
+        GapBufferMoveCursor(line, 0);
+        UndoJournalSeal(journal);
+        break;
+
+    case KEY_END:
+        GapBufferMoveCursor(line, GapBufferLength(line));
+        UndoJournalSeal(journal);
+        break;
+
+    default:
+        if (event->Character != 0)
+        {
+            textLength = Utf8Encode(event->Character, text);
+            GapBufferInsert(line, text, textLength);
+
+            edit = (undo_edit){ UNDO_EDIT_INSERT, cursor, text, textLength };
+            UndoJournalRecord(journal, &edit);
+        }
+        break;
+    }
+}
+
+/**
+ * Draws the line being edited into the given row of the console, scrolled so
+ * that the cursor is visible, and places the caret at the cursor.
+ *
+ * @param[in|out]	console		The console to draw to.
+ * @param[in]		top			The row to draw the line in.
+ * @param[in]		line		The line to draw.
+ * @param[in]		frameArena	The arena used for per-frame scratch memory.
+ */
+internal void DrawLine(
+    console* console,
+    size top,
+    gap_buffer* line,
+    memory_arena* frameArena
+)
+{
+    size width = console->BufferWidth;
+    if (width == 0 || console->BufferHeight <= top)
+        return;
+
+    /*
+        Every cell shown takes at least one byte of the line, and at most
+        UTF8_MAX_LENGTH, so only that many bytes either side of the cursor can
+        be seen.
+    */
+    size cursor = GapBufferCursor(line);
+    size reach = UTF8_MAX_LENGTH * width;
+    size windowStart = cursor < reach ? 0 : cursor - reach;
+
+    char* window = PushArrayTagged(
+        frameArena, char, 2 * reach, ALLOCATION_TAG_SCRATCH
+    );
+    size windowLength = GapBufferCopy(line, windowStart, 2 * reach, window);
+    size cursorOffset = cursor - windowStart;
+
+    size start = 0;
+    while (start < cursorOffset && Utf8IsContinuation(window[start]))
+        start++;
+
+    /* Keep a column free after the text, for the caret to sit in. */
+    size cursorColumn = Utf8Width(&window[start], cursorOffset - start);
+    while (width <= cursorColumn)
+    {
+        u32 codepoint;
+        start += Utf8Decode(&window[start], cursorOffset - start, &codepoint);
+        cursorColumn -= CodepointWidth(codepoint);
+    }
+
+    console->CursorLeft = 0;
+    console->CursorTop = top;
+
+    ConsoleWrite(console, &window[start], windowLength - start);
+
+    console->CaretLeft = cursorColumn;
+    console->CaretTop = top;
+}
+
+/**
+ * Draws the lines of a document into the rows of the console, one row per
+ * line. Only the lines that are visible are read.
+ *
+ * @param[in|out]	console		The console to draw to.
+ * @param[in]		top			The row to draw the first line in.
+ * @param[in]		rowCount	The number of rows to draw.
+ * @param[in]		document	The document to draw.
+ * @param[in]		firstLine	The line to draw in the first row, counting
+ *							from zero.
+ * @param[in]		frameArena	The arena used for per-frame scratch memory.
+ */
+internal void DrawDocument(
+    console* console,
+    size top,
+    size rowCount,
+    document* document,
+    size firstLine,
+    memory_arena* frameArena
+)
+{
+    /* A row of cells can show up to UTF8_MAX_LENGTH bytes per cell. */
+    size rowCapacity = UTF8_MAX_LENGTH * console->BufferWidth;
+    char* row = PushArrayTagged(
+        frameArena, char, rowCapacity, ALLOCATION_TAG_SCRATCH
+    );
+
+    document_iterator iterator = DocumentIteratorAtLine(document, firstLine);
+
+    console->CursorLeft = 0;
+    console->CursorTop = top;
+
+    for (
+        size i = 0;
+        i < rowCount && !iterator.AtEnd
+            && (size)console->CursorTop < console->BufferHeight;
+        i++
+    )
+    {
+        size rowLength = DocumentReadLine(&iterator, row, rowCapacity);
+        ConsoleWriteLine(console, row, rowLength);
+    }
+
+    console->CursorLeft = 0;
+    console->CursorTop = 0;
+}
+
+/**
+ * Finds the line to draw in the top row so that the last line of the document
+ * is drawn in the last row. The first call after text is inserted by reference
+ * reads all of that text, to count its lines.
+ *
+ * @param[in|out]	document	The document to scroll.
+ * @param[in]		rowCount	The number of rows the document is drawn in.
+ *
+ * @return	The line to draw in the top row.
+ */
+internal size DocumentEndTop(document* document, size rowCount)
+{
+    size lineCount = DocumentLineCount(document);
+
+    return rowCount < lineCount ? lineCount - rowCount : 0;
+}
+
+/**
+ * Draws the lines of a scrollback into the rows of the console, one row per
+ * line. Only the lines that are visible are read.
+ *
+ * @param[in|out]	console		The console to draw to.
+ * @param[in]		top			The row to draw the first line in.
+ * @param[in]		rowCount	The number of rows to draw.
+ * @param[in]		scrollback	The scrollback to draw.
+ * @param[in]		firstLine	The line to draw in the first row.
+ */
+internal void DrawScrollback(
+    console* console,
+    size top,
+    size rowCount,
+    scrollback* scrollback,
+    scrollback_position firstLine
+)
+{
+    if (scrollback->LineCount == 0)
+        return;
+
+    scrollback_position position = firstLine;
+    ScrollbackClampPosition(scrollback, &position);
+
+    console->CursorLeft = 0;
+    console->CursorTop = top;
+
+    for (size i = 0; i < rowCount; i++)
+    {
+        string text = ScrollbackLine(scrollback, position);
+        ConsoleWriteLine(console, text.Data, text.Length);
+
+        if (!ScrollbackNext(scrollback, &position))
+            break;
+    }
+
+    console->CursorLeft = 0;
+    console->CursorTop = 0;
+}
+
+/**
+ * Finds the line to draw in the top row so that the newest line of the
+ * scrollback is drawn in the last row.
+ *
+ * @param[in]	scrollback	The scrollback to scroll.
+ * @param[in]	rowCount	The number of rows the scrollback is drawn in.
+ *
+ * @return	The line to draw in the top row.
+ */
+internal scrollback_position ScrollbackEndTop(
+    scrollback* scrollback,
+    size rowCount
+)
+{
+    scrollback_position top = ScrollbackNewest(scrollback);
+
+    for (size i = 1; i < rowCount; i++)
+    {
+        if (!ScrollbackPrevious(scrollback, &top))
+            break;
+    }
+
+    return top;
+}
+
+/**
+ * Moves the text of the line being edited onto the end of the document, as a
+ * line of its own, echoes it to the scrollback, and clears it.
+ *
+ * @param[in|out]	line		The line being edited.
+ * @param[in|out]	document	The document to add the line to.
+ * @param[in|out]	scrollback	The scrollback to echo the line to.
+ * @param[in]		frameArena	The arena used for per-frame scratch memory.
+ */
+internal void CommitLine(
+    gap_buffer* line,
+    document* document,
+    scrollback* scrollback,
+    memory_arena* frameArena
+)
+{
+    size lineLength = GapBufferLength(line);
+
+    temporary_memory scratch = BeginTemporaryMemory(frameArena);
+
+    char* text = PushArrayTagged(
+        frameArena, char, lineLength + 1, ALLOCATION_TAG_SCRATCH
+    );
+    GapBufferCopy(line, 0, lineLength, text);
+    text[lineLength] = '\n';
+
+    /* A file that was opened might not end in a line break. */
+    size documentLength = DocumentLength(document);
+    if (0 < documentLength
+        && DocumentCharAt(document, documentLength - 1) != '\n')
+    {
+        DocumentInsert(document, documentLength, "\n", 1);
+        documentLength++;
+    }
+
+    DocumentInsert(document, documentLength, text, lineLength + 1);
+
+    ScrollbackAppend(scrollback, text, lineLength);
+
+    EndTemporaryMemory(scratch);
+
+    ClearGapBuffer(line);
+}
+
+/**
+ * Loads a file into a document without copying it. A file that can be mapped
+ * is inserted as a single reference to its mapping. Anything else, like a
+ * pipe, is read into chunks of the document's arena, which are inserted by
+ * reference as they fill.
+ *
+ * @param[in|out]	document	The document to load the file into.
+ * @param[out]		file		The file, which has to stay open for as long
+ *								as the document is used.
+ * @param[in]		path		The path of the file to load, NUL terminated.
+ *
+ * @return	True if the file was loaded, false if it could not be opened.
+ */
+internal bool LoadDocumentFile(
+    document* document,
+    file* file,
+    const char* path
+)
+{
+    if (!OpenReadOnlyFile(file, path))
+        return false;
+
+    if (file->Data != NULL)
+    {
+        DocumentInsertReference(document, 0, file->Data, file->Size);
+        return true;
+    }
+
+    size chunkSize = Kilobyte(64);
+    char* chunk = NULL;
+    size chunkUsed = chunkSize;
+
+    forever
+    {
+        if (chunkUsed == chunkSize)
+        {
+            chunk = PushArrayTagged(
+                document->Arena, char, chunkSize, ALLOCATION_TAG_DOCUMENT
+            );
+            chunkUsed = 0;
+        }
+
+        size bytesRead = ReadFileStream(
+            file, chunk + chunkUsed, chunkSize - chunkUsed
+        );
+        if (bytesRead == 0)
+            break;
+
+        DocumentInsertReference(
+            document, DocumentLength(document), chunk + chunkUsed, bytesRead
+        );
+        chunkUsed += bytesRead;
+    }
+
+    return true;
+}
+
+/* The longest query an incremental search can be given. */
+#define SEARCH_QUERY_CAPACITY 256
+
+/**
+ * A search of the document that runs as its query is typed. Every character
+ * typed continues on from where the query without it was found, since the
+ * longer query can't occur any earlier, and erasing a character goes straight
+ * back to where the shorter query was found.
+ */
+typedef struct incremental_search
+{
+    bool Active;
+
+    char Query[SEARCH_QUERY_CAPACITY];
+    size QueryLength;
+
+    /*
+        Where the first i characters of the query were found, or
+        SEARCH_NOT_FOUND. The first entry is where the search started.
+    */
+    size Matches[SEARCH_QUERY_CAPACITY + 1];
+}
+incremental_search;
+
+/**
+ * Starts an incremental search with an empty query.
+ *
+ * @param[out]	search		The search to start.
+ * @param[in]	position	Where in the document to start searching from.
+ */
+internal void BeginIncrementalSearch(
+    incremental_search* search,
+    size position
+)
+{
+    search->Active = true;
+    search->QueryLength = 0;
+    search->Matches[0] = position;
+}
+
+/**
+ * Finds where the whole of the query was found.
+ *
+ * @param[in]	search	The search.
+ *
+ * @return	Where the query was found, or SEARCH_NOT_FOUND.
+ */
+internal inline size IncrementalSearchMatch(incremental_search* search)
+{
+    return search->Matches[search->QueryLength];
+}
+
+/**
+ * Adds a character to the end of the query, and finds the longer query.
+ *
+ * @param[in|out]	search		The search.
+ * @param[in]		document	The document being searched.
+ * @param[in]		character	The character to add.
+ * @param[in]		frameArena	The arena used for per-frame scratch memory.
+ */
+internal void IncrementalSearchType(
+    incremental_search* search,
+    document* document,
+    u32 character,
+    memory_arena* frameArena
+)
+{
+    char text[UTF8_MAX_LENGTH];
+    size textLength = Utf8Encode(character, text);
+
+    if (SEARCH_QUERY_CAPACITY < search->QueryLength + textLength)
+        return;
+
+    size previous = IncrementalSearchMatch(search);
+
+    /*
+        The query is never cut in the middle of a character, but the matches
+        in between are filled in all the same.
+    */
+    for (size i = 0; i < textLength; i++)
+    {
+        search->Query[search->QueryLength++] = text[i];
+        search->Matches[search->QueryLength] = previous;
+    }
+
+    search->Matches[search->QueryLength] = previous == SEARCH_NOT_FOUND
+        ? SEARCH_NOT_FOUND
+        : DocumentSearchForward(
+            document, previous,
+            search->Query, search->QueryLength,
+            frameArena
+        );
+}
+
+/**
+ * Removes the last character of the query.
+ *
+ * @param[in|out]	search	The search.
+ */
+internal inline void IncrementalSearchErase(incremental_search* search)
+{
+    while (
+        0 < search->QueryLength
+        && Utf8IsContinuation(search->Query[search->QueryLength - 1])
+    )
+        search->QueryLength--;
+
+    if (0 < search->QueryLength)
+        search->QueryLength--;
+}
+
+/**
+ * Moves on to the next or previous occurrence of the query, wrapping around
+ * the ends of the document.
+ *
+ * @param[in|out]	search		The search.
+ * @param[in]		document	The document being searched.
+ * @param[in]		forward		Whether to find the next occurrence, rather
+ *								than the previous one.
+ * @param[in]		frameArena	The arena used for per-frame scratch memory.
+ */
+internal void IncrementalSearchAgain(
+    incremental_search* search,
+    document* document,
+    bool forward,
+    memory_arena* frameArena
+)
+{
+    size length = search->QueryLength;
+    size match = IncrementalSearchMatch(search);
+
+    if (length == 0)
+        return;
+
+    size found = SEARCH_NOT_FOUND;
+
+    if (forward)
+    {
+        if (match != SEARCH_NOT_FOUND)
+            found = DocumentSearchForward(
+                document, match + 1, search->Query, length, frameArena
+            );
+
+        if (found == SEARCH_NOT_FOUND)
+            found = DocumentSearchForward(
+                document, 0, search->Query, length, frameArena
+            );
+    }
+
+    else
+    {
+        if (match != SEARCH_NOT_FOUND)
+            found = DocumentSearchBackward(
+                document, match + length - 1, search->Query, length, frameArena
+            );
+
+        if (found == SEARCH_NOT_FOUND)
+            found = DocumentSearchBackward(
+                document, DocumentLength(document),
+                search->Query, length,
+                frameArena
+            );
+    }
+
+    search->Matches[length] = found;
+}
+
+/**
+ * Sets the colors and attributes of a run of cells in one row of the console,
+ * leaving their characters as they are.
+ *
+ * @param[in|out]	console		The console to style.
+ * @param[in]		top			The row the cells are in.
+ * @param[in]		left		The first cell to style.
+ * @param[in]		count		The number of cells to style.
+ * @param[in]		foreground	The console_color to draw the characters in.
+ * @param[in]		background	The console_color to draw behind them.
+ * @param[in]		attributes	The console_attribute flags to draw with.
+ */
+internal void StyleConsoleCells(
+    console* console,
+    size top,
+    size left,
+    size count,
+    console_color foreground,
+    console_color background,
+    console_attribute attributes
+)
+{
+    if (console->BufferHeight <= top || console->BufferWidth <= left)
+        return;
+
+    if (console->BufferWidth - left < count)
+        count = console->BufferWidth - left;
+
+    console_cells* cells = &console->Cells;
+    size start = top * console->BufferWidth + left;
+
+    MemoryFill(&cells->Foregrounds[start], (u8)foreground, count);
+    MemoryFill(&cells->Backgrounds[start], (u8)background, count);
+    MemoryFill(&cells->Attributes[start], (u8)attributes, count);
+
+    MarkConsoleRowDirty(console, top);
+}
+
+/**
+ * Draws the query of a search into the given row of the console, and places
+ * the caret after it.
+ *
+ * @param[in|out]	console	The console to draw to.
+ * @param[in]		top		The row to draw the query in.
+ * @param[in]		search	The search to draw.
+ */
+internal void DrawSearchPrompt(
+    console* console,
+    size top,
+    incremental_search* search
+)
+{
+    if (console->BufferHeight <= top)
+        return;
+
+    bool failing = IncrementalSearchMatch(search) == SEARCH_NOT_FOUND;
+    string prompt = failing
+        ? StringLiteral("Failing search: ")
+        : StringLiteral("Search: ");
+
+    console->CursorLeft = 0;
+    console->CursorTop = top;
+
+    ConsoleWrite(console, prompt.Data, prompt.Length);
+
+    if (failing)
+    {
+        StyleConsoleCells(
+            console, top, 0, prompt.Length,
+            CONSOLE_COLOR_RED, CONSOLE_COLOR_DEFAULT, CONSOLE_ATTRIBUTE_BOLD
+        );
+    }
+
+    /* Show the end of a query too long to fit, as that is what is typed. */
+    size width = console->BufferWidth;
+    size room = prompt.Length + 1 < width ? width - prompt.Length - 1 : 0;
+
+    size skip = 0;
+    size queryWidth = Utf8Width(search->Query, search->QueryLength);
+    while (room < queryWidth)
+    {
+        u32 codepoint;
+        skip += Utf8Decode(
+            &search->Query[skip], search->QueryLength - skip, &codepoint
+        );
+        queryWidth -= CodepointWidth(codepoint);
+    }
+
+    console->CursorLeft = prompt.Length;
+    ConsoleWrite(console, &search->Query[skip], search->QueryLength - skip);
+
+    console->CaretLeft = prompt.Length + queryWidth;
+    console->CaretTop = top;
+
+    console->CursorLeft = 0;
+    console->CursorTop = 0;
+}
+
+/**
+ * Highlights every occurrence of a needle in the given rows of the console,
+ * drawing it in black on yellow.
+ *
+ * @param[in|out]	console			The console to highlight.
+ * @param[in]		top				The first row to highlight in.
+ * @param[in]		rowCount		The number of rows to highlight in.
+ * @param[in]		needle			The text to highlight.
+ * @param[in]		needleLength	The length of the needle.
+ * @param[in]		frameArena		The arena used for per-frame scratch memory.
+ */
+internal void HighlightMatches(
+    console* console,
+    size top,
+    size rowCount,
+    const char* needle,
+    size needleLength,
+    memory_arena* frameArena
+)
+{
+    if (needleLength == 0)
+        return;
+
+    size width = console->BufferWidth;
+
+    /*
+        The needle is turned into cells the way the console would show it, so
+        the rows can be searched as they are, a cell being four bytes.
+    */
+    u32* needleCells = PushArrayTagged(
+        frameArena, u32, 2 * needleLength, ALLOCATION_TAG_SCRATCH
+    );
+    size needleCellCount = Utf8ToCells(
+        needle, needleLength, needleCells, 2 * needleLength
+    );
+
+    if (needleCellCount == 0 || width < needleCellCount)
+        return;
+
+    for (size y = top; y < top + rowCount && y < console->BufferHeight; y++)
+    {
+        const char* row = (const char*)&console->Cells.Glyphs[y * width];
+
+        /* Matches that start partway through a cell don't count. */
+        size offset = 0;
+        forever
+        {
+            size found = SearchForward(
+                &row[offset], width * sizeof(u32) - offset,
+                (const char*)needleCells, needleCellCount * sizeof(u32)
+            );
+
+            if (found == SEARCH_NOT_FOUND)
+                break;
+
+            offset += found;
+            if (offset % sizeof(u32) != 0)
+            {
+                offset++;
+                continue;
+            }
+
+            StyleConsoleCells(
+                console, y, offset / sizeof(u32), needleCellCount,
+                CONSOLE_COLOR_BLACK, CONSOLE_COLOR_YELLOW,
+                CONSOLE_ATTRIBUTE_NONE
+            );
+
+            offset += needleCellCount * sizeof(u32);
+        }
+    }
+}
+
+/**
+ * Finds the line to draw in the top row so that the given position is
+ * visible, scrolling as little as possible. A position that is out of view is
+ * brought into the middle of it.
+ *
+ * @param[in|out]	document	The document being drawn.
+ * @param[in]		top			The line drawn in the top row.
+ * @param[in]		rowCount	The number of rows the document is drawn in.
+ * @param[in]		position	The position to make visible.
+ *
+ * @return	The line to draw in the top row.
+ */
+internal size DocumentTopShowing(
+    document* document,
+    size top,
+    size rowCount,
+    size position
+)
+{
+    size line = DocumentLineOf(document, position);
+
+    if (top <= line && line - top < rowCount)
+        return top;
+
+    return rowCount / 2 < line ? line - rowCount / 2 : 0;
+}
 
 /**
  * This is the main function that runs the Ontologic runtime.
  * 
- * @param[in] console		A pointer to the console instance to write to.
- * @param[in] inputBuffer	A pointer to the buffer used for receiving input events.
+ * @param[in] console			A pointer to the console instance to write to.
+ * @param[in] inputBuffer		A pointer to the buffer used for receiving input events.
+ * @param[in] frameArena		A pointer to the arena used for per-frame scratch memory.
+ * @param[in] argumentCount		The number of command line arguments.
+ * @param[in] arguments			The command line arguments. The first, if any,
+ *								after the program's name is a file to open.
  */
-internal void Main(console* console, input_buffer* inputBuffer)
+internal void Main(
+    console* console,
+    input_buffer* inputBuffer,
+    memory_arena* frameArena,
+    i32 argumentCount,
+    char** arguments
+)
 {
+    NameProfileThread("main");
+
     bool quit = false;
+    bool redraw = true;
+    bool showMemoryOverlay = false;
+    bool showFrameStats = false;
+    bool showScrollback = false;
+
+    /* How long each phase of the loop took, over the last few hundred. */
+    frame_stats frameStats;
+    SetupFrameStats(&frameStats);
+
+    incremental_search search = { .Active = false, .QueryLength = 0 };
+
+    /* Heavy work is split into jobs spread across a worker per processor. */
+    job_system jobs;
+    SetupJobSystem(&jobs, GetGlobalMemoryArena(), 0);
+
+    gap_buffer line;
+    SetupGapBuffer(&line, GetGlobalMemoryArena(), Kilobyte(1));
+
+    undo_journal lineJournal;
+    SetupUndoJournal(&lineJournal, GetGlobalMemoryArena(), Kilobyte(64));
+
+    document document;
+    SetupDocument(&document, GetGlobalMemoryArena());
 
-    size i = 0;
-    char buffer[1024];
+    /* The lines written during the session, dropping the oldest past 1 MB. */
+    scrollback scrollback;
+    SetupScrollback(&scrollback, GetGlobalMemoryArena(), Megabyte(1));
+
+    file file = { .Data = NULL, .Size = 0 };
+    bool fileOpen = false;
+
+    if (1 < argumentCount)
+    {
+        fileOpen = LoadDocumentFile(&document, &file, arguments[1]);
+
+        temporary_memory scratch = BeginTemporaryMemory(frameArena);
+
+        string_builder message;
+        SetupStringBuilder(&message, frameArena, 256, ALLOCATION_TAG_SCRATCH);
+
+        if (fileOpen)
+        {
+            char format[] = "Opened \"%s\", %u bytes.";
+            StringBuilderAppendF(
+                &message,
+                format, sizeof(format) - 1,
+                arguments[1], DocumentLength(&document)
+            );
+        }
+
+        else
+        {
+            char format[] = "Could not open \"%s\".";
+            StringBuilderAppendF(
+                &message,
+                format, sizeof(format) - 1,
+                arguments[1]
+            );
+
+            /* There is nothing else to show, so show why. */
+            showScrollback = true;
+        }
+
+        ScrollbackAppend(&scrollback, message.Data, message.Length);
+
+        EndTemporaryMemory(scratch);
+
+        /*
+            A mapped file is only read as it is shown, and checking it would
+            read all of it up front. Either way, anything that isn't valid is
+            shown as the replacement character.
+        */
+        if (
+            fileOpen && file.Data == NULL
+            && !DocumentIsValidUtf8(&document, MainJobWorker(&jobs))
+        )
+        {
+            string warning = StringLiteral(
+                "It isn't valid UTF-8, so parts of it are shown as "
+                "\xEF\xBF\xBD."
+            );
+            ScrollbackAppend(&scrollback, warning.Data, warning.Length);
+        }
+
+        /* Every job has finished, so their memory can be used again. */
+        ResetJobMemory(&jobs);
+    }
+
+    /* The document fills the console, except for the last row. */
+    size documentRowCount = 1 < console->BufferHeight
+        ? console->BufferHeight - 1
+        : 0;
+    /* The line in the top row, counting from zero. */
+    size documentTop = 0;
+    scrollback_position scrollbackTop = ScrollbackOldest(&scrollback);
 
     until (quit == true)
     {
-        ClearConsole(console);
+        /*
+            Nothing changes on screen unless something happens, so there is no
+            reason to spin until it does.
+        */
+        if (!redraw)
+            WaitForEvents(WAIT_FOREVER);
 
-        ConsoleWrite(console, buffer, i);
+        /* Time spent waiting isn't part of any phase. */
+        u64 inputStart = ReadClock();
 
         InputBufferRead(inputBuffer);
-        if (0 < inputBuffer->EventCount)
+
+        input_event event;
+        ProfileZone("input")
+        while (PopInputEventFrom(inputBuffer, &event))
         {
-            input_event* event;
-            until((event = PopInputEventFrom(inputBuffer)) == NULL)
+            /* Escape ends a search, and only quits once there is none. */
+            if (event.KeyUp && event.Key == KEY_ESCAPE && search.Active)
+            {
+                search.Active = false;
+                redraw = true;
+            }
+
+            else if (event.KeyUp && event.Key == KEY_ESCAPE)
+                quit = true;
+
+            else if (event.KeyDown && event.Control && event.Key == KEY_F
+                && !search.Active)
             {
-                if (event->KeyUp && event->Key == KEY_ESCAPE)
-                    quit = true;
+                BeginIncrementalSearch(
+                    &search, DocumentLineStart(&document, documentTop)
+                );
+                showScrollback = false;
+                redraw = true;
+            }
+
+            else if (event.KeyDown && search.Active
+                && event.Key != KEY_ESCAPE
+                && event.Key != KEY_F2 && event.Key != KEY_F3)
+            {
+                if (event.Key == KEY_ENTER)
+                    search.Active = false;
+
+                else if (event.Control
+                    && (event.Key == KEY_F || event.Key == KEY_R))
+                {
+                    IncrementalSearchAgain(
+                        &search, &document, event.Key == KEY_F, frameArena
+                    );
+                }
 
-                else if (event->KeyDown)
+                else if (event.Key == KEY_BACKSPACE)
+                    IncrementalSearchErase(&search);
+
+                else if (!event.Control && event.Character != '\0')
+                {
+                    IncrementalSearchType(
+                        &search, &document, event.Character, frameArena
+                    );
+                }
+
+                size match = IncrementalSearchMatch(&search);
+                if (match != SEARCH_NOT_FOUND)
                 {
-                    if (event->Key == KEY_BACKSPACE)
-                        buffer[0 < i ? --i : i] = '\0';
+                    documentTop = DocumentTopShowing(
+                        &document, documentTop, documentRowCount, match
+                    );
+                }
+
+                redraw = true;
+            }
+
+            else if (event.KeyDown && event.Key == KEY_F2)
+            {
+                showMemoryOverlay = !showMemoryOverlay;
+                redraw = true;
+            }
+
+            else if (event.KeyDown && event.Key == KEY_F5)
+            {
+                showFrameStats = !showFrameStats;
+                redraw = true;
+            }
+
+            else if (event.KeyDown && event.Key == KEY_F3)
+            {
+                showScrollback = !showScrollback;
+                redraw = true;
+            }
+
+            else if (event.KeyDown
+                && (event.Key == KEY_ENTER || event.Key == KEY_F4))
+            {
+                if (event.Key == KEY_ENTER)
+                {
+                    CommitLine(&line, &document, &scrollback, frameArena);
+
+                    /* The edits were to a line that is no longer there. */
+                    ClearUndoJournal(&lineJournal);
+                }
+
+                /* Scroll to the end, so that the newest line can be seen. */
+                documentTop = DocumentEndTop(&document, documentRowCount);
+                scrollbackTop = ScrollbackEndTop(&scrollback, documentRowCount);
+
+                redraw = true;
+            }
+
+            else if (event.KeyDown
+                && (event.Key == KEY_UP || event.Key == KEY_DOWN
+                    || event.Key == KEY_PAGE_UP || event.Key == KEY_PAGE_DOWN))
+            {
+                size distance = event.Key == KEY_UP || event.Key == KEY_DOWN
+                    ? 1
+                    : documentRowCount;
+
+                bool up = event.Key == KEY_UP || event.Key == KEY_PAGE_UP;
+
+                ScrollbackClampPosition(&scrollback, &scrollbackTop);
+
+                for (size i = 0; i < distance; i++)
+                {
+                    if (showScrollback)
+                    {
+                        bool moved = up
+                            ? ScrollbackPrevious(&scrollback, &scrollbackTop)
+                            : ScrollbackNext(&scrollback, &scrollbackTop);
+
+                        if (!moved)
+                            break;
+                    }
+
+                    else if (up)
+                    {
+                        if (documentTop == 0)
+                            break;
+
+                        documentTop--;
+                    }
 
                     else
-                        buffer[i++] = event->Character;
+                    {
+                        size next;
+                        if (!DocumentFindLine(
+                                &document, documentTop + 1, &next
+                            ))
+                            break;
+
+                        documentTop++;
+                    }
                 }
+
+                redraw = true;
+            }
+
+            else if (event.KeyDown && event.Key != KEY_ESCAPE)
+            {
+                EditLine(&line, &lineJournal, &event);
+                redraw = true;
             }
         }
 
-        BlitConsole(console);
+        u64 drawStart = ReadClock();
+        RecordFrameStat(&frameStats, FRAME_STAT_INPUT, drawStart - inputStart);
+
+        if (redraw)
+        {
+            ProfileZone("draw")
+            {
+                ClearConsole(console);
+
+                if (showScrollback)
+                    DrawScrollback(
+                        console,
+                        0, documentRowCount,
+                        &scrollback, scrollbackTop
+                    );
+
+                else
+                    DrawDocument(
+                        console,
+                        0, documentRowCount,
+                        &document, documentTop,
+                        frameArena
+                    );
+
+                if (search.Active)
+                {
+                    HighlightMatches(
+                        console,
+                        0, documentRowCount,
+                        search.Query, search.QueryLength,
+                        frameArena
+                    );
+
+                    DrawSearchPrompt(console, documentRowCount, &search);
+                }
+
+                else
+                    DrawLine(console, documentRowCount, &line, frameArena);
+
+                if (showMemoryOverlay)
+                    DrawMemoryOverlay(console, 0, frameArena);
+
+                /* Just above the line, out of the way of the memory overlay. */
+                if (showFrameStats && 0 < documentRowCount)
+                {
+                    DrawFrameStatsOverlay(
+                        console,
+                        documentRowCount - 1,
+                        &frameStats,
+                        inputBuffer,
+                        frameArena
+                    );
+                }
+            }
+
+            u64 presentStart = ReadClock();
+            RecordFrameStat(
+                &frameStats, FRAME_STAT_DRAW, presentStart - drawStart
+            );
+
+            ProfileZone("present")
+            {
+                PresentConsole(console);
+            }
+
+            RecordFrameStat(
+                &frameStats, FRAME_STAT_PRESENT, ReadClock() - presentStart
+            );
+
+            /* The frame handed back may have been blitted since last drawn. */
+            console_frame* returnedFrame =
+                &console->Frames[console->DrawingFrame];
+
+            if (returnedFrame->Blitted)
+            {
+                RecordFrameStat(
+                    &frameStats, FRAME_STAT_BLIT, returnedFrame->BlitDuration
+                );
+                RecordFrameStat(
+                    &frameStats, FRAME_STAT_BLIT_SIZE, returnedFrame->BlitSize
+                );
+            }
+
+            redraw = false;
+        }
+
+        ClearMemoryArenaFrameStats(GetGlobalMemoryArena());
+        ClearMemoryArenaFrameStats(frameArena);
+
+        ResetMemoryArena(frameArena);
+    }
+
+    /* Dump the memory report on exit, if asked to, for sizing the arenas. */
+    char reportPath[1024];
+    if (ReadEnvironmentVariable(
+            "ONTOLOGIC_MEMORY_REPORT",
+            reportPath,
+            sizeof(reportPath)
+        ))
+    {
+        string_builder builder;
+        SetupStringBuilder(
+            &builder, frameArena, Kilobyte(1), ALLOCATION_TAG_SCRATCH
+        );
+
+        FormatMemoryReport(&builder, frameArena);
+
+        WriteEntireFile(reportPath, builder.Data, builder.Length);
+    }
+
+    /* Likewise for the frame stats, for comparing the latency of changes. */
+    char statsPath[1024];
+    if (ReadEnvironmentVariable(
+            "ONTOLOGIC_FRAME_STATS",
+            statsPath,
+            sizeof(statsPath)
+        ))
+    {
+        string_builder builder;
+        SetupStringBuilder(
+            &builder, frameArena, Kilobyte(1), ALLOCATION_TAG_SCRATCH
+        );
+
+        FormatFrameStatsCsv(&builder, &frameStats, frameArena);
+
+        /* The counts are rows of a single sample, so the columns still fit. */
+        char countFormat[] = "%s,count,1,%u,%u,%u,%u\n";
+        format_descriptor countDescriptor;
+        ParseFormat(&countDescriptor, countFormat, sizeof(countFormat) - 1);
+
+        size counts[] = {
+            console->PresentedFrameCount,
+            console->DroppedFrameCount,
+            AtomicLoadAcquire(&inputBuffer->DroppedEventCount),
+        };
+        const char* countNames[] = {
+            "presented_frames", "dropped_frames", "dropped_input_events",
+        };
+
+        for (size i = 0; i < ArrayCount(counts); i++)
+        {
+            StringBuilderAppendParsed(
+                &builder,
+                &countDescriptor,
+                countNames[i],
+                counts[i], counts[i], counts[i], counts[i]
+            );
+        }
+
+        WriteEntireFile(statsPath, builder.Data, builder.Length);
+    }
+
+    if (fileOpen)
+        CloseReadOnlyFile(&file);
+
+    TeardownJobSystem(&jobs);
+
+#if defined(ONTOLOGIC_PROFILE)
+    /* Write out the profiled zones, if asked to, as a trace to inspect. */
+    char tracePath[1024];
+    if (ReadEnvironmentVariable(
+            "ONTOLOGIC_TRACE",
+            tracePath,
+            sizeof(tracePath)
+        ))
+    {
+        string_builder builder;
+        SetupStringBuilder(
+            &builder, frameArena, Megabyte(1), ALLOCATION_TAG_SCRATCH
+        );
+
+        FormatProfileTrace(&builder);
+
+        WriteEntireFile(tracePath, builder.Data, builder.Length);
     }
+#endif
 }
@@ -25,6 +25,10 @@ typedef enum exit_code
     EXIT_SYSTEM_OUT_OF_MEMORY,
     EXIT_COULD_NOT_SET_ACTIVE_SCREEN_BUFFER,
     EXIT_COULD_NOT_GET_SCREEN_BUFFER_INFO,
+    EXIT_COULD_NOT_SET_TERMINAL_MODE,
+    EXIT_COULD_NOT_CREATE_WAKEUP_HANDLE,
+    EXIT_COULD_NOT_CREATE_SEMAPHORE,
+    EXIT_COULD_NOT_START_THREAD,
 }
 exit_code;
 
@@ -90,7 +94,7 @@ void _AssertWithMessage(
  */
 #define AssertWithMessage(P, M) \
     _AssertWithMessage( \
-        (P), "Assertion failed: " ## M, sizeof("Assertion failed: " ## M) \
+        (P), "Assertion failed: " M, sizeof("Assertion failed: " M) \
     )
 
 /**
@@ -108,7 +112,7 @@ void _Abort(exit_code, const char*, const size);
  * @param[in]	exitCode	The code to exit with.
  * @param[in]	message		The message, as string literal, to report.
  */
-#define Abort(C, M) _Abort(C, "Aborted: " ## M, sizeof("Aborted: " ## M))
+#define Abort(C, M) _Abort(C, "Aborted: " M, sizeof("Aborted: " M))
 /*
     END ASSERT & ABORT
 */
@@ -117,22 +121,112 @@ void _Abort(exit_code, const char*, const size);
     BEGIN MEMORY
 */
 
-/* A global memory pool used for internal allocations. */
+/* Options that change how a memory_arena manages its pages. */
+typedef enum memory_arena_flags
+{
+    ARENA_FLAGS_NONE = 0,
+    /* Ask the host to back the arena with huge pages, where supported. */
+    ARENA_FLAGS_HUGE_PAGES = 1 << 0,
+    /* Give committed pages back to the host when the arena is reset. */
+    ARENA_FLAGS_DECOMMIT_ON_RESET = 1 << 1,
+}
+memory_arena_flags;
+
+/* Tags used to attribute allocations to the parts of the process making them. */
+#define ALLOCATION_TAGS \
+    _(ALLOCATION_TAG_UNTAGGED) \
+    _(ALLOCATION_TAG_CONSOLE) \
+    _(ALLOCATION_TAG_INPUT) \
+    _(ALLOCATION_TAG_SCRATCH) \
+    _(ALLOCATION_TAG_POOL) \
+    _(ALLOCATION_TAG_TEXT) \
+    _(ALLOCATION_TAG_DOCUMENT) \
+    _(ALLOCATION_TAG_SCROLLBACK) \
+    _(ALLOCATION_TAG_UNDO) \
+    _(ALLOCATION_TAG_JOBS)
+
+/* Tags used to attribute allocations to the parts of the process making them. */
+typedef enum allocation_tag
+{
+#define _(TAG) TAG,
+    ALLOCATION_TAGS
+#undef _
+
+    ALLOCATION_TAG_COUNT
+}
+allocation_tag;
+
+/* Counters describing how a memory_arena has been used. */
+typedef struct memory_arena_stats
+{
+    /* The bytes allocated under each tag, over the life of the arena. */
+    size TagBytes[ALLOCATION_TAG_COUNT];
+    /* The number of allocations made under each tag. */
+    size TagCounts[ALLOCATION_TAG_COUNT];
+
+    /* The most memory the arena has had in use at once. */
+    size HighWaterMark;
+
+    /* The allocations made since the frame counters were last cleared. */
+    size FrameAllocationCount;
+    size FrameAllocatedBytes;
+    /* The allocations made in the frame before they were last cleared. */
+    size LastFrameAllocationCount;
+    size LastFrameAllocatedBytes;
+}
+memory_arena_stats;
+
+/**
+ * A global memory pool used for internal allocations.
+ *
+ * The arena reserves a large range of address space up front, but only commits
+ * the pages backing it as the cursor reaches them, so the memory it uses tracks
+ * what has actually been allocated.
+ */
 typedef struct memory_arena
 {
     void* Start;
     void* Cursor;
+    /* The amount of address space reserved for the arena. */
     size Size;
+    /* The amount of memory, from Start, that is backed by committed pages. */
+    size CommittedSize;
+    memory_arena_flags Flags;
+
+    /* The number of temporary memory scopes currently open on the arena. */
+    size TemporaryCount;
+
+    memory_arena_stats Stats;
 }
 memory_arena;
 
+/* A saved position in a memory_arena that the arena can be rolled back to. */
+typedef struct temporary_memory
+{
+    memory_arena* Arena;
+    void* Cursor;
+}
+temporary_memory;
+
+/* The alignment used by Allocate, suitable for any of the primitive types. */
+#define DEFAULT_ALIGNMENT 16
+
+/* How much address space to reserve for an arena when in doubt. */
+#if defined(_WIN64) || defined(__LP64__)
+    #define DEFAULT_ARENA_RESERVE_SIZE Gigabyte(64)
+#else
+    #define DEFAULT_ARENA_RESERVE_SIZE Megabyte(512)
+#endif
+
 /**
- * Initializes a memory_arena to the specified size.
+ * Initializes a memory_arena by reserving the specified amount of address
+ * space. No memory is committed until it is allocated.
  * 
  * @param[in|out]	memoryArena	The arena to setup.
- * @param[in]		size		The size to initialize the arena as.
+ * @param[in]		size		The amount of address space to reserve.
+ * @param[in]		flags		Options for how the arena manages its pages.
  */
-void SetupMemoryArena(memory_arena*, const size);
+void SetupMemoryArena(memory_arena*, const size, const memory_arena_flags);
 
 /**
  * Frees the memory allocated to the memory_arena.
@@ -142,61 +236,441 @@ void SetupMemoryArena(memory_arena*, const size);
 void TeardownMemoryArena(memory_arena*);
 
 /**
- * Allocates memory in the (global) memory arena for use elsewhere.
+ * The underlying function used for allocating from the (global) memory arena.
+ * This is not intended to be invoked on its own. Instead, use the Allocate and
+ * AllocateTagged macros.
  *
  * @param[in]	allocationSize	The amount of memory, in bytes, to allocate.
+ * @param[in]	tag				The tag to attribute the allocation to.
+ * @param[in]	filepath		The path to the file making the allocation.
+ * @param[in]	line			The line of the file making the allocation.
  *
  * @return	A pointer to the allocated memory.
  */
-void* Allocate(const size allocationSize);
+void* _Allocate(const size, const allocation_tag, const char*, const size);
+
+/**
+ * Allocates memory in the (global) memory arena for use elsewhere.
+ *
+ * @param[in]	S	The amount of memory, in bytes, to allocate.
+ *
+ * @return	A pointer to the allocated memory.
+ */
+#define Allocate(S) \
+    _Allocate((S), ALLOCATION_TAG_UNTAGGED, __FILE__, __LINE__)
+
+/**
+ * Allocates memory in the (global) memory arena, attributed to the given tag.
+ *
+ * @param[in]	S	The amount of memory, in bytes, to allocate.
+ * @param[in]	T	The allocation_tag to attribute the allocation to.
+ *
+ * @return	A pointer to the allocated memory.
+ */
+#define AllocateTagged(S, T) _Allocate((S), (T), __FILE__, __LINE__)
+
+/**
+ * The underlying function used for allocating from a memory arena. This is not
+ * intended to be invoked on its own. Instead, use the PushSize family of
+ * macros.
+ *
+ * @param[in|out]	memoryArena		The arena to allocate from.
+ * @param[in]		allocationSize	The amount of memory, in bytes, to allocate.
+ * @param[in]		alignment		The alignment, in bytes. A power of two.
+ * @param[in]		tag				The tag to attribute the allocation to.
+ * @param[in]		filepath		The path to the file making the allocation.
+ * @param[in]		line			The line of the file making the allocation.
+ *
+ * @return	A pointer to the allocated memory.
+ */
+void* _PushSize(
+    memory_arena*,
+    const size,
+    const size,
+    const allocation_tag,
+    const char*,
+    const size
+);
+
+/**
+ * Allocates memory in the given memory arena, aligned to the given boundary.
+ *
+ * @param[in|out]	A	The arena to allocate from.
+ * @param[in]		S	The amount of memory, in bytes, to allocate.
+ * @param[in]		L	The alignment, in bytes. A power of two.
+ *
+ * @return	A pointer to the allocated memory.
+ */
+#define PushSize(A, S, L) PushSizeTagged(A, S, L, ALLOCATION_TAG_UNTAGGED)
+
+/**
+ * Allocates memory in the given memory arena, aligned to the given boundary and
+ * attributed to the given tag.
+ *
+ * @param[in|out]	A	The arena to allocate from.
+ * @param[in]		S	The amount of memory, in bytes, to allocate.
+ * @param[in]		L	The alignment, in bytes. A power of two.
+ * @param[in]		T	The allocation_tag to attribute the allocation to.
+ *
+ * @return	A pointer to the allocated memory.
+ */
+#define PushSizeTagged(A, S, L, T) \
+    _PushSize((A), (S), (L), (T), __FILE__, __LINE__)
+
+/**
+ * Allocates memory for a value of type T in the given memory arena.
+ *
+ * @param[in|out]	A	The arena to allocate from.
+ * @param[in]		T	The type to allocate memory for.
+ *
+ * @return	A pointer to the allocated T.
+ */
+#define PushStruct(A, T) ((T*)PushSize((A), sizeof(T), _Alignof(T)))
+
+/**
+ * Allocates memory for an array of N values of type T in the given memory arena.
+ *
+ * @param[in|out]	A	The arena to allocate from.
+ * @param[in]		T	The type of the array elements.
+ * @param[in]		N	The number of elements in the array.
+ *
+ * @return	A pointer to the first element of the allocated array.
+ */
+#define PushArray(A, T, N) ((T*)PushSize((A), sizeof(T) * (N), _Alignof(T)))
+
+/**
+ * Allocates memory for an array of N values of type T in the given memory
+ * arena, attributed to the given tag.
+ *
+ * @param[in|out]	A	The arena to allocate from.
+ * @param[in]		T	The type of the array elements.
+ * @param[in]		N	The number of elements in the array.
+ * @param[in]		G	The allocation_tag to attribute the allocation to.
+ *
+ * @return	A pointer to the first element of the allocated array.
+ */
+#define PushArrayTagged(A, T, N, G) \
+    ((T*)PushSizeTagged((A), sizeof(T) * (N), _Alignof(T), (G)))
+
+/**
+ * Clears the per-frame allocation counters of the given memory arena, keeping
+ * their values as the counts for the last frame.
+ *
+ * @param[in|out]	A	The arena to clear the counters of.
+ */
+#define ClearMemoryArenaFrameStats(A) \
+    ( \
+        (A)->Stats.LastFrameAllocationCount = (A)->Stats.FrameAllocationCount, \
+        (A)->Stats.LastFrameAllocatedBytes = (A)->Stats.FrameAllocatedBytes, \
+        (A)->Stats.FrameAllocationCount = 0, \
+        (A)->Stats.FrameAllocatedBytes = 0 \
+    )
+
+/**
+ * Saves the current position of the given memory arena, so that everything
+ * allocated after it can be freed at once by EndTemporaryMemory.
+ *
+ * @param[in|out]	memoryArena	The arena to save the position of.
+ *
+ * @return	The saved position.
+ */
+temporary_memory BeginTemporaryMemory(memory_arena*);
+
+/**
+ * Frees everything allocated in an arena since the matching call to
+ * BeginTemporaryMemory. Scopes must be ended in the reverse order they began.
+ *
+ * @param[in]	temporaryMemory	The position to roll the arena back to.
+ */
+void EndTemporaryMemory(temporary_memory);
+
+/**
+ * Frees everything allocated in the given memory arena. There must be no open
+ * temporary memory scopes on the arena. If the arena was setup with
+ * ARENA_FLAGS_DECOMMIT_ON_RESET, its pages are also given back to the host.
+ *
+ * @param[in|out]	memoryArena	The arena to reset.
+ */
+void ResetMemoryArena(memory_arena*);
+
+/**
+ * Gives the (global) memory arena that Allocate draws from, so that its usage
+ * can be inspected.
+ *
+ * @return	A pointer to the global memory arena.
+ */
+memory_arena* GetGlobalMemoryArena(void);
 
 /*
     END MEMORY
 */
 
+/*
+    BEGIN FILES & ENVIRONMENT
+*/
+
+/**
+ * Reads the value of an environment variable into the given buffer.
+ *
+ * @param[in]		name		The name of the variable, NUL terminated.
+ * @param[in|out]	buffer		The buffer to store the value in, NUL terminated.
+ * @param[in]		bufferSize	The size of the buffer.
+ *
+ * @return	The length of the value, or 0 if the variable is not set or its value
+ *			does not fit in the buffer.
+ */
+size ReadEnvironmentVariable(const char*, char*, const size);
+
+/**
+ * Creates (or replaces) the file at the given path with the given contents.
+ *
+ * @param[in]	path		The path of the file to write, NUL terminated.
+ * @param[in]	data		The bytes to write to the file.
+ * @param[in]	dataSize	The number of bytes to write.
+ *
+ * @return	True if the whole file was written, false otherwise.
+ */
+bool WriteEntireFile(const char*, const void*, const size);
+
+/**
+ * A file opened for reading. Where the platform allows it the file is mapped
+ * into memory, so its pages are only read from disk as they are touched.
+ * Anything that can't be mapped, such as a pipe, is read as a stream instead.
+ */
+typedef struct file
+{
+    /* The contents of the file, if it is mapped, otherwise NULL. */
+    const char* Data;
+    size Size;
+
+    /* The platform's handle for reading the file as a stream, if it isn't. */
+    size Handle;
+}
+file;
+
+/**
+ * Opens the file at the given path for reading, mapping it into memory if
+ * possible.
+ *
+ * @param[out]	file	The file to open.
+ * @param[in]	path	The path of the file to open, NUL terminated.
+ *
+ * @return	True if the file was opened, false otherwise.
+ */
+bool OpenReadOnlyFile(file*, const char*);
+
+/**
+ * Reads the next bytes of a file that could not be mapped into memory.
+ *
+ * @param[in|out]	file		The file to read from.
+ * @param[out]		buffer		The buffer to read into.
+ * @param[in]		bufferSize	The most bytes to read.
+ *
+ * @return	The number of bytes read, or 0 once the end of the file is reached
+ *			or reading fails.
+ */
+size ReadFileStream(file*, void*, const size);
+
+/**
+ * Closes a file opened by OpenReadOnlyFile. Its data can not be used after.
+ *
+ * @param[in|out]	file	The file to close.
+ */
+void CloseReadOnlyFile(file*);
+
+/*
+    END FILES & ENVIRONMENT
+*/
+
 /*
     BEGIN CONSOLE
 */
 
+/* How a cell of the console is drawn, as a set of flags. */
+typedef enum console_attribute
+{
+    CONSOLE_ATTRIBUTE_NONE = 0,
+    /* Drawn with its colors swapped, to pick it out from the rest. */
+    CONSOLE_ATTRIBUTE_HIGHLIGHT = 1 << 0,
+    CONSOLE_ATTRIBUTE_BOLD = 1 << 1,
+    CONSOLE_ATTRIBUTE_UNDERLINE = 1 << 2,
+}
+console_attribute;
+
+/*
+    The colors a cell of the console can be drawn in: the sixteen that every
+    terminal has, in their usual order, after the default. Their exact shades
+    are up to the platform's console.
+*/
+typedef enum console_color
+{
+    /* Whatever the platform's console draws with when not given a color. */
+    CONSOLE_COLOR_DEFAULT = 0,
+
+    CONSOLE_COLOR_BLACK,
+    CONSOLE_COLOR_RED,
+    CONSOLE_COLOR_GREEN,
+    CONSOLE_COLOR_YELLOW,
+    CONSOLE_COLOR_BLUE,
+    CONSOLE_COLOR_MAGENTA,
+    CONSOLE_COLOR_CYAN,
+    CONSOLE_COLOR_WHITE,
+
+    CONSOLE_COLOR_BRIGHT_BLACK,
+    CONSOLE_COLOR_BRIGHT_RED,
+    CONSOLE_COLOR_BRIGHT_GREEN,
+    CONSOLE_COLOR_BRIGHT_YELLOW,
+    CONSOLE_COLOR_BRIGHT_BLUE,
+    CONSOLE_COLOR_BRIGHT_MAGENTA,
+    CONSOLE_COLOR_BRIGHT_CYAN,
+    CONSOLE_COLOR_BRIGHT_WHITE,
+}
+console_color;
+
+/*
+    Fills the cell to the right of a character two cells wide, which the
+    character is drawn over.
+*/
+#define CONSOLE_CELL_WIDE_TAIL ((u32)-1)
+
+/*
+    The cells of a console, row by row. Each property of a cell is kept in an
+    array of its own, rather than the cells in an array of structs, so that
+    clearing or comparing cells runs over contiguous memory. A blank cell is
+    zero in every array.
+*/
+typedef struct console_cells
+{
+    /* The character (codepoint) of each cell. */
+    u32* Glyphs;
+    /* The console_color of each cell's character, and of the cell behind it. */
+    u8* Foregrounds;
+    u8* Backgrounds;
+    /* The console_attribute flags of each cell. */
+    u8* Attributes;
+}
+console_cells;
+
+/*
+    How many frames of the console there are: one being drawn, one waiting to
+    be blitted, and one being blitted.
+*/
+#define CONSOLE_FRAME_COUNT 3
+
+/* Set on the pending frame's index until the output thread has taken it. */
+#define CONSOLE_FRAME_FRESH ((i64)1 << 32)
+
+/* A frame of the console, drawn on one thread and blitted on another. */
+typedef struct console_frame
+{
+    console_cells Cells;
+    /* A bit per row, set when that row may have been written to. */
+    u64* DirtyRows;
+
+    i16 CaretTop;
+    i16 CaretLeft;
+
+    /*
+        Set by the output thread once it has blitted the frame, along with how
+        long that took and how many bytes it sent.
+    */
+    bool Blitted;
+    u64 BlitDuration;
+    size BlitSize;
+}
+console_frame;
+
 /* Defines a platform-independent console for use by the rest of process. */
 typedef struct console
 {
-    char* Buffer;
+    /* The cells that get written to, those of the frame being drawn. */
+    console_cells Cells;
+    /* A bit per row, set when that row of Cells may have been written to. */
+    u64* DirtyRows;
+
     size BufferWidth;
     size BufferHeight;
 
     i16 CursorTop;
     i16 CursorLeft;
+
+    /* Where the platform's own cursor is shown after a blit, or -1 to hide it. */
+    i16 CaretTop;
+    i16 CaretLeft;
+
+    /*
+        Frames are handed from the thread drawing them to the platform's output
+        thread by swapping indices into Frames, so neither waits on the other.
+        The frame being drawn is the one in Cells and DirtyRows.
+    */
+    console_frame Frames[CONSOLE_FRAME_COUNT];
+    size DrawingFrame;
+    /* The frame waiting to be blitted, with CONSOLE_FRAME_FRESH if it is. */
+    volatile i64 PendingFrame;
+    /* The frames presented, and those replaced before they could be blitted. */
+    size PresentedFrameCount;
+    size DroppedFrameCount;
+
+    /* Only touched by the output thread. */
+    size BlittingFrame;
+    /* What the platform's console currently shows, as of the last blit. */
+    console_cells FrontCells;
+    /* A bit per row, set when that row of FrontCells may not be blank. */
+    u64* ShownRows;
 }
 console;
 
 /**
- * Writes the given string to the console at the current cursor position.
+ * Writes the given UTF-8 string to the console at the current cursor position,
+ * in the default colors, with no attributes. Nothing is written once the
+ * cursor has moved past the last row, and a character too wide for what is
+ * left of the row isn't written at all.
  * 
  * @param[in|out]	console			The console to write to.
  * @param[in]		string			The string to write to the console.
  * @param[in]		stringLength	The length of the string being written.
  *
- * @return	The number of characters written to the console.
+ * @return	The number of cells written to the console.
  */
 i32 ConsoleWrite(console*, const char*, const size);
 
 /**
- * Writes the given format string to the console using the arguments at the tail
- * of the argument list.
+ * Writes the given format string to the console using the given arguments.
  * 
  * @param[in|out]	console			The console to write to.
  * @param[in]		format			The format string to use.
  * @param[in]		formatLength	The length of the format string.
- * @param[in]		...				The arguments to use during formatting.
+ * @param[in]		args			The arguments to use during formatting.
+ * @param[in]		argCount		The number of arguments.
+ * 
+ * @return	The number of characters written to the console.
+ */
+i32 _ConsoleWriteF(
+    console*,
+    const char*,
+    const size,
+    const format_arg*,
+    const size
+);
+
+/**
+ * Writes the given format string to the console using the arguments at the tail
+ * of the argument list. See ParseFormat for the specifiers.
+ * 
+ * @param[in|out]	C	The console to write to.
+ * @param[in]		F	The format string to use.
+ * @param[in]		L	The length of the format string.
+ * @param[in]		...	The arguments to use during formatting.
  * 
  * @return	The number of characters written to the console.
  */
-i32 ConsoleWriteF(console*, const char*, const size, ...);
+#define ConsoleWriteF(C, F, L, ...) \
+    _ConsoleWriteF((C), (F), (L), FormatArgs(__VA_ARGS__))
 
 /**
  * Writes the given string to the console at the current cursor position. Once
- * finished, it moves the cursor down one line.
+ * finished, it moves the cursor down one line, unless it is already past the
+ * last row.
  *
  * @param[in|out]	console			The console to write to.
  * @param[in]		string			The string to write to the console.
@@ -208,27 +682,91 @@ i32 ConsoleWriteLine(console*, const char*, const size);
 
 /**
  * Writes the given format string to the console at the current cursor position,
- * using the arguments at the tail of the argument list. Once finished, it moves
- * the cursor down one line.
+ * using the given arguments. Once finished, it moves the cursor down one line.
  *
  * @param[in|out]	console			The console to write to.
  * @param[in]		format			The string to write to the console.
  * @param[in]		formatLength	The length of the string being written.
- * @param[in]		...				The arguments to use during formatting.
+ * @param[in]		args			The arguments to use during formatting.
+ * @param[in]		argCount		The number of arguments.
  *
  * @return	The number of characters written to the console.
  */
-i32 ConsoleWriteLineF(console*, const char*, const size, ...);
+i32 _ConsoleWriteLineF(
+    console*,
+    const char*,
+    const size,
+    const format_arg*,
+    const size
+);
 
 /**
- * "Blits" the console buffer to the platform's console.
+ * Writes the given format string to the console at the current cursor position,
+ * using the arguments at the tail of the argument list. Once finished, it moves
+ * the cursor down one line. See ParseFormat for the specifiers.
  *
- * @param[in]	console	The console to blit.
+ * @param[in|out]	C	The console to write to.
+ * @param[in]		F	The string to write to the console.
+ * @param[in]		L	The length of the string being written.
+ * @param[in]		...	The arguments to use during formatting.
+ *
+ * @return	The number of characters written to the console.
+ */
+#define ConsoleWriteLineF(C, F, L, ...) \
+    _ConsoleWriteLineF((C), (F), (L), FormatArgs(__VA_ARGS__))
+
+/**
+ * Computes the number of u64 words needed for the dirty row bitmap of a console
+ * of the given height.
+ *
+ * @param[in]	H	The height of the console, in rows.
+ *
+ * @return	The number of words in the dirty row bitmap.
+ */
+#define DirtyRowWordCount(H) (((H) + 63) / 64)
+
+/**
+ * Checks whether the given cell of a frame differs from what the platform's
+ * console currently shows.
+ *
+ * @param[in]	C	The console the frame belongs to.
+ * @param[in]	F	A pointer to the cells of the frame.
+ * @param[in]	I	The index of the cell, counting row by row.
+ *
+ * @return	True if any property of the cell has changed since the last blit.
  */
-void BlitConsole(console*);
+#define ConsoleCellChanged(C, F, I) \
+    ((F)->Glyphs[I] != (C)->FrontCells.Glyphs[I] \
+        || (F)->Foregrounds[I] != (C)->FrontCells.Foregrounds[I] \
+        || (F)->Backgrounds[I] != (C)->FrontCells.Backgrounds[I] \
+        || (F)->Attributes[I] != (C)->FrontCells.Attributes[I])
 
 /**
- * Clears the console buffer with '\0'.
+ * Flags the given row of the console as changed since the last blit.
+ *
+ * @param[in|out]	C	The console the row belongs to.
+ * @param[in]		R	The index of the row.
+ */
+#define MarkConsoleRowDirty(C, R) \
+    ((C)->DirtyRows[(R) / 64] |= (1ull << ((R) % 64)))
+
+/**
+ * Hands the frame drawn so far to the platform's output thread, which blits it
+ * to the platform's console as soon as it can. Only the rows flagged as dirty,
+ * or that weren't blank, are inspected, and only the cells that differ from
+ * the front buffer are sent. Never waits on the platform's console: a frame
+ * that is still waiting when the next is handed over is dropped.
+ *
+ * The console is left holding the cells of an older frame, so the next frame
+ * has to start with a ClearConsole.
+ *
+ * @param[in|out]	console	The console to present.
+ */
+void PresentConsole(console*);
+
+/**
+ * Clears every cell of the console to '\0', in the default colors, with no
+ * attributes.
  *
  * @param[in|out]	console	The console to clear.
  */
@@ -238,6 +776,153 @@ void ClearConsole(console*);
     END CONSOLE
 */
 
+/*
+    BEGIN THREADS
+*/
+
+/* A procedure run on a thread of its own. */
+typedef void thread_procedure(void* parameter);
+
+/* A thread started by StartThread. */
+typedef struct thread
+{
+    thread_procedure* Procedure;
+    void* Parameter;
+
+    /* The platform's handle for the thread. */
+    size Handle;
+}
+thread;
+
+/**
+ * Starts running the given procedure on a new thread.
+ *
+ * @param[out]	thread		The thread to start. It must stay where it is until
+ *							the thread is joined.
+ * @param[in]	procedure	The procedure for the thread to run.
+ * @param[in]	parameter	The parameter to pass to the procedure.
+ *
+ * @return	True if the thread was started, false otherwise.
+ */
+bool StartThread(thread*, thread_procedure*, void*);
+
+/**
+ * Blocks the calling thread until the given thread's procedure has returned.
+ *
+ * @param[in|out]	thread	The thread to wait for.
+ */
+void JoinThread(thread*);
+
+/**
+ * Counts the processors the process can run threads on.
+ *
+ * @return	The number of processors, at least 1.
+ */
+u32 GetProcessorCount(void);
+
+/*
+    A counter that threads can block on until another thread raises it. Each
+    wait takes one from the count, blocking while it is 0.
+*/
+typedef struct semaphore
+{
+    /* The platform's handle for the semaphore. */
+    size Handle;
+}
+semaphore;
+
+/**
+ * Initializes a semaphore with the given count. Aborts the process if the
+ * platform can't create one.
+ *
+ * @param[out]	semaphore		The semaphore to setup.
+ * @param[in]	initialCount	The count to start with.
+ */
+void SetupSemaphore(semaphore*, u32);
+
+/**
+ * Frees the resources held by a semaphore. No thread may be waiting on it.
+ *
+ * @param[in|out]	semaphore	The semaphore to teardown.
+ */
+void TeardownSemaphore(semaphore*);
+
+/**
+ * Raises the count of a semaphore, waking up to that many waiting threads.
+ *
+ * @param[in|out]	semaphore	The semaphore to signal.
+ * @param[in]		count		How much to raise the count by.
+ */
+void SignalSemaphore(semaphore*, u32);
+
+/**
+ * Blocks the calling thread until the count of the semaphore is above 0, then
+ * takes one from it.
+ *
+ * @param[in|out]	semaphore	The semaphore to wait on.
+ */
+void WaitOnSemaphore(semaphore*);
+
+/*
+    END THREADS
+*/
+
+/*
+    BEGIN CLOCK
+*/
+
+/**
+ * Reads a clock that only ever moves forward, at a steady rate, no matter what
+ * the system's time of day is set to. Only differences between its readings
+ * mean anything.
+ *
+ * @return	The time on the clock, in nanoseconds.
+ */
+u64 ReadClock(void);
+
+/*
+    END CLOCK
+*/
+
+/*
+    BEGIN WAITING
+*/
+
+/* The reasons WaitForEvents can return for. */
+typedef enum wait_result
+{
+    /* Input from the host system is ready to be read. */
+    WAIT_RESULT_INPUT,
+    /* The timeout elapsed without anything else happening. */
+    WAIT_RESULT_TIMEOUT,
+    /* WakeFromWait was called. */
+    WAIT_RESULT_WAKEUP,
+}
+wait_result;
+
+/* Pass to WaitForEvents to wait without a timeout. */
+#define WAIT_FOREVER -1
+
+/**
+ * Blocks the calling thread until there is input waiting to be read, the
+ * timeout elapses, or another thread calls WakeFromWait.
+ *
+ * @param[in]	timeoutMilliseconds	The longest to wait, or WAIT_FOREVER.
+ *
+ * @return	The reason the wait ended.
+ */
+wait_result WaitForEvents(const i32);
+
+/**
+ * Wakes up a thread blocked in WaitForEvents. If no thread is waiting, the next
+ * call to WaitForEvents returns immediately.
+ */
+void WakeFromWait(void);
+
+/*
+    END WAITING
+*/
+
 /*
     BEGIN INPUT EVENTS
 */
@@ -285,7 +970,29 @@ void ClearConsole(console*);
     _(KEY_6) \
     _(KEY_7) \
     _(KEY_8) \
-    _(KEY_9)
+    _(KEY_9) \
+    _(KEY_F1) \
+    _(KEY_F2) \
+    _(KEY_F3) \
+    _(KEY_F4) \
+    _(KEY_F5) \
+    _(KEY_F6) \
+    _(KEY_F7) \
+    _(KEY_F8) \
+    _(KEY_F9) \
+    _(KEY_F10) \
+    _(KEY_F11) \
+    _(KEY_F12) \
+    _(KEY_LEFT) \
+    _(KEY_RIGHT) \
+    _(KEY_UP) \
+    _(KEY_DOWN) \
+    _(KEY_HOME) \
+    _(KEY_END) \
+    _(KEY_DELETE) \
+    _(KEY_PAGE_UP) \
+    _(KEY_PAGE_DOWN) \
+    _(KEY_ENTER)
 
 /* Platform independent keycodes. */
 typedef enum keycode
@@ -305,29 +1012,50 @@ typedef struct input_event
     bool KeyDown;
     /* True when the key is up, false when the key is down. */
     bool KeyUp;
+    /* True when a control key was held down with the key. */
+    bool Control;
 
-    /* The character that was typed. */
-    char Character;
+    /* The character (codepoint) that was typed, or 0 if none was. */
+    u32 Character;
 }
 input_event;
 
-/* A circular buffer that stores input events received from the host system. */
+/**
+ * A single-producer, single-consumer ring buffer that stores input events
+ * received from the host system. One thread may push events while another
+ * pops them, without any locking.
+ *
+ * HeadIndex and TailIndex only ever increase; the slot they refer to is found
+ * by masking them with MaxEventCount - 1, which is why MaxEventCount must be a
+ * power of two. The buffer is empty when they are equal and full when they are
+ * MaxEventCount apart.
+ */
 typedef struct input_buffer
 {
     /* The events we received from the host. */
     input_event* Events;
-    /* The number of events we are storing. */
-    size EventCount;
     /* The maximum number of events that can be stored in the buffer. */
     size MaxEventCount;
 
-    /* The index to the head of the buffer. */
-    size HeadIndex;
-    /* The index to the tail of the buffer. */
-    size TailIndex;
+    /* The index of the next event to pop. Only written by the consumer. */
+    volatile size HeadIndex;
+    u8 HeadPadding[CACHE_LINE_SIZE - sizeof(size)];
+
+    /* The index the next event is pushed to. Only written by the producer. */
+    volatile size TailIndex;
+    /* The events thrown away because the buffer was full. Producer only. */
+    volatile size DroppedEventCount;
 }
 input_buffer;
 
+/* The number of events the platform's input buffer holds. A power of two. */
+#define INPUT_BUFFER_SIZE 1024
+
+_Static_assert(
+    (INPUT_BUFFER_SIZE & (INPUT_BUFFER_SIZE - 1)) == 0,
+    "INPUT_BUFFER_SIZE must be a power of two."
+);
+
 /**
  * Reads input events from the host system and places them in the given input
  * buffer.
@@ -339,20 +1067,37 @@ input_buffer;
 i32 InputBufferRead(input_buffer*);
 
 /**
- * Pops the first event off the input buffer.
+ * Pushes an event onto the back of the input buffer. Must only be called from
+ * the producing thread. If the buffer is full the event is dropped and counted
+ * in DroppedEventCount.
+ *
+ * @param[in|out]	inputBuffer	The buffer to push the event onto.
+ * @param[in]		event		The event to push.
+ *
+ * @return	True if the event was stored, false if it was dropped.
+ */
+bool PushInputEventTo(input_buffer*, const input_event*);
+
+/**
+ * Pops the first event off the input buffer. Must only be called from the
+ * consuming thread.
  * 
  * @param[in|out]	inputBuffer	The buffer to get the event from.
+ * @param[out]		event		Receives the event popped off the buffer.
  * 
- * @return	A pointer to the input event popped off the buffer.
+ * @return	True if an event was popped, false if the buffer was empty.
  */
-input_event* PopInputEventFrom(input_buffer*);
+bool PopInputEventFrom(input_buffer*, input_event*);
 
 /**
- * Gives a reference to the input event at the front of the input buffer.
+ * Gives a reference to the input event at the front of the input buffer. Must
+ * only be called from the consuming thread, and the reference is only valid
+ * until the event is popped.
  *
  * @param[in]	inputBuffer The buffer to get the event from.
  *
- * @return	A pointer to the input event at the front of the buffer.
+ * @return	A pointer to the input event at the front of the buffer, or NULL if
+ *			the buffer is empty.
  */
 input_event* PeekInputEventFrom(input_buffer*);
 
@@ -0,0 +1,253 @@
+#ifndef __ONTOLOGIC_PROFILE_H__
+#define __ONTOLOGIC_PROFILE_H__
+
+#include "Standard.h"
+#include "Platform.h"
+#include "StringBuilder.h"
+
+/*
+    BEGIN PROFILE
+
+    Zones of code are timed by wrapping them in ProfileZone, and the zones that
+    have been timed are written out as a Chrome trace (chrome://tracing, or
+    Perfetto) by FormatProfileTrace. Unless ONTOLOGIC_PROFILE is defined, all
+    of it compiles out.
+*/
+
+#if defined(ONTOLOGIC_PROFILE)
+
+#if defined(_MSC_VER)
+    #define PROFILE_THREAD_LOCAL __declspec(thread)
+#else
+    #define PROFILE_THREAD_LOCAL _Thread_local
+#endif
+
+/* How many zones each thread can hold until the trace is next formatted. */
+#define PROFILE_RING_CAPACITY 65536
+
+/* How many threads can be profiled. Zones on any more aren't recorded. */
+#define PROFILE_MAX_THREAD_COUNT 32
+
+/* A zone that has been timed. */
+typedef struct profile_event
+{
+    const char* Name;
+    u64 Start;
+    u64 Duration;
+}
+profile_event;
+
+/*
+    The zones timed on one thread. Only that thread adds to the ring, and only
+    FormatProfileTrace takes from it, so neither has to lock.
+*/
+typedef struct profile_ring
+{
+    profile_event Events[PROFILE_RING_CAPACITY];
+
+    volatile i64 Head;
+    u8 HeadPadding[CACHE_LINE_SIZE - sizeof(i64)];
+
+    volatile i64 Tail;
+    u8 TailPadding[CACHE_LINE_SIZE - sizeof(i64)];
+
+    /* The zones that didn't fit, since the ring was full. */
+    volatile i64 DroppedCount;
+
+    /* What to call the thread in the trace, or NULL. */
+    const char* volatile ThreadName;
+}
+profile_ring;
+
+/* A zone being timed. */
+typedef struct profile_zone
+{
+    const char* Name;
+    u64 Start;
+    bool Open;
+}
+profile_zone;
+
+global profile_ring ProfileRings[PROFILE_MAX_THREAD_COUNT];
+global volatile i64 ProfileRingCount;
+
+/* The ring of the calling thread, claimed the first time it is needed. */
+global PROFILE_THREAD_LOCAL profile_ring* ProfileThreadRing;
+
+/**
+ * Gets the calling thread's ring, claiming one for it if it has none yet.
+ *
+ * @return	The ring, or NULL if every ring has been claimed.
+ */
+internal profile_ring* _GetProfileThreadRing(void)
+{
+    if (ProfileThreadRing != NULL)
+        return ProfileThreadRing;
+
+    i64 index = AtomicFetchAdd64(&ProfileRingCount, 1);
+    if (PROFILE_MAX_THREAD_COUNT <= index)
+        return NULL;
+
+    ProfileThreadRing = &ProfileRings[index];
+    return ProfileThreadRing;
+}
+
+/**
+ * Starts timing a zone. Not intended to be used on its own.
+ *
+ * @param[in]	name	The name of the zone.
+ *
+ * @return	The open zone.
+ */
+internal inline profile_zone _BeginProfileZone(const char* name)
+{
+    return (profile_zone){ .Name = name, .Start = ReadClock(), .Open = true };
+}
+
+/**
+ * Stops timing a zone, and records it in the calling thread's ring. Not
+ * intended to be used on its own.
+ *
+ * @param[in|out]	zone	The zone to close.
+ */
+internal void _EndProfileZone(profile_zone* zone)
+{
+    u64 end = ReadClock();
+    zone->Open = false;
+
+    profile_ring* ring = _GetProfileThreadRing();
+    if (ring == NULL)
+        return;
+
+    i64 head = ring->Head;
+
+    if (head - AtomicLoadAcquire(&ring->Tail) == PROFILE_RING_CAPACITY)
+    {
+        AtomicStoreRelease(&ring->DroppedCount, ring->DroppedCount + 1);
+        return;
+    }
+
+    ring->Events[head % PROFILE_RING_CAPACITY] = (profile_event){
+        .Name = zone->Name,
+        .Start = zone->Start,
+        .Duration = end - zone->Start,
+    };
+
+    AtomicStoreRelease(&ring->Head, head + 1);
+}
+
+#define _ProfileZone(N, Z) \
+    for ( \
+        profile_zone Z = _BeginProfileZone(N); \
+        Z.Open; \
+        _EndProfileZone(&Z) \
+    )
+
+/**
+ * Times the statement or block that follows it as a zone of the trace. A
+ * break inside the block ends the zone rather than any loop around it, and
+ * leaving the block by return or goto leaves the zone out of the trace.
+ *
+ * @param[in]	N	The name of the zone. A string literal, with nothing in it
+ *					that JSON would need escaped.
+ */
+#define ProfileZone(N) _ProfileZone((N), TEMP(zone))
+
+/**
+ * Names the calling thread in the trace.
+ *
+ * @param[in]	name	The name of the thread. A string literal, with nothing
+ *						in it that JSON would need escaped.
+ */
+internal void NameProfileThread(const char* name)
+{
+    profile_ring* ring = _GetProfileThreadRing();
+
+    if (ring != NULL)
+        AtomicStoreRelease(&ring->ThreadName, name);
+}
+
+/**
+ * Formats the zones every thread has recorded since the last call as a Chrome
+ * trace, in its JSON object format. The zones are taken from the rings, so
+ * they make room for more.
+ *
+ * @param[in|out]	builder	The builder to append the trace to.
+ */
+internal void FormatProfileTrace(string_builder* builder)
+{
+    string header = StringLiteral("{\"traceEvents\":[\n");
+    StringBuilderAppend(builder, header.Data, header.Length);
+
+    size eventsStart = builder->Length;
+
+    /* Chrome traces count in microseconds, so nanoseconds are fractions. */
+    char eventFormat[] =
+        "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+        "\"ts\":%u.%03u,\"dur\":%u.%03u},\n";
+    format_descriptor eventDescriptor;
+    ParseFormat(&eventDescriptor, eventFormat, sizeof(eventFormat) - 1);
+
+    char threadFormat[] =
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+        "\"args\":{\"name\":\"%s\",\"dropped\":%u}},\n";
+    format_descriptor threadDescriptor;
+    ParseFormat(&threadDescriptor, threadFormat, sizeof(threadFormat) - 1);
+
+    i64 ringCount = AtomicLoadAcquire(&ProfileRingCount);
+    if (PROFILE_MAX_THREAD_COUNT < ringCount)
+        ringCount = PROFILE_MAX_THREAD_COUNT;
+
+    for (i64 i = 0; i < ringCount; i++)
+    {
+        profile_ring* ring = &ProfileRings[i];
+
+        const char* threadName = AtomicLoadAcquire(&ring->ThreadName);
+        StringBuilderAppendParsed(
+            builder,
+            &threadDescriptor,
+            (u64)i,
+            threadName != NULL ? threadName : "thread",
+            (u64)AtomicLoadAcquire(&ring->DroppedCount)
+        );
+
+        i64 head = AtomicLoadAcquire(&ring->Head);
+        i64 tail = ring->Tail;
+
+        for (; tail < head; tail++)
+        {
+            profile_event* event = &ring->Events[tail % PROFILE_RING_CAPACITY];
+
+            StringBuilderAppendParsed(
+                builder,
+                &eventDescriptor,
+                event->Name,
+                (u64)i,
+                event->Start / 1000, event->Start % 1000,
+                event->Duration / 1000, event->Duration % 1000
+            );
+        }
+
+        AtomicStoreRelease(&ring->Tail, tail);
+    }
+
+    /* Every event ends in a comma, which JSON doesn't allow after the last. */
+    if (eventsStart < builder->Length)
+        builder->Length -= 2;
+
+    string footer = StringLiteral("\n]}\n");
+    StringBuilderAppend(builder, footer.Data, footer.Length);
+}
+
+#else
+
+#define ProfileZone(N)
+#define NameProfileThread(N) ((void)0)
+
+#endif
+
+/*
+    END PROFILE
+*/
+
+#endif
@@ -0,0 +1,351 @@
+#ifndef __ONTOLOGIC_SCROLLBACK_H__
+#define __ONTOLOGIC_SCROLLBACK_H__
+
+#include "Standard.h"
+#include "Platform.h"
+
+/*
+    BEGIN SCROLLBACK
+*/
+
+/*
+    Every line is stored as a record: its length, its text padded to the size
+    of a length, and its length again. The length at the end lets the lines be
+    walked backward as easily as forward.
+*/
+typedef u32 scrollback_length;
+
+#define SCROLLBACK_LENGTH_SIZE sizeof(scrollback_length)
+
+/**
+ * Holds the lines that have been written to it in a ring of bytes. Once the
+ * ring is full, the oldest lines are dropped to make room for new ones, so the
+ * memory used is fixed no matter how many lines are written.
+ */
+typedef struct scrollback
+{
+    u8* Buffer;
+    size Capacity;
+
+    /* The offset of the record of the oldest line. */
+    size Start;
+    /* The offset just past the record of the newest line. */
+    size End;
+    /* The offset of the record of the newest line. */
+    size Newest;
+
+    /*
+        Set once new records have wrapped around to the start of the buffer,
+        while older records are still in use at its end. Those older records
+        end at Limit.
+    */
+    bool Wrapped;
+    size Limit;
+
+    /* The number of lines dropped so far, which is the number of the oldest. */
+    size FirstLine;
+    size LineCount;
+}
+scrollback;
+
+/* A line in a scrollback. */
+typedef struct scrollback_position
+{
+    /* The number of the line, counting every line ever written. */
+    size Line;
+    /* The offset of the line's record. */
+    size Offset;
+}
+scrollback_position;
+
+/**
+ * Initializes an empty scrollback.
+ *
+ * @param[in|out]	scrollback	The scrollback to setup.
+ * @param[in|out]	arena		The arena to allocate the ring from.
+ * @param[in]		capacity	The size of the ring, in bytes.
+ */
+internal void SetupScrollback(
+    scrollback* scrollback,
+    memory_arena* arena,
+    size capacity
+)
+{
+    /* Records are padded to the size of a length, and so is the ring. */
+    capacity &= ~(SCROLLBACK_LENGTH_SIZE - 1);
+    Assert(3 * SCROLLBACK_LENGTH_SIZE <= capacity);
+
+    *scrollback = (struct scrollback){
+        /* Lengths are read in place, so the ring is aligned for them. */
+        .Buffer = PushSizeTagged(
+            arena,
+            capacity,
+            _Alignof(scrollback_length),
+            ALLOCATION_TAG_SCROLLBACK
+        ),
+        .Capacity = capacity,
+
+        .Start = 0,
+        .End = 0,
+        .Newest = 0,
+
+        .Wrapped = false,
+        .Limit = 0,
+
+        .FirstLine = 0,
+        .LineCount = 0,
+    };
+}
+
+/**
+ * Computes the size of the record for a line of the given length.
+ *
+ * @param[in]	length	The length of the line.
+ *
+ * @return	The size of the record, in bytes.
+ */
+internal inline size _ScrollbackRecordSize(size length)
+{
+    size paddedLength =
+        (length + (SCROLLBACK_LENGTH_SIZE - 1)) & ~(SCROLLBACK_LENGTH_SIZE - 1);
+
+    return SCROLLBACK_LENGTH_SIZE + paddedLength + SCROLLBACK_LENGTH_SIZE;
+}
+
+/**
+ * Reads a length stored in the ring.
+ *
+ * @param[in]	scrollback	The scrollback to read from.
+ * @param[in]	offset		The offset of the length.
+ *
+ * @return	The length.
+ */
+internal inline size _ScrollbackReadLength(scrollback* scrollback, size offset)
+{
+    return *(scrollback_length*)&scrollback->Buffer[offset];
+}
+
+/**
+ * Drops the oldest line from the scrollback.
+ *
+ * @param[in|out]	scrollback	The scrollback to drop the line from.
+ */
+internal void _ScrollbackDropOldest(scrollback* scrollback)
+{
+    Assert(0 < scrollback->LineCount);
+
+    scrollback->Start += _ScrollbackRecordSize(
+        _ScrollbackReadLength(scrollback, scrollback->Start)
+    );
+
+    scrollback->FirstLine++;
+    scrollback->LineCount--;
+
+    /* The old records at the end of the ring are gone, so it has unwrapped. */
+    if (scrollback->Wrapped && scrollback->Start == scrollback->Limit)
+    {
+        scrollback->Start = 0;
+        scrollback->Wrapped = false;
+    }
+
+    if (scrollback->LineCount == 0)
+    {
+        scrollback->Start = 0;
+        scrollback->End = 0;
+        scrollback->Newest = 0;
+        scrollback->Wrapped = false;
+    }
+}
+
+/**
+ * Writes a line to the end of the scrollback, dropping as many of the oldest
+ * lines as it takes to make room. A line too long to fit in the ring is cut
+ * short.
+ *
+ * @param[in|out]	scrollback	The scrollback to write to.
+ * @param[in]		text		The text of the line, without a line break.
+ * @param[in]		length		The length of the text.
+ */
+internal void ScrollbackAppend(
+    scrollback* scrollback,
+    const char* text,
+    size length
+)
+{
+    size maxLength = scrollback->Capacity - 2 * SCROLLBACK_LENGTH_SIZE;
+    if (maxLength < length)
+        length = maxLength;
+
+    size recordSize = _ScrollbackRecordSize(length);
+
+    forever
+    {
+        if (!scrollback->Wrapped)
+        {
+            if (scrollback->End + recordSize <= scrollback->Capacity)
+                break;
+
+            /* There's no room at the end, so start again at the beginning. */
+            scrollback->Limit = scrollback->End;
+            scrollback->End = 0;
+            scrollback->Wrapped = true;
+        }
+
+        else if (scrollback->End + recordSize <= scrollback->Start)
+            break;
+
+        else
+            _ScrollbackDropOldest(scrollback);
+    }
+
+    size offset = scrollback->End;
+    u8* record = &scrollback->Buffer[offset];
+
+    *(scrollback_length*)record = (scrollback_length)length;
+    MemoryCopy(&record[SCROLLBACK_LENGTH_SIZE], text, length);
+    *(scrollback_length*)&record[recordSize - SCROLLBACK_LENGTH_SIZE] =
+        (scrollback_length)length;
+
+    scrollback->Newest = offset;
+    scrollback->End = offset + recordSize;
+    scrollback->LineCount++;
+}
+
+/**
+ * Finds the oldest line in the scrollback.
+ *
+ * @param[in]	scrollback	The scrollback to search.
+ *
+ * @return	The position of the oldest line.
+ */
+internal inline scrollback_position ScrollbackOldest(scrollback* scrollback)
+{
+    return (scrollback_position){
+        .Line = scrollback->FirstLine,
+        .Offset = scrollback->Start,
+    };
+}
+
+/**
+ * Finds the newest line in the scrollback.
+ *
+ * @param[in]	scrollback	The scrollback to search.
+ *
+ * @return	The position of the newest line, or of where the first line will
+ *			go if the scrollback is empty.
+ */
+internal inline scrollback_position ScrollbackNewest(scrollback* scrollback)
+{
+    size lineCount = scrollback->LineCount;
+
+    return (scrollback_position){
+        .Line = scrollback->FirstLine + (0 < lineCount ? lineCount - 1 : 0),
+        .Offset = scrollback->Newest,
+    };
+}
+
+/**
+ * Makes sure a position still refers to a line in the scrollback, moving it to
+ * the oldest line if its line has been dropped.
+ *
+ * @param[in]		scrollback	The scrollback the position is in.
+ * @param[in|out]	position	The position to check.
+ */
+internal inline void ScrollbackClampPosition(
+    scrollback* scrollback,
+    scrollback_position* position
+)
+{
+    if (position->Line < scrollback->FirstLine)
+        *position = ScrollbackOldest(scrollback);
+}
+
+/**
+ * Moves a position to the line after it.
+ *
+ * @param[in]		scrollback	The scrollback the position is in.
+ * @param[in|out]	position	The position to move.
+ *
+ * @return	True if the position moved, false if it was at the newest line.
+ */
+internal bool ScrollbackNext(
+    scrollback* scrollback,
+    scrollback_position* position
+)
+{
+    if (scrollback->FirstLine + scrollback->LineCount <= position->Line + 1)
+        return false;
+
+    size offset = position->Offset + _ScrollbackRecordSize(
+        _ScrollbackReadLength(scrollback, position->Offset)
+    );
+
+    if (scrollback->Wrapped && offset == scrollback->Limit)
+        offset = 0;
+
+    position->Line++;
+    position->Offset = offset;
+
+    return true;
+}
+
+/**
+ * Moves a position to the line before it.
+ *
+ * @param[in]		scrollback	The scrollback the position is in.
+ * @param[in|out]	position	The position to move.
+ *
+ * @return	True if the position moved, false if it was at the oldest line.
+ */
+internal bool ScrollbackPrevious(
+    scrollback* scrollback,
+    scrollback_position* position
+)
+{
+    if (position->Line <= scrollback->FirstLine)
+        return false;
+
+    size offset = position->Offset;
+    if (offset == 0)
+        offset = scrollback->Limit;
+
+    offset -= _ScrollbackRecordSize(
+        _ScrollbackReadLength(scrollback, offset - SCROLLBACK_LENGTH_SIZE)
+    );
+
+    position->Line--;
+    position->Offset = offset;
+
+    return true;
+}
+
+/**
+ * Finds the text of the line at a position. The text stays in the ring, so it
+ * is only valid until the next line is written.
+ *
+ * @param[in]	scrollback	The scrollback the position is in.
+ * @param[in]	position	The position of the line.
+ *
+ * @return	The text of the line, without a line break.
+ */
+internal inline string ScrollbackLine(
+    scrollback* scrollback,
+    scrollback_position position
+)
+{
+    if (scrollback->LineCount == 0)
+        return MakeString(NULL, 0);
+
+    return MakeString(
+        (const char*)&scrollback->Buffer[
+            position.Offset + SCROLLBACK_LENGTH_SIZE
+        ],
+        _ScrollbackReadLength(scrollback, position.Offset)
+    );
+}
+
+/*
+    END SCROLLBACK
+*/
+
+#endif
@@ -0,0 +1,685 @@
+#ifndef __ONTOLOGIC_SEARCH_H__
+#define __ONTOLOGIC_SEARCH_H__
+
+#include "Standard.h"
+#include "Platform.h"
+#include "Cpu.h"
+
+/*
+    BEGIN SEARCH
+*/
+
+/* Returned by the searches when the needle doesn't occur in the haystack. */
+#define SEARCH_NOT_FOUND ((size)-1)
+
+/*
+    Needles at least this long are searched for with Two-Way, which takes time
+    linear in the length of the haystack no matter what the text is. Shorter
+    needles are cheaper to check for in place when the filter finds a
+    candidate, and there are few enough candidates in real text.
+*/
+#define SEARCH_TWO_WAY_MIN_LENGTH 32
+
+/**
+ * A search for the first or last occurrence of a short needle in a haystack.
+ *
+ * @param[in]	haystack		The text to search.
+ * @param[in]	haystackLength	The length of the text.
+ * @param[in]	needle			The text to search for.
+ * @param[in]	needleLength	The length of the needle. At least 2, and at
+ *								most the length of the haystack.
+ *
+ * @return	Where the occurrence starts, or SEARCH_NOT_FOUND.
+ */
+typedef size search_function(
+    const u8* haystack,
+    size haystackLength,
+    const u8* needle,
+    size needleLength
+);
+
+/* The searches for the best instruction set the processor supports. */
+global search_function* SearchForwardShort = NULL;
+global search_function* SearchBackwardShort = NULL;
+
+/**
+ * Finds the lowest set bit.
+ *
+ * @param[in]	mask	The bits to search. Must not be 0.
+ *
+ * @return	The index of the lowest set bit.
+ */
+internal inline u32 _SearchLowestBit(u32 mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/**
+ * Finds the highest set bit.
+ *
+ * @param[in]	mask	The bits to search. Must not be 0.
+ *
+ * @return	The index of the highest set bit.
+ */
+internal inline u32 _SearchHighestBit(u32 mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return index;
+#else
+    return 31 - __builtin_clz(mask);
+#endif
+}
+
+/**
+ * Compares two runs of bytes.
+ *
+ * @param[in]	a		The first run.
+ * @param[in]	b		The second run.
+ * @param[in]	length	The length of both runs.
+ *
+ * @return	True if the runs are the same, false otherwise.
+ */
+internal inline bool _SearchEqual(const u8* a, const u8* b, size length)
+{
+    for (size i = 0; i < length; i++)
+    {
+        if (a[i] != b[i])
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Finds the first occurrence of a short needle, one position at a time.
+ * See search_function.
+ */
+internal size _SearchForwardScalar(
+    const u8* haystack,
+    size haystackLength,
+    const u8* needle,
+    size needleLength
+)
+{
+    u8 first = needle[0];
+    u8 last = needle[needleLength - 1];
+
+    for (size i = 0; i + needleLength <= haystackLength; i++)
+    {
+        if (haystack[i] == first
+            && haystack[i + needleLength - 1] == last
+            && _SearchEqual(&haystack[i + 1], &needle[1], needleLength - 2))
+            return i;
+    }
+
+    return SEARCH_NOT_FOUND;
+}
+
+/**
+ * Finds the last occurrence of a short needle, one position at a time.
+ * See search_function.
+ */
+internal size _SearchBackwardScalar(
+    const u8* haystack,
+    size haystackLength,
+    const u8* needle,
+    size needleLength
+)
+{
+    u8 first = needle[0];
+    u8 last = needle[needleLength - 1];
+
+    for (size i = haystackLength - needleLength + 1; 0 < i; i--)
+    {
+        if (haystack[i - 1] == first
+            && haystack[i + needleLength - 2] == last
+            && _SearchEqual(&haystack[i], &needle[1], needleLength - 2))
+            return i - 1;
+    }
+
+    return SEARCH_NOT_FOUND;
+}
+
+#if defined(CPU_X86)
+
+/*
+    The vector searches compare a block of positions at once against the first
+    and last bytes of the needle, and only check the rest of the needle at the
+    positions where both match. Whatever is left over at the end the block
+    doesn't fit into is searched one position at a time.
+*/
+
+/**
+ * Finds the first occurrence of a short needle, 16 positions at a time.
+ * See search_function.
+ */
+CPU_TARGET_SSE2
+internal size _SearchForwardSse2(
+    const u8* haystack,
+    size haystackLength,
+    const u8* needle,
+    size needleLength
+)
+{
+    __m128i first = _mm_set1_epi8((char)needle[0]);
+    __m128i last = _mm_set1_epi8((char)needle[needleLength - 1]);
+
+    size positionCount = haystackLength - needleLength + 1;
+
+    size i = 0;
+    for (; i + 16 <= positionCount; i += 16)
+    {
+        __m128i blockFirst = _mm_loadu_si128((const __m128i*)&haystack[i]);
+        __m128i blockLast = _mm_loadu_si128(
+            (const __m128i*)&haystack[i + needleLength - 1]
+        );
+
+        u32 mask = _mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(first, blockFirst),
+            _mm_cmpeq_epi8(last, blockLast)
+        ));
+
+        while (mask != 0)
+        {
+            u32 bit = _SearchLowestBit(mask);
+
+            if (_SearchEqual(
+                    &haystack[i + bit + 1], &needle[1], needleLength - 2
+                ))
+                return i + bit;
+
+            mask &= mask - 1;
+        }
+    }
+
+    size found = _SearchForwardScalar(
+        &haystack[i], haystackLength - i, needle, needleLength
+    );
+
+    return found == SEARCH_NOT_FOUND ? found : i + found;
+}
+
+/**
+ * Finds the last occurrence of a short needle, 16 positions at a time.
+ * See search_function.
+ */
+CPU_TARGET_SSE2
+internal size _SearchBackwardSse2(
+    const u8* haystack,
+    size haystackLength,
+    const u8* needle,
+    size needleLength
+)
+{
+    __m128i first = _mm_set1_epi8((char)needle[0]);
+    __m128i last = _mm_set1_epi8((char)needle[needleLength - 1]);
+
+    /* The positions in [0, end) are still to be searched. */
+    size end = haystackLength - needleLength + 1;
+
+    for (; 16 <= end; end -= 16)
+    {
+        size i = end - 16;
+
+        __m128i blockFirst = _mm_loadu_si128((const __m128i*)&haystack[i]);
+        __m128i blockLast = _mm_loadu_si128(
+            (const __m128i*)&haystack[i + needleLength - 1]
+        );
+
+        u32 mask = _mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(first, blockFirst),
+            _mm_cmpeq_epi8(last, blockLast)
+        ));
+
+        while (mask != 0)
+        {
+            u32 bit = _SearchHighestBit(mask);
+
+            if (_SearchEqual(
+                    &haystack[i + bit + 1], &needle[1], needleLength - 2
+                ))
+                return i + bit;
+
+            mask &= ~(1u << bit);
+        }
+    }
+
+    return _SearchBackwardScalar(
+        haystack, end + needleLength - 1, needle, needleLength
+    );
+}
+
+/**
+ * Finds the first occurrence of a short needle, 32 positions at a time.
+ * See search_function.
+ */
+CPU_TARGET_AVX2
+internal size _SearchForwardAvx2(
+    const u8* haystack,
+    size haystackLength,
+    const u8* needle,
+    size needleLength
+)
+{
+    __m256i first = _mm256_set1_epi8((char)needle[0]);
+    __m256i last = _mm256_set1_epi8((char)needle[needleLength - 1]);
+
+    size positionCount = haystackLength - needleLength + 1;
+
+    size i = 0;
+    for (; i + 32 <= positionCount; i += 32)
+    {
+        __m256i blockFirst = _mm256_loadu_si256((const __m256i*)&haystack[i]);
+        __m256i blockLast = _mm256_loadu_si256(
+            (const __m256i*)&haystack[i + needleLength - 1]
+        );
+
+        u32 mask = (u32)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(first, blockFirst),
+            _mm256_cmpeq_epi8(last, blockLast)
+        ));
+
+        while (mask != 0)
+        {
+            u32 bit = _SearchLowestBit(mask);
+
+            if (_SearchEqual(
+                    &haystack[i + bit + 1], &needle[1], needleLength - 2
+                ))
+                return i + bit;
+
+            mask &= mask - 1;
+        }
+    }
+
+    size found = _SearchForwardScalar(
+        &haystack[i], haystackLength - i, needle, needleLength
+    );
+
+    return found == SEARCH_NOT_FOUND ? found : i + found;
+}
+
+/**
+ * Finds the last occurrence of a short needle, 32 positions at a time.
+ * See search_function.
+ */
+CPU_TARGET_AVX2
+internal size _SearchBackwardAvx2(
+    const u8* haystack,
+    size haystackLength,
+    const u8* needle,
+    size needleLength
+)
+{
+    __m256i first = _mm256_set1_epi8((char)needle[0]);
+    __m256i last = _mm256_set1_epi8((char)needle[needleLength - 1]);
+
+    /* The positions in [0, end) are still to be searched. */
+    size end = haystackLength - needleLength + 1;
+
+    for (; 32 <= end; end -= 32)
+    {
+        size i = end - 32;
+
+        __m256i blockFirst = _mm256_loadu_si256((const __m256i*)&haystack[i]);
+        __m256i blockLast = _mm256_loadu_si256(
+            (const __m256i*)&haystack[i + needleLength - 1]
+        );
+
+        u32 mask = (u32)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(first, blockFirst),
+            _mm256_cmpeq_epi8(last, blockLast)
+        ));
+
+        while (mask != 0)
+        {
+            u32 bit = _SearchHighestBit(mask);
+
+            if (_SearchEqual(
+                    &haystack[i + bit + 1], &needle[1], needleLength - 2
+                ))
+                return i + bit;
+
+            mask &= ~(1u << bit);
+        }
+    }
+
+    return _SearchBackwardScalar(
+        haystack, end + needleLength - 1, needle, needleLength
+    );
+}
+
+#endif
+
+/**
+ * Picks the short needle searches for the given instruction set.
+ *
+ * @param[in]	level	The instruction set to use. It has to be supported.
+ */
+internal void SetupSearch(cpu_level level)
+{
+    switch (level)
+    {
+#if defined(CPU_X86)
+    case CPU_LEVEL_AVX2:
+        SearchForwardShort = _SearchForwardAvx2;
+        SearchBackwardShort = _SearchBackwardAvx2;
+        break;
+
+    case CPU_LEVEL_SSSE3:
+    case CPU_LEVEL_SSE2:
+        SearchForwardShort = _SearchForwardSse2;
+        SearchBackwardShort = _SearchBackwardSse2;
+        break;
+#endif
+
+    default:
+        SearchForwardShort = _SearchForwardScalar;
+        SearchBackwardShort = _SearchBackwardScalar;
+        break;
+    }
+}
+
+/**
+ * Makes sure the searches for the processor's instruction set have been
+ * picked.
+ */
+internal inline void _EnsureSearchSetup(void)
+{
+    if (SearchForwardShort == NULL)
+        SetupSearch(DetectCpuLevel());
+}
+
+/* Reads byte I of P, which is L bytes long, from its end if reversed is set. */
+#define _TwoWayAt(P, L, I) ((reversed) ? (P)[(L) - 1 - (I)] : (P)[I])
+
+/**
+ * Finds the maximal suffix of the needle, under the ordering of bytes or its
+ * reverse, along with the period of that suffix.
+ *
+ * @param[in]	needle			The needle.
+ * @param[in]	needleLength	The length of the needle.
+ * @param[in]	reversed		Whether to read the needle from its end.
+ * @param[in]	descending		Whether to reverse the ordering of bytes.
+ * @param[out]	period			The period of the suffix.
+ *
+ * @return	The position just before where the suffix starts, which is -1 when
+ *			it is the whole needle.
+ */
+internal i64 _TwoWayMaximalSuffix(
+    const u8* needle,
+    i64 needleLength,
+    bool reversed,
+    bool descending,
+    i64* period
+)
+{
+    i64 suffix = -1;
+    i64 j = 0;
+    i64 k = 1;
+    i64 p = 1;
+
+    while (j + k < needleLength)
+    {
+        u8 a = _TwoWayAt(needle, needleLength, j + k);
+        u8 b = _TwoWayAt(needle, needleLength, suffix + k);
+
+        if (descending ? b < a : a < b)
+        {
+            j += k;
+            k = 1;
+            p = j - suffix;
+        }
+
+        else if (a == b)
+        {
+            if (k != p)
+                k++;
+
+            else
+            {
+                j += p;
+                k = 1;
+            }
+        }
+
+        else
+        {
+            suffix = j;
+            j = suffix + 1;
+            k = p = 1;
+        }
+    }
+
+    *period = p;
+    return suffix;
+}
+
+/**
+ * Finds the first occurrence of a needle with the Two-Way algorithm, or the
+ * last occurrence by running it over the reversed text. It takes time linear
+ * in the length of the haystack, however repetitive the text is.
+ *
+ * @param[in]	haystack		The text to search.
+ * @param[in]	haystackLength	The length of the text.
+ * @param[in]	needle			The text to search for.
+ * @param[in]	needleLength	The length of the needle. At least 1, and at
+ *								most the length of the haystack.
+ * @param[in]	reversed		Whether to find the last occurrence.
+ *
+ * @return	Where the occurrence starts, or SEARCH_NOT_FOUND.
+ */
+internal inline size _SearchTwoWay(
+    const u8* haystack,
+    size haystackLength,
+    const u8* needle,
+    size needleLength,
+    bool reversed
+)
+{
+    i64 n = (i64)haystackLength;
+    i64 m = (i64)needleLength;
+
+    /* Split the needle where its left and right halves share the least. */
+    i64 period;
+    i64 otherPeriod;
+    i64 split = _TwoWayMaximalSuffix(needle, m, reversed, false, &period);
+    i64 otherSplit =
+        _TwoWayMaximalSuffix(needle, m, reversed, true, &otherPeriod);
+
+    if (split <= otherSplit)
+    {
+        split = otherSplit;
+        period = otherPeriod;
+    }
+
+    bool periodic = split + 1 + period <= m;
+    for (i64 i = 0; periodic && i <= split; i++)
+    {
+        periodic = _TwoWayAt(needle, m, i)
+            == _TwoWayAt(needle, m, i + period);
+    }
+
+    /*
+        A periodic needle remembers how much of its prefix is already known to
+        match after a shift by its period, so that it isn't compared again.
+    */
+    i64 memory = -1;
+    if (!periodic)
+        period = (split + 1 < m - split - 1 ? m - split - 1 : split + 1) + 1;
+
+    /*
+        With nothing remembered, every shift lands on a position that fails at
+        the first byte after the split unless the two bytes there match. The
+        short search skips straight past those with the vector filter.
+    */
+    bool canSkip = split + 3 <= m;
+    _EnsureSearchSetup();
+
+    i64 j = 0;
+    while (j <= n - m)
+    {
+        if (memory < 0 && canSkip)
+        {
+            size found;
+
+            if (reversed)
+            {
+                size regionStart = m - split - 3;
+                found = SearchBackwardShort(
+                    &haystack[regionStart], n - m - j + 2,
+                    &needle[regionStart], 2
+                );
+
+                if (found == SEARCH_NOT_FOUND)
+                    return SEARCH_NOT_FOUND;
+
+                j = n - split - 3 - (i64)(regionStart + found);
+            }
+
+            else
+            {
+                found = SearchForwardShort(
+                    &haystack[j + split + 1], n - m - j + 2,
+                    &needle[split + 1], 2
+                );
+
+                if (found == SEARCH_NOT_FOUND)
+                    return SEARCH_NOT_FOUND;
+
+                j += found;
+            }
+        }
+
+        i64 i = (split < memory ? memory : split) + 1;
+        while (i < m
+            && _TwoWayAt(needle, m, i) == _TwoWayAt(haystack, n, i + j))
+            i++;
+
+        if (i < m)
+        {
+            j += i - split;
+            memory = -1;
+            continue;
+        }
+
+        i = split;
+        while (memory < i
+            && _TwoWayAt(needle, m, i) == _TwoWayAt(haystack, n, i + j))
+            i--;
+
+        if (i <= memory)
+            return reversed ? (size)(n - j - m) : (size)j;
+
+        j += period;
+        memory = periodic ? m - period - 1 : -1;
+    }
+
+    return SEARCH_NOT_FOUND;
+}
+
+#undef _TwoWayAt
+
+/**
+ * Finds the first occurrence of a needle in a haystack.
+ *
+ * @param[in]	haystack		The text to search.
+ * @param[in]	haystackLength	The length of the text.
+ * @param[in]	needle			The text to search for.
+ * @param[in]	needleLength	The length of the needle.
+ *
+ * @return	Where the first occurrence starts, or SEARCH_NOT_FOUND. An empty
+ *			needle occurs at 0.
+ */
+internal size SearchForward(
+    const char* haystack,
+    size haystackLength,
+    const char* needle,
+    size needleLength
+)
+{
+    const u8* text = (const u8*)haystack;
+    const u8* pattern = (const u8*)needle;
+
+    if (needleLength == 0)
+        return 0;
+
+    if (haystackLength < needleLength)
+        return SEARCH_NOT_FOUND;
+
+    if (needleLength == 1)
+    {
+        for (size i = 0; i < haystackLength; i++)
+        {
+            if (text[i] == pattern[0])
+                return i;
+        }
+
+        return SEARCH_NOT_FOUND;
+    }
+
+    if (SEARCH_TWO_WAY_MIN_LENGTH <= needleLength)
+        return _SearchTwoWay(text, haystackLength, pattern, needleLength, false);
+
+    _EnsureSearchSetup();
+    return SearchForwardShort(text, haystackLength, pattern, needleLength);
+}
+
+/**
+ * Finds the last occurrence of a needle in a haystack.
+ *
+ * @param[in]	haystack		The text to search.
+ * @param[in]	haystackLength	The length of the text.
+ * @param[in]	needle			The text to search for.
+ * @param[in]	needleLength	The length of the needle.
+ *
+ * @return	Where the last occurrence starts, or SEARCH_NOT_FOUND. An empty
+ *			needle occurs at the end of the haystack.
+ */
+internal size SearchBackward(
+    const char* haystack,
+    size haystackLength,
+    const char* needle,
+    size needleLength
+)
+{
+    const u8* text = (const u8*)haystack;
+    const u8* pattern = (const u8*)needle;
+
+    if (needleLength == 0)
+        return haystackLength;
+
+    if (haystackLength < needleLength)
+        return SEARCH_NOT_FOUND;
+
+    if (needleLength == 1)
+    {
+        for (size i = haystackLength; 0 < i; i--)
+        {
+            if (text[i - 1] == pattern[0])
+                return i - 1;
+        }
+
+        return SEARCH_NOT_FOUND;
+    }
+
+    if (SEARCH_TWO_WAY_MIN_LENGTH <= needleLength)
+        return _SearchTwoWay(text, haystackLength, pattern, needleLength, true);
+
+    _EnsureSearchSetup();
+    return SearchBackwardShort(text, haystackLength, pattern, needleLength);
+}
+
+/*
+    END SEARCH
+*/
+
+#endif
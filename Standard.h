@@ -1,7 +1,9 @@
 #ifndef __ONTOLOGIC_STANDARD_H__
 #define __ONTOLOGIC_STANDARD_H__
 
-#define NULL 0
+#ifndef NULL
+    #define NULL 0
+#endif
 
 /*
     BEGIN size_t DEFINITION
@@ -13,7 +15,7 @@
 #if defined(__SIZE_TYPE__)
     _TYPEDEF_SIZE_T(__SIZE_TYPE__)
 #elif defined(_WIN64)
-    _TYPEDEF_SIZE_T(unsigned long)
+    _TYPEDEF_SIZE_T(unsigned long long)
 #elif defined(_WIN32)
     _TYPEDEF_SIZE_T(unsigned long int)
 #else
@@ -30,7 +32,17 @@
     BEGIN NUMERIC TYPE DEFINITION
 */
 
-#if defined(_WIN64)
+#if defined(_WIN32)
+    typedef char				__ontologic_int8;
+    typedef short				__ontologic_int16;
+    typedef int					__ontologic_int32;
+    typedef long long			__ontologic_int64;
+
+    typedef unsigned char		__ontologic_uint8;
+    typedef unsigned short		__ontologic_uint16;
+    typedef unsigned int		__ontologic_uint32;
+    typedef unsigned long long	__ontologic_uint64;
+#elif defined(__LP64__)
     typedef char				__ontologic_int8;
     typedef short				__ontologic_int16;
     typedef int					__ontologic_int32;
@@ -40,7 +52,7 @@
     typedef unsigned short		__ontologic_uint16;
     typedef unsigned int		__ontologic_uint32;
     typedef unsigned long		__ontologic_uint64;
-#elif defined(_WIN32)
+#elif defined(__GNUC__)
     typedef char				__ontologic_int8;
     typedef short				__ontologic_int16;
     typedef int					__ontologic_int32;
@@ -50,6 +62,8 @@
     typedef unsigned short		__ontologic_uint16;
     typedef unsigned int		__ontologic_uint32;
     typedef unsigned long long	__ontologic_uint64;
+#else
+    #error Unable to define numeric types!
 #endif
 
 typedef float		__ontologic_float32;
@@ -88,6 +102,43 @@ typedef long double	__ontologic_float128;
     END BOOLEAN CONSTANTS
 */
 
+/*
+    BEGIN STRING DEFINITION
+*/
+
+/* A run of characters and its length. The characters need not end in '\0'. */
+typedef struct __ontologic_string
+{
+    const char* Data;
+    size Length;
+}
+__ontologic_string;
+
+#define string __ontologic_string
+
+/**
+ * Creates a string from a pointer and a length.
+ *
+ * @param[in]	P	A pointer to the characters of the string.
+ * @param[in]	L	The number of characters in the string.
+ *
+ * @return	The string.
+ */
+#define MakeString(P, L) ((string){ (P), (L) })
+
+/**
+ * Creates a string from a string literal, without its '\0'.
+ *
+ * @param[in]	S	The string literal.
+ *
+ * @return	The string.
+ */
+#define StringLiteral(S) ((string){ (S), sizeof(S) - 1 })
+
+/*
+    END STRING DEFINITION
+*/
+
 /*
     BEGIN STATIC ALIAS MACROS
 */
@@ -131,6 +182,15 @@ typedef long double	__ontologic_float128;
  */
 #define Gigabyte(N) (Megabyte(N) * 1024ull)
 
+/**
+ * Computes the number of elements in a fixed size array.
+ *
+ * @param[in]	A	The array.
+ *
+ * @return	The number of elements in the array.
+ */
+#define ArrayCount(A) (sizeof(A) / sizeof((A)[0]))
+
 /*
     END MEMORY SIZE MACROS
 */
@@ -174,6 +234,49 @@ typedef long double	__ontologic_float128;
     #error Unable to define TEMP()!
 #endif
 
+/**
+ * Counts the number of arguments passed to it, from 1 up to 16.
+ *
+ * @param[in]	...	The arguments to count.
+ *
+ * @return	The number of arguments.
+ */
+#define CountArgs(...) \
+    _COUNT_ARGS(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)
+
+#define _COUNT_ARGS( \
+    _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, N, \
+    ... \
+) N
+
+#define _MAP_ARGS_1(F, X) F(X)
+#define _MAP_ARGS_2(F, X, ...) F(X), _MAP_ARGS_1(F, __VA_ARGS__)
+#define _MAP_ARGS_3(F, X, ...) F(X), _MAP_ARGS_2(F, __VA_ARGS__)
+#define _MAP_ARGS_4(F, X, ...) F(X), _MAP_ARGS_3(F, __VA_ARGS__)
+#define _MAP_ARGS_5(F, X, ...) F(X), _MAP_ARGS_4(F, __VA_ARGS__)
+#define _MAP_ARGS_6(F, X, ...) F(X), _MAP_ARGS_5(F, __VA_ARGS__)
+#define _MAP_ARGS_7(F, X, ...) F(X), _MAP_ARGS_6(F, __VA_ARGS__)
+#define _MAP_ARGS_8(F, X, ...) F(X), _MAP_ARGS_7(F, __VA_ARGS__)
+#define _MAP_ARGS_9(F, X, ...) F(X), _MAP_ARGS_8(F, __VA_ARGS__)
+#define _MAP_ARGS_10(F, X, ...) F(X), _MAP_ARGS_9(F, __VA_ARGS__)
+#define _MAP_ARGS_11(F, X, ...) F(X), _MAP_ARGS_10(F, __VA_ARGS__)
+#define _MAP_ARGS_12(F, X, ...) F(X), _MAP_ARGS_11(F, __VA_ARGS__)
+#define _MAP_ARGS_13(F, X, ...) F(X), _MAP_ARGS_12(F, __VA_ARGS__)
+#define _MAP_ARGS_14(F, X, ...) F(X), _MAP_ARGS_13(F, __VA_ARGS__)
+#define _MAP_ARGS_15(F, X, ...) F(X), _MAP_ARGS_14(F, __VA_ARGS__)
+#define _MAP_ARGS_16(F, X, ...) F(X), _MAP_ARGS_15(F, __VA_ARGS__)
+
+/**
+ * Applies the macro F to each of up to 16 arguments.
+ *
+ * @param[in]	F	The macro to apply. It takes one argument.
+ * @param[in]	...	The arguments to apply F to.
+ *
+ * @return	The results of F, separated by commas.
+ */
+#define MapArgs(F, ...) \
+    _JOIN(_MAP_ARGS_, CountArgs(__VA_ARGS__))(F, __VA_ARGS__)
+
 /*
     END MACRO UTILITY MACROS
 */
@@ -232,71 +335,544 @@ typedef long double	__ontologic_float128;
 */
 
 /*
-    BEGIN VARIADIC FUNCTION MACROS
+    BEGIN FORMAT ARGUMENT MACROS
+*/
+
+/*
+    Format arguments are collected into an array of tagged values at the call
+    site, with _Generic picking the tag from each argument's static type. That
+    keeps the formatting functions independent of the platform's calling
+    convention, and makes passing a type with no format a compile error.
+*/
+
+/* The kinds of value that can be passed as a format argument. */
+typedef enum format_arg_type
+{
+    FORMAT_ARG_SIGNED,
+    FORMAT_ARG_UNSIGNED,
+    FORMAT_ARG_STRING,
+}
+format_arg_type;
+
+/* A single argument to a format function, along with its type. */
+typedef struct format_arg
+{
+    format_arg_type Type;
+    /* The size of the value as it was passed, before it was widened. */
+    u8 Size;
+
+    union
+    {
+        i64 Signed;
+        u64 Unsigned;
+        string String;
+    };
+}
+format_arg;
+
+internal inline format_arg _FormatArgSigned(i64 n, size argSize)
+{
+    return (format_arg){
+        .Type = FORMAT_ARG_SIGNED,
+        .Size = (u8)argSize,
+        .Signed = n,
+    };
+}
+
+internal inline format_arg _FormatArgUnsigned(u64 n, size argSize)
+{
+    return (format_arg){
+        .Type = FORMAT_ARG_UNSIGNED,
+        .Size = (u8)argSize,
+        .Unsigned = n,
+    };
+}
+
+internal inline format_arg _FormatArgString(string s, size argSize)
+{
+    return (format_arg){
+        .Type = FORMAT_ARG_STRING,
+        .Size = (u8)argSize,
+        .String = s,
+    };
+}
+
+internal inline format_arg _FormatArgTerminatedString(
+    const char* s,
+    size argSize
+)
+{
+    size length = 0;
+    while (s[length] != '\0')
+        length++;
+
+    return _FormatArgString(MakeString(s, length), argSize);
+}
+
+/**
+ * Wraps a value as a format_arg, based on its type.
+ *
+ * @param[in]	X	The value to wrap. Either an integer, a string, or a
+ *					'\0'-terminated char*.
+ *
+ * @return	The value as a format_arg.
+ */
+#define FormatArg(X) \
+    _Generic((X), \
+        char: _FormatArgSigned, \
+        signed char: _FormatArgSigned, \
+        short: _FormatArgSigned, \
+        int: _FormatArgSigned, \
+        long: _FormatArgSigned, \
+        long long: _FormatArgSigned, \
+        unsigned char: _FormatArgUnsigned, \
+        unsigned short: _FormatArgUnsigned, \
+        unsigned int: _FormatArgUnsigned, \
+        unsigned long: _FormatArgUnsigned, \
+        unsigned long long: _FormatArgUnsigned, \
+        char*: _FormatArgTerminatedString, \
+        const char*: _FormatArgTerminatedString, \
+        string: _FormatArgString \
+    )((X), sizeof(X))
+
+/**
+ * Wraps each of up to 16 values as a format_arg, for passing to a function
+ * that takes an array of them and its length.
+ *
+ * @param[in]	...	The values to wrap.
+ *
+ * @return	The array of format_args, followed by its length.
+ */
+#define FormatArgs(...) \
+    (format_arg[]){ MapArgs(FormatArg, __VA_ARGS__) }, \
+    CountArgs(__VA_ARGS__)
+
+/*
+    END FORMAT ARGUMENT MACROS
+*/
+
+/*
+    BEGIN ATOMIC MACROS
 */
 
-typedef void* __ontologic_arg_list;
-#define arg_list __ontologic_arg_list
+#if defined(__GNUC__)
 
 /**
- * Initializes an arg_list variable.
+ * Reads the value pointed to by P. No reads or writes that come after the load
+ * can be reordered before it.
+ *
+ * @param[in]	P	A pointer to the value to load.
  *
- * @param[in|out]	l	The arg_list to setup.
- * @param[in]		a	The last argument before the variable argument list.
+ * @return	The value pointed to by P.
  */
-#define SetupArgList(l, a) \
-    l = (void*)((size)(&(a)) + sizeof((a)))
+#define AtomicLoadAcquire(P) __atomic_load_n((P), __ATOMIC_ACQUIRE)
 
 /**
- * The underlying function that pops an argument off the argument list.
- * 
- * @param[in|out]	args	The argument list to pop from.
- * @param[in]		argSize	The size of the argument to pop.
- * 
- * @return	A pointer to the argument that was popped off the argument list.
+ * Writes V to the value pointed to by P. No reads or writes that come before
+ * the store can be reordered after it.
+ *
+ * @param[in|out]	P	A pointer to the value to store to.
+ * @param[in]		V	The value to store.
  */
-internal inline void* _PopArg(arg_list* args, size argSize)
-{
-    void* arg = *args;
-    *args = (void*)((size)*args + (size)argSize);
-    return arg;
-}
+#define AtomicStoreRelease(P, V) __atomic_store_n((P), (V), __ATOMIC_RELEASE)
 
 /**
- * Pops an argument of type T off an argument list.
+ * Replaces the i64 pointed to by P with D, but only if it is currently E. No
+ * reads or writes can be reordered across it.
  *
- * @param[in|out]	l	The argument list to pop from.
- * @param[in]		T	The type of the argument to pop.
+ * @param[in|out]	P	A pointer to the value to replace.
+ * @param[in]		E	The value it is expected to have.
+ * @param[in]		D	The value to replace it with.
  *
- * @return	The value that was popped off the argument list.
+ * @return	True if the value was replaced.
  */
-#define PopArg(l, T) (*(T*)_PopArg(&l, sizeof(T)))
+#define AtomicCompareExchange64(P, E, D) \
+    __sync_bool_compare_and_swap((P), (i64)(E), (i64)(D))
 
 /**
- * Peeks at the next argument in the argument list.
- * 
- * @param[in]	l	The argument list to peek.
- * @param[in]	T	The type of argument to peek.
+ * Adds V to the i64 pointed to by P. No reads or writes can be reordered
+ * across it.
+ *
+ * @param[in|out]	P	A pointer to the value to add to.
+ * @param[in]		V	The amount to add.
  *
- * @return	The value that was popped off the argument list.
+ * @return	The value from before V was added.
  */
-#define PeekArg(l, T) (*(T*)l)
+#define AtomicFetchAdd64(P, V) \
+    __atomic_fetch_add((P), (i64)(V), __ATOMIC_SEQ_CST)
 
 /**
- * Frees the given argument list to prevent it from being used.
+ * Replaces the i64 pointed to by P with V. No reads or writes can be reordered
+ * across it.
  *
- * @param[in|out]	l	The argument list to teardown.
+ * @param[in|out]	P	A pointer to the value to replace.
+ * @param[in]		V	The value to replace it with.
+ *
+ * @return	The value from before it was replaced.
  */
-#define TeardownArgList(l) l = NULL
+#define AtomicExchange64(P, V) \
+    __atomic_exchange_n((P), (i64)(V), __ATOMIC_SEQ_CST)
+
+/**
+ * Keeps every read and write before the fence from being reordered with any
+ * read or write after it, including stores with loads.
+ */
+#define AtomicFence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#if defined(__x86_64__) || defined(__i386__)
+    /* Tells the processor that the thread is spinning, waiting on another. */
+    #define SpinPause() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+    #define SpinPause() __asm__ volatile ("yield")
+#else
+    #define SpinPause() ((void)0)
+#endif
+
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
 
 /*
-    END VARIADIC FUNCTION MACROS
+    On x86 and x64, MSVC gives volatile accesses acquire and release semantics
+    (/volatile:ms, the default for these targets), so values shared between
+    threads only need to be declared volatile.
+*/
+
+/**
+ * Reads the value pointed to by P. No reads or writes that come after the load
+ * can be reordered before it.
+ *
+ * @param[in]	P	A pointer to the (volatile) value to load.
+ *
+ * @return	The value pointed to by P.
+ */
+#define AtomicLoadAcquire(P) (*(P))
+
+/**
+ * Writes V to the value pointed to by P. No reads or writes that come before
+ * the store can be reordered after it.
+ *
+ * @param[in|out]	P	A pointer to the (volatile) value to store to.
+ * @param[in]		V	The value to store.
+ */
+#define AtomicStoreRelease(P, V) (*(P) = (V))
+
+#include <intrin.h>
+
+/**
+ * Replaces the i64 pointed to by P with D, but only if it is currently E. No
+ * reads or writes can be reordered across it.
+ *
+ * @param[in|out]	P	A pointer to the (volatile) value to replace.
+ * @param[in]		E	The value it is expected to have.
+ * @param[in]		D	The value to replace it with.
+ *
+ * @return	True if the value was replaced.
+ */
+#define AtomicCompareExchange64(P, E, D) \
+    (_InterlockedCompareExchange64((P), (i64)(D), (i64)(E)) == (i64)(E))
+
+/**
+ * Adds V to the i64 pointed to by P. No reads or writes can be reordered
+ * across it.
+ *
+ * @param[in|out]	P	A pointer to the (volatile) value to add to.
+ * @param[in]		V	The amount to add.
+ *
+ * @return	The value from before V was added.
+ */
+#if defined(_M_X64)
+    #define AtomicFetchAdd64(P, V) _InterlockedExchangeAdd64((P), (i64)(V))
+#else
+    /* 32-bit x86 has no 64-bit add, so it is retried as a compare-exchange. */
+    internal inline i64 _AtomicFetchAdd64(volatile i64* p, i64 v)
+    {
+        i64 old;
+        do
+            old = *p;
+        while (_InterlockedCompareExchange64(p, old + v, old) != old);
+
+        return old;
+    }
+
+    #define AtomicFetchAdd64(P, V) _AtomicFetchAdd64((P), (i64)(V))
+#endif
+
+/**
+ * Replaces the i64 pointed to by P with V. No reads or writes can be reordered
+ * across it.
+ *
+ * @param[in|out]	P	A pointer to the (volatile) value to replace.
+ * @param[in]		V	The value to replace it with.
+ *
+ * @return	The value from before it was replaced.
+ */
+#if defined(_M_X64)
+    #define AtomicExchange64(P, V) _InterlockedExchange64((P), (i64)(V))
+#else
+    /* 32-bit x86 has no 64-bit exchange, so it is a compare-exchange too. */
+    internal inline i64 _AtomicExchange64(volatile i64* p, i64 v)
+    {
+        i64 old;
+        do
+            old = *p;
+        while (_InterlockedCompareExchange64(p, v, old) != old);
+
+        return old;
+    }
+
+    #define AtomicExchange64(P, V) _AtomicExchange64((P), (i64)(V))
+#endif
+
+/**
+ * Keeps every read and write before the fence from being reordered with any
+ * read or write after it, including stores with loads.
+ */
+#define AtomicFence() _mm_mfence()
+
+/* Tells the processor that the thread is spinning, waiting on another. */
+#define SpinPause() _mm_pause()
+
+#else
+    #error Unable to define atomic macros!
+#endif
+
+/**
+ * The size of a cache line, used to keep values written by different threads
+ * from sharing one.
+ */
+#define CACHE_LINE_SIZE 64
+
+/*
+    END ATOMIC MACROS
 */
 
 /*
     BEGIN STANDARD PROCEDURES
 */
 
+/*
+    Every pair of decimal digits from 00 to 99, so that two digits can be
+    written per division instead of one.
+*/
+global const char DecimalDigitPairs[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* The digits used when writing numbers in hexadecimal. */
+global const char HexadecimalDigits[16] = "0123456789abcdef";
+
+/**
+ * Counts the number of decimal digits needed to write n.
+ *
+ * @param[in]	n	The number to count the digits of.
+ *
+ * @return	The number of digits in n. Zero has one digit.
+ */
+internal inline size CountDecimalDigits(u64 n)
+{
+    /* Four digits are ruled out per division, rather than one. */
+    size digits = 1;
+    forever
+    {
+        if (n < 10) return digits;
+        if (n < 100) return digits + 1;
+        if (n < 1000) return digits + 2;
+        if (n < 10000) return digits + 3;
+
+        n /= 10000;
+        digits += 4;
+    }
+}
+
+/**
+ * Counts the number of hexadecimal digits needed to write n.
+ *
+ * @param[in]	n	The number to count the digits of.
+ *
+ * @return	The number of digits in n. Zero has one digit.
+ */
+internal inline size CountHexadecimalDigits(u64 n)
+{
+    size digits = 1;
+    while (n >>= 4)
+        digits++;
+
+    return digits;
+}
+
+/**
+ * Writes the digits of n into exactly digitCount characters, which must be
+ * enough to hold them. Not intended to be used on its own.
+ *
+ * @param[in|out]	digits		Where to write the digits.
+ * @param[in]		digitCount	The number of digits in n, in the given base.
+ * @param[in]		n			The number to write.
+ * @param[in]		base		Either 10 or 16.
+ */
+internal inline void _WriteDigits(
+    char* digits,
+    size digitCount,
+    u64 n,
+    u32 base
+)
+{
+    /* The digit count is known up front, so the digits are placed directly. */
+    size i = digitCount;
+
+    if (base == 16)
+    {
+        while (0 < i)
+        {
+            digits[--i] = HexadecimalDigits[n & 0xf];
+            n >>= 4;
+        }
+
+        return;
+    }
+
+    while (100 <= n)
+    {
+        size pair = (n % 100) * 2;
+        n /= 100;
+
+        digits[--i] = DecimalDigitPairs[pair + 1];
+        digits[--i] = DecimalDigitPairs[pair];
+    }
+
+    if (10 <= n)
+    {
+        digits[--i] = DecimalDigitPairs[n * 2 + 1];
+        digits[--i] = DecimalDigitPairs[n * 2];
+    }
+
+    else
+        digits[--i] = (char)('0' + n);
+}
+
+/**
+ * The underlying function used for converting integers to strings. Not
+ * intended to be used on its own.
+ *
+ * Numbers shorter than the given width are padded on the left. When padding
+ * with '0' the sign comes before the padding, otherwise it comes after it. If
+ * the buffer is too small, only the leading characters that fit are written.
+ *
+ * @param[in|out]	buffer		The buffer to write the number to.
+ * @param[in]		bufferSize	The size of the buffer.
+ * @param[in]		magnitude	The absolute value of the number.
+ * @param[in]		isNegative	Whether the number is negative.
+ * @param[in]		base		Either 10 or 16.
+ * @param[in]		width		The minimum number of characters to write.
+ * @param[in]		padding		The character to pad with, up to the width.
+ *
+ * @return	The number of characters written to the buffer.
+ */
+internal size _FormatInteger(
+    char* buffer,
+    size bufferSize,
+    u64 magnitude,
+    bool isNegative,
+    u32 base,
+    size width,
+    char padding
+)
+{
+    size digitCount = base == 16
+        ? CountHexadecimalDigits(magnitude)
+        : CountDecimalDigits(magnitude);
+
+    size length = digitCount + isNegative;
+    size paddingCount = length < width ? width - length : 0;
+    length += paddingCount;
+
+    /* The longest a u64 can be, with a sign: "-18446744073709551615". */
+    char overflow[21];
+
+    char* digits;
+    if (length <= bufferSize)
+        digits = buffer + length - digitCount;
+
+    else
+        digits = overflow;
+
+    _WriteDigits(digits, digitCount, magnitude, base);
+
+    size charsWritten = 0;
+
+    if (isNegative && padding == '0' && charsWritten < bufferSize)
+        buffer[charsWritten++] = '-';
+
+    for (size i = 0; i < paddingCount && charsWritten < bufferSize; i++)
+        buffer[charsWritten++] = padding;
+
+    if (isNegative && padding != '0' && charsWritten < bufferSize)
+        buffer[charsWritten++] = '-';
+
+    if (digits == overflow)
+    {
+        for (size i = 0; i < digitCount && charsWritten < bufferSize; i++)
+            buffer[charsWritten++] = overflow[i];
+    }
+
+    else
+        charsWritten += digitCount;
+
+    return charsWritten;
+}
+
+/**
+ * Converts an unsigned integer to a string stored in the given buffer.
+ *
+ * @param[in|out]	buffer		The buffer to fill with the integer as string.
+ * @param[in]		bufferSize	The size of the string buffer.
+ * @param[in]		n			The number to convert to string.
+ *
+ * @return	The number of characters written to the buffer.
+ */
+internal inline size U64toA(char* buffer, size bufferSize, u64 n)
+{
+    return _FormatInteger(buffer, bufferSize, n, false, 10, 0, ' ');
+}
+
+/**
+ * Converts a signed integer to a string stored in the given buffer.
+ *
+ * @param[in|out]	buffer		The buffer to fill with the integer as string.
+ * @param[in]		bufferSize	The size of the string buffer.
+ * @param[in]		n			The number to convert to string.
+ *
+ * @return	The number of characters written to the buffer.
+ */
+internal inline size I64toA(char* buffer, size bufferSize, i64 n)
+{
+    /* Negating in unsigned arithmetic keeps the most negative value intact. */
+    u64 magnitude = n < 0 ? 0 - (u64)n : (u64)n;
+
+    return _FormatInteger(buffer, bufferSize, magnitude, n < 0, 10, 0, ' ');
+}
+
+/**
+ * Converts an unsigned integer to a lowercase hexadecimal string stored in the
+ * given buffer.
+ *
+ * @param[in|out]	buffer		The buffer to fill with the integer as string.
+ * @param[in]		bufferSize	The size of the string buffer.
+ * @param[in]		n			The number to convert to string.
+ *
+ * @return	The number of characters written to the buffer.
+ */
+internal inline size U64toHex(char* buffer, size bufferSize, u64 n)
+{
+    return _FormatInteger(buffer, bufferSize, n, false, 16, 0, ' ');
+}
+
 /**
  * Converts an integer to a string stored in the given buffer.
  *
@@ -306,157 +882,592 @@ internal inline void* _PopArg(arg_list* args, size argSize)
  *
  * @return	The number of characters written to the buffer.
  */
-internal size ItoA(char* buffer, size bufferSize, i32 n)
+internal inline size ItoA(char* buffer, size bufferSize, i32 n)
+{
+    return I64toA(buffer, bufferSize, n);
+}
+
+/* The most specifiers a format_descriptor can hold. */
+#define FORMAT_MAX_SEGMENTS 32
+
+/* A run of literal text in a format string, and the specifier that ends it. */
+typedef struct format_segment
+{
+    u32 LiteralStart;
+    u32 LiteralLength;
+
+    /* The specifier's character, or '\0' if the segment takes no argument. */
+    char Specifier;
+    /* The character to pad with, up to the width. */
+    char Padding;
+    /* The minimum number of characters the argument is written as. */
+    u8 Width;
+}
+format_segment;
+
+/**
+ * A format string split into its segments ahead of time, so that formatting
+ * with it does not have to parse it again.
+ */
+typedef struct format_descriptor
 {
-    if (bufferSize == 0) return 0;
-    if (n == 0)
+    const char* Format;
+
+    format_segment Segments[FORMAT_MAX_SEGMENTS];
+    size SegmentCount;
+
+    /* The number of arguments the format string takes. */
+    size ArgCount;
+}
+format_descriptor;
+
+/**
+ * Splits a format string into segments of literal text, each ended by a
+ * specifier.
+ *
+ * The specifiers are %i and %u (decimal), %x (hexadecimal), %c (a character)
+ * and %s (a string). A width can be given, as in %8u, and is padded with
+ * spaces, or with zeroes if the width starts with 0, as in %08x. An l before
+ * the specifier, as in %li, is accepted and ignored, since the size of each
+ * argument is known from its type. %% is a single '%', and anything else
+ * following a '%' is kept as literal text.
+ *
+ * Specifiers past FORMAT_MAX_SEGMENTS are kept as literal text.
+ *
+ * @param[out]	descriptor	The descriptor to fill.
+ * @param[in]	format		The format string. It must outlive the descriptor.
+ * @param[in]	formatSize	The size of the format string.
+ */
+internal void ParseFormat(
+    format_descriptor* descriptor,
+    const char* format,
+    size formatSize
+)
+{
+    descriptor->Format = format;
+    descriptor->SegmentCount = 0;
+    descriptor->ArgCount = 0;
+
+    size literalStart = 0;
+    size i = 0;
+    while (i < formatSize)
     {
-        buffer[0] = '0';
-        return 1;
+        if (format[i] != '%' || formatSize <= i + 1
+            || descriptor->SegmentCount == FORMAT_MAX_SEGMENTS - 1)
+        {
+            i++;
+            continue;
+        }
+
+        format_segment* segment =
+            &descriptor->Segments[descriptor->SegmentCount];
+
+        segment->LiteralStart = (u32)literalStart;
+        segment->LiteralLength = (u32)(i - literalStart);
+
+        if (format[i + 1] == '%')
+        {
+            /* Keep the first '%' as literal text, and skip the second. */
+            segment->LiteralLength++;
+            segment->Specifier = '\0';
+
+            descriptor->SegmentCount++;
+
+            i += 2;
+            literalStart = i;
+            continue;
+        }
+
+        size j = i + 1;
+
+        char padding = ' ';
+        if (format[j] == '0')
+        {
+            padding = '0';
+            j++;
+        }
+
+        size width = 0;
+        while (j < formatSize && '0' <= format[j] && format[j] <= '9')
+            width = width * 10 + (format[j++] - '0');
+
+        if (j < formatSize && format[j] == 'l')
+            j++;
+
+        char specifier = j < formatSize ? format[j] : '\0';
+
+        switch (specifier)
+        {
+        case 'c':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 's':
+        {
+            segment->Specifier = specifier;
+            segment->Padding = padding;
+            segment->Width = (u8)(width < 255 ? width : 255);
+
+            descriptor->SegmentCount++;
+            descriptor->ArgCount++;
+
+            i = j + 1;
+            literalStart = i;
+        } break;
+
+        default:
+        {
+            /* Not a specifier, so it stays part of the literal text. */
+            i++;
+        } break;
+        }
     }
 
-    unsigned int isNegative = n < 0;
-    n = Abs(n);
+    format_segment* last = &descriptor->Segments[descriptor->SegmentCount++];
+    last->LiteralStart = (u32)literalStart;
+    last->LiteralLength = (u32)(formatSize - literalStart);
+    last->Specifier = '\0';
+}
 
-    size i = 0;
-    while (n != 0 && i < bufferSize)
+/**
+ * Writes a single argument to the buffer, as described by the given segment.
+ * Not intended to be used on its own.
+ *
+ * @param[in|out]	buffer		The buffer to write the argument to.
+ * @param[in]		bufferSize	The size of the buffer.
+ * @param[in]		segment		The segment whose specifier is being written.
+ * @param[in]		arg			The argument to write.
+ *
+ * @return	The number of characters written to the buffer.
+ */
+internal size _FormatArg(
+    char* buffer,
+    size bufferSize,
+    const format_segment* segment,
+    const format_arg* arg
+)
+{
+    if (bufferSize == 0)
+        return 0;
+
+    if (arg->Type == FORMAT_ARG_STRING)
     {
-        buffer[i++] = (char)((n % 10) + 48);
-        n /= 10;
+        size charsWritten = 0;
+        while (charsWritten < arg->String.Length && charsWritten < bufferSize)
+        {
+            buffer[charsWritten] = arg->String.Data[charsWritten];
+            charsWritten++;
+        }
+
+        return charsWritten;
     }
 
-    buffer[i] = isNegative * '-';
-    i += isNegative;
+    bool isNegative = arg->Type == FORMAT_ARG_SIGNED && arg->Signed < 0;
 
-    size charsWritten = i;
+    switch (segment->Specifier)
+    {
+    case 'c':
+    {
+        buffer[0] = (char)arg->Unsigned;
+        return 1;
+    }
 
-    size start = 0, end = --i;
-    while (start < end)
+    case 'x':
     {
-        Swap(char, buffer[start], buffer[end]);
-        start++; end--;
+        /* Negative values were sign extended, so only their own bits show. */
+        u64 value = arg->Unsigned;
+        if (isNegative && arg->Size < sizeof(u64))
+            value &= ((u64)1 << (arg->Size * 8)) - 1;
+
+        return _FormatInteger(
+            buffer, bufferSize,
+            value, false,
+            16, segment->Width, segment->Padding
+        );
     }
 
-    return charsWritten;
+    default:
+    {
+        /* Negating in unsigned arithmetic keeps the most negative value. */
+        return _FormatInteger(
+            buffer, bufferSize,
+            isNegative ? 0 - arg->Unsigned : arg->Unsigned, isNegative,
+            10, segment->Width, segment->Padding
+        );
+    }
+    }
 }
 
 /**
- * The underlying function used for formatting strings. Not intended to be used
- * on its own.
+ * Fills the given buffer with a parsed format string spliced with the given
+ * arguments. Specifiers without a matching argument are left out.
  *
- * @param[in|out]	buffer		The buffer to write the formatted text to.
+ * @param[in|out]	buffer		The buffer to fill.
  * @param[in]		bufferSize	The size of the buffer.
- * @param[in]		format		The format string.
- * @param[in]		formatSize	The size of the format string.
+ * @param[in]		descriptor	The parsed format string.
  * @param[in]		args		The args to splice into the format string.
+ * @param[in]		argCount	The number of args.
  *
  * @return	The number of characters written to the buffer.
  */
-internal size _FormatString(
+internal size _FormatParsed(
     char* buffer,
     size bufferSize,
-    const char* format,
-    size formatSize,
-    arg_list args
+    const format_descriptor* descriptor,
+    const format_arg* args,
+    size argCount
 )
 {
     size charsWritten = 0;
-    for (size i = 0; i < formatSize; i++)
+    size argIndex = 0;
+
+    for (size i = 0; i < descriptor->SegmentCount; i++)
     {
-        if (bufferSize <= charsWritten)
-            break;
+        const format_segment* segment = &descriptor->Segments[i];
+        const char* literal = &descriptor->Format[segment->LiteralStart];
 
-        char c = format[i];
+        for (
+            size j = 0;
+            j < segment->LiteralLength && charsWritten < bufferSize;
+            j++
+        )
+            buffer[charsWritten++] = literal[j];
 
-        if (c != '%' || formatSize <= i + 1)
+        if (segment->Specifier != '\0' && argIndex < argCount)
         {
-            buffer[charsWritten++] = c;
+            charsWritten += _FormatArg(
+                &buffer[charsWritten], bufferSize - charsWritten,
+                segment,
+                &args[argIndex++]
+            );
         }
+    }
 
-        else
-        {
-            switch (format[i+1])
-            {
-            case 'c':
-            {
-                buffer[charsWritten] = PopArg(args, char);
-                charsWritten++;
-            } break;
-
-            case 'i':
-            {
-                charsWritten += ItoA(
-                    (char*)((size)buffer + charsWritten),
-                    bufferSize - charsWritten,
-                    PopArg(args, int)
-                );
-            } break;
-
-            case 's':
-            {
-                char* s = PopArg(args, char*);
-                size sLength = PopArg(args, size);
-
-                for (size j = 0; j < sLength; j++)
-                {
-                    if (charsWritten < bufferSize)
-                        buffer[charsWritten++] = s[j];
-
-                    else break;
-                }
-            } break;
-
-            default:
-            {
-                buffer[i] = c;
-            } break;
-            }
+    return charsWritten;
+}
 
-            i++;
-        }
+/**
+ * Finds the most characters _FormatParsed can write for a parsed format string
+ * and its arguments, so that a buffer can be sized to never cut it short.
+ *
+ * @param[in]	descriptor	The parsed format string.
+ * @param[in]	args		The args to splice into the format string.
+ * @param[in]	argCount	The number of args.
+ *
+ * @return	The most characters the formatted text can take up.
+ */
+internal size FormattedLengthBound(
+    const format_descriptor* descriptor,
+    const format_arg* args,
+    size argCount
+)
+{
+    size bound = 0;
+    size argIndex = 0;
+
+    for (size i = 0; i < descriptor->SegmentCount; i++)
+    {
+        const format_segment* segment = &descriptor->Segments[i];
+        bound += segment->LiteralLength;
+
+        if (segment->Specifier == '\0' || argCount <= argIndex)
+            continue;
+
+        const format_arg* arg = &args[argIndex++];
+
+        if (arg->Type == FORMAT_ARG_STRING)
+            bound += arg->String.Length;
+
+        else if (segment->Specifier == 'c')
+            bound += 1;
+
+        /* The longest a u64 can be, with a sign, or the width if it's wider. */
+        else
+            bound += segment->Width < 21 ? 21 : segment->Width;
     }
 
-    return charsWritten;
+    return bound;
 }
 
 /**
- * Fills the given buffer with the contents of the format string spliced with
- * arguments in the argument list, if applicable.
+ * The underlying function used for formatting strings. Not intended to be used
+ * on its own.
  *
- * @param[in|out]	buffer		The buffer to fill.
+ * @param[in|out]	buffer		The buffer to write the formatted text to.
  * @param[in]		bufferSize	The size of the buffer.
- * @param[in]		format		The format string to use.
+ * @param[in]		format		The format string.
  * @param[in]		formatSize	The size of the format string.
- * @param[in]		...			The args to splice into the format string.
+ * @param[in]		args		The args to splice into the format string.
+ * @param[in]		argCount	The number of args.
  *
  * @return	The number of characters written to the buffer.
  */
-internal size FormatString(
+internal inline size _FormatString(
     char* buffer,
     size bufferSize,
     const char* format,
     size formatSize,
-    ...
+    const format_arg* args,
+    size argCount
 )
 {
-    arg_list args;
-    SetupArgList(args, formatSize);
-    
-    size charsWritten = _FormatString(
-        buffer,
-        bufferSize,
-        format,
-        formatSize,
-        args
-    );
-
-    TeardownArgList(args);
+    format_descriptor descriptor;
+    ParseFormat(&descriptor, format, formatSize);
 
-    return charsWritten;
+    return _FormatParsed(buffer, bufferSize, &descriptor, args, argCount);
 }
 
+/**
+ * Fills the given buffer with the contents of the format string spliced with
+ * the given arguments. See ParseFormat for the specifiers.
+ *
+ * @param[in|out]	B	The buffer to fill.
+ * @param[in]		N	The size of the buffer.
+ * @param[in]		F	The format string to use.
+ * @param[in]		L	The size of the format string.
+ * @param[in]		...	The args to splice into the format string. At least
+ *						one, and at most 16.
+ *
+ * @return	The number of characters written to the buffer.
+ */
+#define FormatString(B, N, F, L, ...) \
+    _FormatString((B), (N), (F), (L), FormatArgs(__VA_ARGS__))
+
+/**
+ * Fills the given buffer with the contents of a format string parsed ahead of
+ * time by ParseFormat, spliced with the given arguments.
+ *
+ * @param[in|out]	B	The buffer to fill.
+ * @param[in]		N	The size of the buffer.
+ * @param[in]		D	A pointer to the parsed format string.
+ * @param[in]		...	The args to splice into the format string. At least
+ *						one, and at most 16.
+ *
+ * @return	The number of characters written to the buffer.
+ */
+#define FormatParsed(B, N, D, ...) \
+    _FormatParsed((B), (N), (D), FormatArgs(__VA_ARGS__))
+
 /*
     END STANDARD PROCEDURES
 */
 
+/*
+    BEGIN MEMORY PROCEDURES
+*/
+
+/*
+    We don't link a C runtime, so there is no memset or memcpy. These take
+    the widest vectors the compiler is told it can assume, chosen at compile
+    time since they are called too often, on too little memory, to go through
+    a check at runtime. SSE2 is part of x86-64 and NEON of AArch64, so those
+    are always there; AVX2 is only used when the build targets it.
+*/
+#if defined(__AVX2__)
+    #define STANDARD_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+    #define STANDARD_SSE2
+
+    #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define STANDARD_NEON
+
+    #include <arm_neon.h>
+#endif
+
+/**
+ * Copies bytes from one buffer to another. The buffers must not overlap.
+ *
+ * @param[out]	destination	The buffer to copy to.
+ * @param[in]	source		The buffer to copy from.
+ * @param[in]	count		The number of bytes to copy.
+ */
+internal inline void MemoryCopy(
+    void* destination,
+    const void* source,
+    size count
+)
+{
+    u8* to = (u8*)destination;
+    const u8* from = (const u8*)source;
+    size i = 0;
+
+#if defined(STANDARD_AVX2)
+    for (; i + 32 <= count; i += 32)
+        _mm256_storeu_si256(
+            (__m256i*)&to[i], _mm256_loadu_si256((const __m256i*)&from[i])
+        );
+#endif
+
+#if defined(STANDARD_SSE2)
+    for (; i + 16 <= count; i += 16)
+        _mm_storeu_si128(
+            (__m128i*)&to[i], _mm_loadu_si128((const __m128i*)&from[i])
+        );
+#elif defined(STANDARD_NEON)
+    for (; i + 16 <= count; i += 16)
+        vst1q_u8(&to[i], vld1q_u8(&from[i]));
+#endif
+
+    for (; i < count; i++)
+        to[i] = from[i];
+}
+
+/**
+ * Sets every byte of a buffer to the same value.
+ *
+ * @param[out]	destination	The buffer to fill.
+ * @param[in]	value		The value to set each byte to.
+ * @param[in]	count		The number of bytes to fill.
+ */
+internal inline void MemoryFill(void* destination, u8 value, size count)
+{
+    u8* to = (u8*)destination;
+    size i = 0;
+
+#if defined(STANDARD_AVX2)
+    __m256i wideValues = _mm256_set1_epi8((char)value);
+    for (; i + 32 <= count; i += 32)
+        _mm256_storeu_si256((__m256i*)&to[i], wideValues);
+#endif
+
+#if defined(STANDARD_SSE2)
+    __m128i values = _mm_set1_epi8((char)value);
+    for (; i + 16 <= count; i += 16)
+        _mm_storeu_si128((__m128i*)&to[i], values);
+#elif defined(STANDARD_NEON)
+    uint8x16_t values = vdupq_n_u8(value);
+    for (; i + 16 <= count; i += 16)
+        vst1q_u8(&to[i], values);
+#endif
+
+    for (; i < count; i++)
+        to[i] = value;
+}
+
+/**
+ * Sets every element of an array of u32 to the same value.
+ *
+ * @param[out]	destination	The array to fill.
+ * @param[in]	value		The value to set each element to.
+ * @param[in]	count		The number of elements to fill.
+ */
+internal inline void MemoryFill32(u32* destination, u32 value, size count)
+{
+    size i = 0;
+
+#if defined(STANDARD_AVX2)
+    __m256i wideValues = _mm256_set1_epi32((i32)value);
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_si256((__m256i*)&destination[i], wideValues);
+#endif
+
+#if defined(STANDARD_SSE2)
+    __m128i values = _mm_set1_epi32((i32)value);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128((__m128i*)&destination[i], values);
+#elif defined(STANDARD_NEON)
+    uint32x4_t values = vdupq_n_u32(value);
+    for (; i + 4 <= count; i += 4)
+        vst1q_u32(&destination[i], values);
+#endif
+
+    for (; i < count; i++)
+        destination[i] = value;
+}
+
+/**
+ * Copies bytes into an array of u32, widening each one.
+ *
+ * @param[out]	destination	The array to copy to.
+ * @param[in]	source		The bytes to copy.
+ * @param[in]	count		The number of bytes to copy.
+ */
+internal inline void MemoryWidenBytes(
+    u32* destination,
+    const u8* source,
+    size count
+)
+{
+    size i = 0;
+
+#if defined(STANDARD_AVX2)
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_si256(
+            (__m256i*)&destination[i],
+            _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&source[i]))
+        );
+#endif
+
+#if defined(STANDARD_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)&source[i]);
+        __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        __m128i high = _mm_unpackhi_epi8(bytes, zero);
+
+        __m128i* to = (__m128i*)&destination[i];
+        _mm_storeu_si128(&to[0], _mm_unpacklo_epi16(low, zero));
+        _mm_storeu_si128(&to[1], _mm_unpackhi_epi16(low, zero));
+        _mm_storeu_si128(&to[2], _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128(&to[3], _mm_unpackhi_epi16(high, zero));
+    }
+#elif defined(STANDARD_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t halves = vmovl_u8(vld1_u8(&source[i]));
+        vst1q_u32(&destination[i], vmovl_u16(vget_low_u16(halves)));
+        vst1q_u32(&destination[i + 4], vmovl_u16(vget_high_u16(halves)));
+    }
+#endif
+
+    for (; i < count; i++)
+        destination[i] = source[i];
+}
+
+/**
+ * Checks whether every byte of a buffer is zero.
+ *
+ * @param[in]	source	The buffer to check.
+ * @param[in]	count	The number of bytes to check.
+ *
+ * @return	True if every byte is zero.
+ */
+internal inline bool MemoryIsZero(const void* source, size count)
+{
+    const u8* from = (const u8*)source;
+    size i = 0;
+
+#if defined(STANDARD_SSE2)
+    __m128i bits = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16)
+        bits = _mm_or_si128(bits, _mm_loadu_si128((const __m128i*)&from[i]));
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(bits, _mm_setzero_si128())) != 0xFFFF)
+        return false;
+#elif defined(STANDARD_NEON)
+    uint8x16_t bits = vdupq_n_u8(0);
+    for (; i + 16 <= count; i += 16)
+        bits = vorrq_u8(bits, vld1q_u8(&from[i]));
+
+    uint64x2_t words = vreinterpretq_u64_u8(bits);
+    if ((vgetq_lane_u64(words, 0) | vgetq_lane_u64(words, 1)) != 0)
+        return false;
+#endif
+
+    u8 bits8 = 0;
+    for (; i < count; i++)
+        bits8 |= from[i];
+
+    return bits8 == 0;
+}
+
+/*
+    END MEMORY PROCEDURES
+*/
+
 #endif
\ No newline at end of file
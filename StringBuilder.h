@@ -0,0 +1,201 @@
+#ifndef __ONTOLOGIC_STRING_BUILDER_H__
+#define __ONTOLOGIC_STRING_BUILDER_H__
+
+#include "Standard.h"
+#include "Platform.h"
+
+/*
+    BEGIN STRING BUILDER
+*/
+
+/**
+ * Builds a string out of pieces appended straight into arena memory. While
+ * the text is the last thing allocated from the arena it grows in place;
+ * otherwise it is moved to a new allocation twice the size.
+ */
+typedef struct string_builder
+{
+    /* The arena the text is allocated from. */
+    memory_arena* Arena;
+    allocation_tag Tag;
+
+    char* Data;
+    size Length;
+    size Capacity;
+}
+string_builder;
+
+/**
+ * Initializes an empty string_builder.
+ *
+ * @param[in|out]	builder		The builder to setup.
+ * @param[in|out]	arena		The arena to allocate the text from.
+ * @param[in]		capacity	How many bytes to allocate up front.
+ * @param[in]		tag			The tag to attribute the text to.
+ */
+internal void SetupStringBuilder(
+    string_builder* builder,
+    memory_arena* arena,
+    size capacity,
+    allocation_tag tag
+)
+{
+    *builder = (struct string_builder){
+        .Arena = arena,
+        .Tag = tag,
+
+        .Data = PushSizeTagged(arena, capacity, 1, tag),
+        .Length = 0,
+        .Capacity = capacity,
+    };
+}
+
+/**
+ * Makes room for at least the given number of bytes past the end of the text.
+ *
+ * @param[in|out]	builder		The builder to make room in.
+ * @param[in]		extraSize	The number of bytes to make room for.
+ *
+ * @return	Where the next byte of the text goes.
+ */
+internal char* StringBuilderReserve(string_builder* builder, size extraSize)
+{
+    if (extraSize <= builder->Capacity - builder->Length)
+        return &builder->Data[builder->Length];
+
+    size requiredSize = builder->Length + extraSize;
+    size newCapacity = builder->Capacity < 16 ? 16 : 2 * builder->Capacity;
+    if (newCapacity < requiredSize)
+        newCapacity = requiredSize;
+
+    memory_arena* arena = builder->Arena;
+
+    if (builder->Data + builder->Capacity == (char*)arena->Cursor)
+    {
+        /* Nothing has been allocated since, so the text can just grow. */
+        PushSizeTagged(
+            arena, newCapacity - builder->Capacity, 1, builder->Tag
+        );
+    }
+
+    else
+    {
+        char* data = PushSizeTagged(arena, newCapacity, 1, builder->Tag);
+        MemoryCopy(data, builder->Data, builder->Length);
+
+        builder->Data = data;
+    }
+
+    builder->Capacity = newCapacity;
+
+    return &builder->Data[builder->Length];
+}
+
+/**
+ * Appends the given text to the end of the string being built.
+ *
+ * @param[in|out]	builder		The builder to append to.
+ * @param[in]		text		The text to append.
+ * @param[in]		textLength	The length of the text.
+ */
+internal void StringBuilderAppend(
+    string_builder* builder,
+    const char* text,
+    size textLength
+)
+{
+    char* end = StringBuilderReserve(builder, textLength);
+    MemoryCopy(end, text, textLength);
+
+    builder->Length += textLength;
+}
+
+/**
+ * Appends a parsed format string spliced with the given arguments to the end
+ * of the string being built.
+ *
+ * @param[in|out]	builder		The builder to append to.
+ * @param[in]		descriptor	The parsed format string.
+ * @param[in]		args		The args to splice into the format string.
+ * @param[in]		argCount	The number of args.
+ */
+internal void _StringBuilderAppendParsed(
+    string_builder* builder,
+    const format_descriptor* descriptor,
+    const format_arg* args,
+    size argCount
+)
+{
+    /* Room is made for the longest it can be, so nothing is ever cut short. */
+    size bound = FormattedLengthBound(descriptor, args, argCount);
+    char* end = StringBuilderReserve(builder, bound);
+
+    builder->Length += _FormatParsed(end, bound, descriptor, args, argCount);
+}
+
+/**
+ * The underlying function used for appending formatted text. Not intended to
+ * be used on its own.
+ *
+ * @param[in|out]	builder		The builder to append to.
+ * @param[in]		format		The format string.
+ * @param[in]		formatSize	The size of the format string.
+ * @param[in]		args		The args to splice into the format string.
+ * @param[in]		argCount	The number of args.
+ */
+internal void _StringBuilderAppendF(
+    string_builder* builder,
+    const char* format,
+    size formatSize,
+    const format_arg* args,
+    size argCount
+)
+{
+    format_descriptor descriptor;
+    ParseFormat(&descriptor, format, formatSize);
+
+    _StringBuilderAppendParsed(builder, &descriptor, args, argCount);
+}
+
+/**
+ * Appends the contents of the format string spliced with the given arguments
+ * to the end of the string being built. See ParseFormat for the specifiers.
+ *
+ * @param[in|out]	B	The builder to append to.
+ * @param[in]		F	The format string to use.
+ * @param[in]		L	The size of the format string.
+ * @param[in]		...	The args to splice into the format string. At least
+ *						one, and at most 16.
+ */
+#define StringBuilderAppendF(B, F, L, ...) \
+    _StringBuilderAppendF((B), (F), (L), FormatArgs(__VA_ARGS__))
+
+/**
+ * Appends the contents of a format string parsed ahead of time by ParseFormat,
+ * spliced with the given arguments, to the end of the string being built.
+ *
+ * @param[in|out]	B	The builder to append to.
+ * @param[in]		D	A pointer to the parsed format string.
+ * @param[in]		...	The args to splice into the format string. At least
+ *						one, and at most 16.
+ */
+#define StringBuilderAppendParsed(B, D, ...) \
+    _StringBuilderAppendParsed((B), (D), FormatArgs(__VA_ARGS__))
+
+/**
+ * Gets the string built so far. It stays valid until more is appended.
+ *
+ * @param[in]	builder	The builder to get the string of.
+ *
+ * @return	The string built so far.
+ */
+internal inline string StringBuilderToString(const string_builder* builder)
+{
+    return MakeString(builder->Data, builder->Length);
+}
+
+/*
+    END STRING BUILDER
+*/
+
+#endif
@@ -0,0 +1,500 @@
+#ifndef __ONTOLOGIC_UNDO_JOURNAL_H__
+#define __ONTOLOGIC_UNDO_JOURNAL_H__
+
+#include "Standard.h"
+#include "Platform.h"
+
+/*
+    BEGIN UNDO JOURNAL
+*/
+
+/* Consecutive edits stop being merged into one record past this many bytes. */
+#define UNDO_COALESCE_LIMIT 1024
+
+typedef enum undo_edit_kind
+{
+    UNDO_EDIT_INSERT,
+    UNDO_EDIT_DELETE,
+}
+undo_edit_kind;
+
+/* An edit, as it was made. */
+typedef struct undo_edit
+{
+    undo_edit_kind Kind;
+
+    /* Where the text was inserted, or where it was deleted from. */
+    size Position;
+
+    /* The text that was inserted or deleted. */
+    const char* Text;
+    size Length;
+}
+undo_edit;
+
+/*
+    Every edit is stored as a record: this header, the edit's text padded to
+    the size of a length, and the length of the text again. The length at the
+    end lets the records be walked backward as easily as forward.
+*/
+typedef struct undo_record
+{
+    u32 Kind;
+    u32 Position;
+    u32 Length;
+}
+undo_record;
+
+/**
+ * Records the edits made to a piece of text in a ring of bytes, so that they
+ * can be undone and redone. Records before the cursor can be undone, and
+ * records after it can be redone until a new edit is made. Once the ring is
+ * full, the oldest records are dropped to make room for new ones.
+ */
+typedef struct undo_journal
+{
+    u8* Buffer;
+    size Capacity;
+
+    /* The offset of the oldest record. */
+    size Start;
+    /* The offset just past the newest record. */
+    size End;
+    /* The offset just past the newest record that can be undone. */
+    size Cursor;
+
+    /*
+        Set once new records have wrapped around to the start of the buffer,
+        while older records are still in use at its end. Those older records
+        end at Limit.
+    */
+    bool Wrapped;
+    size Limit;
+
+    size RecordCount;
+    /* The number of records before the cursor. */
+    size UndoCount;
+
+    /* Set when the next edit has to start a new record. */
+    bool Sealed;
+}
+undo_journal;
+
+/**
+ * Initializes an empty undo journal.
+ *
+ * @param[in|out]	journal		The journal to setup.
+ * @param[in|out]	arena		The arena to allocate the ring from.
+ * @param[in]		capacity	The size of the ring, in bytes.
+ */
+internal void SetupUndoJournal(
+    undo_journal* journal,
+    memory_arena* arena,
+    size capacity
+)
+{
+    /* Records are padded to the size of a length, and so is the ring. */
+    capacity &= ~(sizeof(u32) - 1);
+    Assert(sizeof(undo_record) + 2 * sizeof(u32) <= capacity);
+
+    *journal = (undo_journal){
+        /* Records are read in place, so the ring is aligned for them. */
+        .Buffer = PushSizeTagged(
+            arena, capacity, _Alignof(undo_record), ALLOCATION_TAG_UNDO
+        ),
+        .Capacity = capacity,
+
+        .Start = 0,
+        .End = 0,
+        .Cursor = 0,
+
+        .Wrapped = false,
+        .Limit = 0,
+
+        .RecordCount = 0,
+        .UndoCount = 0,
+
+        .Sealed = true,
+    };
+}
+
+/**
+ * Drops every record in the journal.
+ *
+ * @param[in|out]	journal	The journal to clear.
+ */
+internal void ClearUndoJournal(undo_journal* journal)
+{
+    journal->Start = 0;
+    journal->End = 0;
+    journal->Cursor = 0;
+
+    journal->Wrapped = false;
+    journal->Limit = 0;
+
+    journal->RecordCount = 0;
+    journal->UndoCount = 0;
+
+    journal->Sealed = true;
+}
+
+/**
+ * Makes the next edit start a new record, rather than being merged into the
+ * last one.
+ *
+ * @param[in|out]	journal	The journal to seal.
+ */
+internal inline void UndoJournalSeal(undo_journal* journal)
+{
+    journal->Sealed = true;
+}
+
+/**
+ * Computes the size of the record for an edit of the given length.
+ *
+ * @param[in]	length	The length of the edit's text.
+ *
+ * @return	The size of the record, in bytes.
+ */
+internal inline size _UndoRecordSize(size length)
+{
+    size paddedLength = (length + (sizeof(u32) - 1)) & ~(sizeof(u32) - 1);
+
+    return sizeof(undo_record) + paddedLength + sizeof(u32);
+}
+
+/**
+ * Finds the record at the given offset.
+ *
+ * @param[in]	journal	The journal the record is in.
+ * @param[in]	offset	The offset of the record.
+ *
+ * @return	A pointer to the record's header. Its text follows it.
+ */
+internal inline undo_record* _UndoRecordAt(undo_journal* journal, size offset)
+{
+    return (undo_record*)&journal->Buffer[offset];
+}
+
+/**
+ * Finds the record that ends at the given offset.
+ *
+ * @param[in]	journal	The journal the record is in.
+ * @param[in]	offset	The offset just past the record.
+ *
+ * @return	The offset of the record.
+ */
+internal size _UndoRecordBefore(undo_journal* journal, size offset)
+{
+    if (offset == 0)
+        offset = journal->Limit;
+
+    u32 length = *(u32*)&journal->Buffer[offset - sizeof(u32)];
+
+    return offset - _UndoRecordSize(length);
+}
+
+/**
+ * Finds the record that starts where the given record ends.
+ *
+ * @param[in]	journal	The journal the record is in.
+ * @param[in]	offset	The offset of the record.
+ *
+ * @return	The offset just past the record.
+ */
+internal size _UndoRecordAfter(undo_journal* journal, size offset)
+{
+    offset += _UndoRecordSize(_UndoRecordAt(journal, offset)->Length);
+
+    if (journal->Wrapped && offset == journal->Limit)
+        offset = 0;
+
+    return offset;
+}
+
+/**
+ * Writes the length at the end of a record, after its length has changed.
+ *
+ * @param[in|out]	journal	The journal the record is in.
+ * @param[in]		offset	The offset of the record.
+ */
+internal inline void _UndoRecordSeal(undo_journal* journal, size offset)
+{
+    undo_record* record = _UndoRecordAt(journal, offset);
+    size recordSize = _UndoRecordSize(record->Length);
+
+    *(u32*)&journal->Buffer[offset + recordSize - sizeof(u32)] = record->Length;
+}
+
+/**
+ * Drops the oldest record from the journal.
+ *
+ * @param[in|out]	journal	The journal to drop the record from.
+ */
+internal void _UndoJournalDropOldest(undo_journal* journal)
+{
+    Assert(0 < journal->UndoCount);
+
+    journal->Start = _UndoRecordAfter(journal, journal->Start);
+    journal->RecordCount--;
+    journal->UndoCount--;
+
+    /* _UndoRecordAfter already moved Start back to 0 if it reached Limit. */
+    if (journal->Wrapped && journal->Start == 0)
+        journal->Wrapped = false;
+
+    if (journal->RecordCount == 0)
+        ClearUndoJournal(journal);
+}
+
+/**
+ * Drops every record after the cursor, as they can't be redone once a new edit
+ * has been made.
+ *
+ * @param[in|out]	journal	The journal to truncate.
+ */
+internal void _UndoJournalTruncate(undo_journal* journal)
+{
+    if (journal->UndoCount == 0)
+    {
+        ClearUndoJournal(journal);
+        return;
+    }
+
+    /*
+        The newer records at the start end at End, so a cursor past it is in
+        the older records at the end, and everything after it is dropped.
+    */
+    if (journal->Wrapped && journal->End < journal->Cursor)
+    {
+        journal->Wrapped = false;
+        journal->Limit = 0;
+    }
+
+    journal->End = journal->Cursor;
+    journal->RecordCount = journal->UndoCount;
+}
+
+/**
+ * Merges an edit into the newest record, if it continues that record's edit
+ * and there is room to grow the record where it is.
+ *
+ * @param[in|out]	journal		The journal to merge the edit into.
+ * @param[in]		edit		The edit to merge.
+ *
+ * @return	True if the edit was merged, false otherwise.
+ */
+internal bool _UndoJournalCoalesce(undo_journal* journal, const undo_edit* edit)
+{
+    if (journal->Sealed || journal->UndoCount == 0)
+        return false;
+
+    size offset = _UndoRecordBefore(journal, journal->Cursor);
+    undo_record* record = _UndoRecordAt(journal, offset);
+
+    if (record->Kind != (u32)edit->Kind
+        || UNDO_COALESCE_LIMIT < record->Length + edit->Length)
+        return false;
+
+    /*
+        Typing runs forward from the end of the last insert. Deleting forward
+        stays at the same position, while deleting backward ends where the last
+        delete started.
+    */
+    bool append;
+    if (edit->Kind == UNDO_EDIT_INSERT)
+    {
+        if (edit->Position != record->Position + record->Length)
+            return false;
+
+        append = true;
+    }
+
+    else if (edit->Position == record->Position)
+        append = true;
+
+    else if (edit->Position + edit->Length == record->Position)
+        append = false;
+
+    else
+        return false;
+
+    /* The record can only grow into free space directly after it. */
+    size newEnd = offset + _UndoRecordSize(record->Length + edit->Length);
+    size room = journal->Wrapped ? journal->Start : journal->Capacity;
+
+    if (journal->Wrapped && journal->Start <= offset)
+        return false;
+
+    if (room < newEnd)
+        return false;
+
+    char* text = (char*)(record + 1);
+
+    if (append)
+    {
+        for (size i = 0; i < edit->Length; i++)
+            text[record->Length + i] = edit->Text[i];
+    }
+
+    else
+    {
+        for (size i = record->Length; 0 < i; i--)
+            text[i - 1 + edit->Length] = text[i - 1];
+
+        for (size i = 0; i < edit->Length; i++)
+            text[i] = edit->Text[i];
+
+        record->Position = (u32)edit->Position;
+    }
+
+    record->Length += (u32)edit->Length;
+    _UndoRecordSeal(journal, offset);
+
+    journal->End = newEnd;
+    journal->Cursor = newEnd;
+
+    return true;
+}
+
+/**
+ * Records an edit, merging it into the last one if it continues it. An edit
+ * too large to ever fit in the journal clears it instead, as the edits before
+ * it can't be undone without undoing it first.
+ *
+ * @param[in|out]	journal	The journal to record the edit in.
+ * @param[in]		edit	The edit that was made.
+ */
+internal void UndoJournalRecord(undo_journal* journal, const undo_edit* edit)
+{
+    if (edit->Length == 0)
+        return;
+
+    _UndoJournalTruncate(journal);
+
+    if (_UndoJournalCoalesce(journal, edit))
+        return;
+
+    size recordSize = _UndoRecordSize(edit->Length);
+    if (journal->Capacity < recordSize)
+    {
+        ClearUndoJournal(journal);
+        return;
+    }
+
+    forever
+    {
+        if (!journal->Wrapped)
+        {
+            if (journal->End + recordSize <= journal->Capacity)
+                break;
+
+            /* There's no room at the end, so start again at the beginning. */
+            journal->Limit = journal->End;
+            journal->End = 0;
+            journal->Wrapped = true;
+        }
+
+        else if (journal->End + recordSize <= journal->Start)
+            break;
+
+        else
+            _UndoJournalDropOldest(journal);
+    }
+
+    size offset = journal->End;
+    undo_record* record = _UndoRecordAt(journal, offset);
+
+    *record = (undo_record){
+        .Kind = edit->Kind,
+        .Position = (u32)edit->Position,
+        .Length = (u32)edit->Length,
+    };
+
+    char* text = (char*)(record + 1);
+    for (size i = 0; i < edit->Length; i++)
+        text[i] = edit->Text[i];
+
+    _UndoRecordSeal(journal, offset);
+
+    journal->End = offset + recordSize;
+    journal->Cursor = journal->End;
+    journal->RecordCount++;
+    journal->UndoCount++;
+
+    journal->Sealed = false;
+}
+
+/**
+ * Reads the edit stored in a record.
+ *
+ * @param[in]	journal	The journal the record is in.
+ * @param[in]	offset	The offset of the record.
+ *
+ * @return	The edit. Its text stays in the journal, so it is only valid until
+ *			the next edit is recorded.
+ */
+internal undo_edit _UndoRecordEdit(undo_journal* journal, size offset)
+{
+    undo_record* record = _UndoRecordAt(journal, offset);
+
+    return (undo_edit){
+        .Kind = record->Kind,
+        .Position = record->Position,
+
+        .Text = (const char*)(record + 1),
+        .Length = record->Length,
+    };
+}
+
+/**
+ * Moves the cursor back over the newest edit that can be undone. The caller
+ * reverses the edit.
+ *
+ * @param[in|out]	journal	The journal to undo from.
+ * @param[out]		edit	The edit to reverse.
+ *
+ * @return	True if there was an edit to undo, false otherwise.
+ */
+internal bool UndoJournalUndo(undo_journal* journal, undo_edit* edit)
+{
+    if (journal->UndoCount == 0)
+        return false;
+
+    journal->Cursor = _UndoRecordBefore(journal, journal->Cursor);
+    journal->UndoCount--;
+    journal->Sealed = true;
+
+    *edit = _UndoRecordEdit(journal, journal->Cursor);
+
+    return true;
+}
+
+/**
+ * Moves the cursor forward over the oldest edit that can be redone. The caller
+ * makes the edit again.
+ *
+ * @param[in|out]	journal	The journal to redo from.
+ * @param[out]		edit	The edit to make again.
+ *
+ * @return	True if there was an edit to redo, false otherwise.
+ */
+internal bool UndoJournalRedo(undo_journal* journal, undo_edit* edit)
+{
+    if (journal->RecordCount <= journal->UndoCount)
+        return false;
+
+    *edit = _UndoRecordEdit(journal, journal->Cursor);
+
+    journal->Cursor = _UndoRecordAfter(journal, journal->Cursor);
+    journal->UndoCount++;
+    journal->Sealed = true;
+
+    return true;
+}
+
+/*
+    END UNDO JOURNAL
+*/
+
+#endif